@@ -18,6 +18,9 @@
  * Modified 2018 - Steve Clarke - PanoManager
  *
  * Changed path names for in-built icons
+ * Tile extension read from the settings (jpg or webp)
+ * Scenes can be listed in APP_DATA with their details in a separate file,
+ * which is loaded when the scene, or a scene linking to it, is viewed
  * Still To Do: Select Icons from pmicons folder based on info from the mtour.js file
  * Still To Do: Interpret starting position
  * Still To Do: Interpret view position after link followed
@@ -81,42 +84,21 @@
   // Initialize viewer.
   var viewer = new Marzipano.Viewer(panoElement, viewerOpts);
 
-  // Create scenes.
-  var scenes = data.scenes.map(function(data) {
-    var source = Marzipano.ImageUrlSource.fromString(
-      data.id + "/{z}/{f}/{y}/{x}.jpg",
-      { cubeMapPreviewUrl: data.id + "/preview.jpg" });
-    var geometry = new Marzipano.CubeGeometry(data.levels);
-
-    var limiter = Marzipano.RectilinearView.limit.traditional(data.faceSize, 100*Math.PI/180, 120*Math.PI/180);
-    var view = new Marzipano.RectilinearView(data.initialViewParameters, limiter);
+  // Tile image format (jpg or webp).
+  var tileExtension = data.settings.tileExtension || "jpg";
 
-    var scene = viewer.createScene({
-      source: source,
-      geometry: geometry,
-      view: view,
-      pinFirstLevel: true
-    });
-
-    // Create link hotspots.
-    data.linkHotspots.forEach(function(hotspot) {
-      var element = createLinkHotspotElement(hotspot);
-      scene.hotspotContainer().createHotspot(element, { yaw: hotspot.yaw, pitch: hotspot.pitch });
-    });
-
-    // Create info hotspots.
-    data.infoHotspots.forEach(function(hotspot) {
-      var element = createInfoHotspotElement(hotspot);
-      scene.hotspotContainer().createHotspot(element, { yaw: hotspot.yaw, pitch: hotspot.pitch });
-    });
-
-    return {
-      data: data,
-      scene: scene,
-      view: view
-    };
+  // Create scenes.  Scenes listed with a file are created when that file has loaded.
+  var scenes = data.scenes.map(function(data) {
+    var scene = { data: data, scene: null, view: null, callbacks: null };
+    if (!data.file) {
+      createScene(scene);
+    }
+    return scene;
   });
 
+  // The scene most recently asked for, which is shown once it has loaded.
+  var requestedScene = null;
+
   // Set up autorotate, if enabled.
   var autorotate = Marzipano.autorotate({
     yawSpeed: 0.03,
@@ -150,7 +132,7 @@
   scenes.forEach(function(scene) {
     var el = document.querySelector('#sceneList .scene[data-id="' + scene.data.id + '"]');
     el.addEventListener('click', function() {
-      switchScene(scene);
+      showScene(scene);
       // On mobile, hide scene list after selecting a scene.
       if (document.body.classList.contains('mobile')) {
         hideSceneList();
@@ -183,6 +165,93 @@
     return s.replace('&', '&amp;').replace('<', '&lt;').replace('>', '&gt;');
   }
 
+  function createScene(scene) {
+    var data = scene.data;
+
+    // Packed tiles for the scene, read by tilepack.js.
+    if (data.tilePack && window.TILE_PACKS) {
+      window.TILE_PACKS[data.id] = data.tilePack;
+    }
+
+    var source = Marzipano.ImageUrlSource.fromString(
+      data.id + "/{z}/{f}/{y}/{x}." + tileExtension,
+      { cubeMapPreviewUrl: data.id + "/preview.jpg" });
+    var geometry = new Marzipano.CubeGeometry(data.levels);
+
+    var limiter = Marzipano.RectilinearView.limit.traditional(data.faceSize, 100*Math.PI/180, 120*Math.PI/180);
+    var view = new Marzipano.RectilinearView(data.initialViewParameters, limiter);
+
+    var marzipanoScene = viewer.createScene({
+      source: source,
+      geometry: geometry,
+      view: view,
+      pinFirstLevel: true
+    });
+
+    // Create link hotspots.
+    data.linkHotspots.forEach(function(hotspot) {
+      var element = createLinkHotspotElement(hotspot);
+      marzipanoScene.hotspotContainer().createHotspot(element, { yaw: hotspot.yaw, pitch: hotspot.pitch });
+    });
+
+    // Create info hotspots.
+    data.infoHotspots.forEach(function(hotspot) {
+      var element = createInfoHotspotElement(hotspot);
+      marzipanoScene.hotspotContainer().createHotspot(element, { yaw: hotspot.yaw, pitch: hotspot.pitch });
+    });
+
+    scene.scene = marzipanoScene;
+    scene.view = view;
+  }
+
+  // Load the scene's file (once), create the scene, then call done.
+  function loadScene(scene, done) {
+    if (scene.scene) {
+      if (done) done(scene);
+      return;
+    }
+    if (scene.callbacks) {
+      if (done) scene.callbacks.push(done);
+      return;
+    }
+
+    scene.callbacks = done ? [ done ] : [];
+    var request = new XMLHttpRequest();
+    request.open('GET', scene.data.file);
+    request.onload = function() {
+      var callbacks = scene.callbacks;
+      scene.callbacks = null;
+      if (request.status < 200 || request.status >= 300) return;
+      scene.data = JSON.parse(request.responseText);
+      createScene(scene);
+      callbacks.forEach(function(callback) {
+        callback(scene);
+      });
+    };
+    request.onerror = function() {
+      // Allow another attempt the next time the scene is asked for
+      scene.callbacks = null;
+    };
+    request.send();
+  }
+
+  // Load the scenes the links lead to, so they're ready before a link is followed.
+  function prefetchLinkedScenes(scene) {
+    scene.data.linkHotspots.forEach(function(hotspot) {
+      var target = findSceneById(hotspot.target);
+      if (target) loadScene(target);
+    });
+  }
+
+  function showScene(scene) {
+    requestedScene = scene;
+    loadScene(scene, function() {
+      if (requestedScene !== scene) return;
+      switchScene(scene);
+      prefetchLinkedScenes(scene);
+    });
+  }
+
   function switchScene(scene) {
     stopAutorotate();
     scene.view.setParameters(scene.data.initialViewParameters);
@@ -275,7 +344,7 @@
 
     // Add click event handler.
     wrapper.addEventListener('click', function() {
-      switchScene(findSceneById(hotspot.target));
+      showScene(findSceneById(hotspot.target));
     });
 
     // Prevent touch and scroll events from reaching the parent element.
@@ -397,6 +466,6 @@
   }
 
   // Display the initial scene.
-  switchScene(scenes[0]);
+  showScene(scenes[0]);
 
 })();
@@ -0,0 +1,116 @@
+/*
+ * PanoManager - Pannellum scene loader
+ *
+ * Starts the tour.  For tours exported with "Load Scenes On Demand", tourdata
+ * only lists the scene files, e.g.
+ *
+ *   var tourdata = {"default":{...},"scenes":{},"sceneFiles":{"Hall":"Hall/scene.json",...}} ;
+ *
+ * and each scene is fetched when it is first needed.  When a scene is shown,
+ * the scenes its links lead to are fetched as well, so they are normally ready
+ * before a link is followed.  Tours with all the scenes in tourdata are passed
+ * straight to pannellum.
+ */
+
+(function() {
+  'use strict';
+
+  function loadJSON(url, done, failed) {
+    var request = new XMLHttpRequest();
+    request.open('GET', url);
+    request.onload = function() {
+      if (request.status < 200 || request.status >= 300) {
+        failed();
+        return;
+      }
+      var json;
+      try { json = JSON.parse(request.responseText); } catch (e) { failed(); return; }
+      done(json);
+    };
+    request.onerror = failed;
+    request.send();
+  }
+
+  window.startTour = function(container, tour) {
+    if (!tour.sceneFiles) return pannellum.viewer(container, tour);
+
+    var viewer = null;
+    var scenes = {};       // Scene id => loaded scene configuration
+    var callbacks = {};    // Scene id => functions waiting for the scene to load
+    var requested = null;  // The scene most recently asked for
+
+    // Fetch a scene (once), then call done with its configuration
+    function loadScene(id, done) {
+      if (scenes[id]) {
+        if (done) done(scenes[id]);
+        return;
+      }
+      if (callbacks[id]) {
+        if (done) callbacks[id].push(done);
+        return;
+      }
+      if (!tour.sceneFiles[id]) return;
+
+      callbacks[id] = done ? [ done ] : [];
+      loadJSON(tour.sceneFiles[id], function(config) {
+        prepareScene(config);
+        scenes[id] = config;
+        if (viewer) viewer.addScene(id, config);
+        var waiting = callbacks[id];
+        delete callbacks[id];
+        waiting.forEach(function(callback) { callback(config); });
+      }, function() {
+        // Allow another attempt the next time the scene is asked for
+        delete callbacks[id];
+      });
+    }
+
+    // Scene links are followed by the loader, so the destination can be fetched first
+    function prepareScene(config) {
+      if (config.tilePack && window.TILE_PACKS) {
+        window.TILE_PACKS[config.multiRes.basePath.replace(/^\.\//, '')] = config.tilePack;
+      }
+      (config.hotSpots || []).forEach(function(hotspot) {
+        if (!hotspot.sceneId) return;
+        var target = hotspot.sceneId;
+        delete hotspot.sceneId;
+        hotspot.cssClass = 'pnlm-hotspot pnlm-sprite pnlm-scene';
+        hotspot.clickHandlerFunc = function() {
+          showScene(target, hotspot.targetPitch, hotspot.targetYaw);
+        };
+        hotspot.linkedScene = target;
+      });
+    }
+
+    function prefetchLinkedScenes(config) {
+      (config.hotSpots || []).forEach(function(hotspot) {
+        if (hotspot.linkedScene) loadScene(hotspot.linkedScene);
+      });
+    }
+
+    function showScene(id, pitch, yaw) {
+      requested = id;
+      loadScene(id, function(config) {
+        if (requested !== id) return;
+        viewer.loadScene(id, pitch, yaw);
+        prefetchLinkedScenes(config);
+      });
+    }
+
+    var first = tour['default'].firstScene || Object.keys(tour.sceneFiles)[0];
+    requested = first;
+    loadScene(first, function(config) {
+      var initial = { 'default': tour['default'], scenes: {} };
+      initial['default'].firstScene = first;
+      initial.scenes[first] = config;
+      viewer = pannellum.viewer(container, initial);
+
+      // Scenes which finished loading before the viewer was created
+      Object.keys(scenes).forEach(function(id) {
+        if (id !== first) viewer.addScene(id, scenes[id]);
+      });
+      prefetchLinkedScenes(config);
+    });
+  };
+
+})();
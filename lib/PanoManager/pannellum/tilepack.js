@@ -0,0 +1,93 @@
+/*
+ * PanoManager - Packed tile loader
+ *
+ * When a tour is exported with "Pack Tiles Into Archive", the tiles for each
+ * scene are written to <scene>/tiles.pack, and the tour configuration defines
+ * TILE_PACKS, giving the offset and length of each tile within the pack:
+ *
+ *   var TILE_PACKS = {"Hall":{"file":"Hall/tiles.pack","tiles":{"1/f/0/0":[24,18211],...}}} ;
+ *
+ * Both Marzipano and Pannellum load tiles by setting the src of an image.  This
+ * shim intercepts those requests, fetches the tile from the pack with an HTTP
+ * range request, and hands the image a blob URL instead.  Requests for files
+ * which are not in a pack (and all requests on browsers without fetch) are
+ * passed through unchanged.
+ *
+ * Must be loaded after the tour configuration, and before the viewer.
+ */
+
+(function() {
+  'use strict';
+
+  var packs = window.TILE_PACKS;
+  if (!packs || !window.fetch || !window.Blob || !window.URL || !URL.createObjectURL) return;
+
+  var srcProperty = Object.getOwnPropertyDescriptor(HTMLImageElement.prototype, 'src');
+  if (!srcProperty || !srcProperty.set || !srcProperty.configurable) return;
+
+  var base = document.baseURI ? document.baseURI.replace(/[?#].*$/, '').replace(/[^\/]*$/, '') : '';
+
+  // Find the pack entry for a tile url, e.g. "./Hall/2/f/1/0.jpg" => Hall, "2/f/1/0"
+  function lookup(url) {
+    var path;
+    try { path = decodeURI(url); } catch (e) { return null; }
+    if (base && path.indexOf(base) === 0) path = path.substr(base.length);
+    path = path.replace(/^\.?\//, '');
+
+    var slash = path.indexOf('/');
+    if (slash < 0) return null;
+    var pack = packs[path.substr(0, slash)];
+    if (!pack) return null;
+
+    var entry = pack.tiles[path.substr(slash + 1).replace(/\.[^\/.]*$/, '')];
+    if (!entry) return null;
+    var type = /\.webp$/i.test(path) ? 'image/webp' : /\.png$/i.test(path) ? 'image/png' : 'image/jpeg';
+    return { file: pack.file, offset: entry[0], length: entry[1], type: type };
+  }
+
+  function setSrc(img, url) {
+    srcProperty.set.call(img, url);
+  }
+
+  Object.defineProperty(HTMLImageElement.prototype, 'src', {
+    configurable: true,
+    enumerable: srcProperty.enumerable,
+    get: srcProperty.get,
+    set: function(url) {
+      var img = this;
+      var tile = (typeof url === 'string') ? lookup(url) : null;
+
+      // Remember the latest request, so a cancelled (or reused) image ignores late results
+      img._tilePackUrl = url;
+      if (!tile) {
+        setSrc(img, url);
+        return;
+      }
+
+      var range = 'bytes=' + tile.offset + '-' + (tile.offset + tile.length - 1);
+      fetch(tile.file, { headers: { 'Range': range } }).then(function(response) {
+        if (!response.ok) throw new Error('Unable to read ' + tile.file);
+        return response.blob().then(function(blob) {
+          // Servers which ignore the range return the whole pack
+          if (response.status !== 206) blob = blob.slice(tile.offset, tile.offset + tile.length);
+          return blob;
+        });
+      }).then(function(blob) {
+        if (img._tilePackUrl !== url) return;
+        var objectUrl = URL.createObjectURL(new Blob([blob], { type: tile.type }));
+        var revoke = function() {
+          img.removeEventListener('load', revoke);
+          img.removeEventListener('error', revoke);
+          URL.revokeObjectURL(objectUrl);
+        };
+        img.addEventListener('load', revoke);
+        img.addEventListener('error', revoke);
+        setSrc(img, objectUrl);
+      })['catch'](function() {
+        // Fall back to the individual tile file, which reports its own load error if missing
+        if (img._tilePackUrl === url) setSrc(img, url);
+      });
+    }
+  });
+
+})();
@@ -0,0 +1,153 @@
+/*
+ * PanoManager - Tour service worker
+ *
+ * Installed by tours exported with "Offline Cache".  When installed, it stores
+ * the files listed in precache-manifest.json (library files, configuration,
+ * the preview and first levels of each scene's tiles), and from then on serves
+ * them from the cache.  Other tiles are stored the first time they are viewed,
+ * so a revisited scene doesn't fetch them again.
+ *
+ * Each file in the manifest has a hash of its contents, which is added to the
+ * cached url, so a changed file is never served from an old entry.  The tour's
+ * html has no hash, and is fetched from the network whenever it's available.
+ *
+ * The worker is registered as tour-sw.js?v=<manifest version>, so each export
+ * which changes any listed file installs a new worker, and the caches of the
+ * previous one are removed.  Range requests (packed tiles) are not cached.
+ */
+
+'use strict';
+
+var VERSION = new URL(self.location).searchParams.get('v') || 'none';
+var PRECACHE = 'pmtour-precache-' + VERSION;
+var RUNTIME = 'pmtour-tiles-' + VERSION;
+var SCOPE = self.registration.scope;
+var MANIFEST = 'precache-manifest.json';
+
+// Files stored at the same time while installing
+var CONCURRENT_REQUESTS = 6;
+
+var manifest = null;   // Path (relative to the tour) => content hash
+
+function cacheUrl(path, hash) {
+  return SCOPE + encodeURI(path) + (hash ? '?v=' + hash : '');
+}
+
+// Store a file, copying it from an earlier version's cache if it is unchanged
+function precache(cache, path, hash) {
+  var url = cacheUrl(path, hash);
+  var cached = hash ? caches.match(url) : Promise.resolve(null);
+  return cached.then(function(response) {
+    if (response) return cache.put(url, response);
+    return fetch(url, { cache: 'no-cache' }).then(function(response) {
+      if (!response.ok) throw new Error('Unable to read ' + path);
+      return cache.put(url, response);
+    });
+  });
+}
+
+function precacheAll(cache, files) {
+  var paths = Object.keys(files);
+  var next = 0;
+  function worker() {
+    if (next >= paths.length) return Promise.resolve();
+    var path = paths[next++];
+    return precache(cache, path, files[path]).then(worker);
+  }
+  var workers = [];
+  for (var i = 0; i < CONCURRENT_REQUESTS; i++) workers.push(worker());
+  return Promise.all(workers);
+}
+
+function loadManifest() {
+  if (manifest) return Promise.resolve(manifest);
+  return caches.open(PRECACHE).then(function(cache) {
+    return cache.match(SCOPE + MANIFEST);
+  }).then(function(response) {
+    if (!response) throw new Error('No precache manifest');
+    return response.json();
+  }).then(function(json) {
+    manifest = json.files;
+    return manifest;
+  });
+}
+
+self.addEventListener('install', function(event) {
+  event.waitUntil(
+    fetch(SCOPE + MANIFEST + '?v=' + VERSION, { cache: 'no-store' }).then(function(response) {
+      if (!response.ok) throw new Error('Unable to read ' + MANIFEST);
+      return response.clone().json().then(function(json) {
+        return caches.open(PRECACHE).then(function(cache) {
+          return precacheAll(cache, json.files).then(function() {
+            manifest = json.files;
+            return cache.put(SCOPE + MANIFEST, response);
+          });
+        });
+      });
+    }).then(function() {
+      return self.skipWaiting();
+    })
+  );
+});
+
+self.addEventListener('activate', function(event) {
+  event.waitUntil(
+    caches.keys().then(function(names) {
+      return Promise.all(names.filter(function(name) {
+        return name.indexOf('pmtour-') === 0 && name !== PRECACHE && name !== RUNTIME;
+      }).map(function(name) {
+        return caches['delete'](name);
+      }));
+    }).then(function() {
+      return self.clients.claim();
+    })
+  );
+});
+
+function cacheFirst(cacheName, url, request) {
+  return caches.open(cacheName).then(function(cache) {
+    return cache.match(url).then(function(cached) {
+      if (cached) return cached;
+      return fetch(request).then(function(response) {
+        if (response.status === 200) cache.put(url, response.clone());
+        return response;
+      });
+    });
+  });
+}
+
+function networkFirst(cacheName, url, request) {
+  return caches.open(cacheName).then(function(cache) {
+    return fetch(request).then(function(response) {
+      if (response.status === 200) cache.put(url, response.clone());
+      return response;
+    }, function() {
+      return cache.match(url).then(function(cached) {
+        if (!cached) throw new Error('Offline, and ' + url + ' is not cached');
+        return cached;
+      });
+    });
+  });
+}
+
+self.addEventListener('fetch', function(event) {
+  var request = event.request;
+  if (request.method !== 'GET' || request.headers.has('range')) return;
+  if (request.url.indexOf(SCOPE) !== 0) return;
+
+  var path = decodeURI(request.url.substr(SCOPE.length).replace(/[?#].*$/, ''));
+
+  event.respondWith(loadManifest().then(function(files) {
+    if (files.hasOwnProperty(path)) {
+      var hash = files[path];
+      return hash ? cacheFirst(PRECACHE, cacheUrl(path, hash), request)
+                  : networkFirst(PRECACHE, cacheUrl(path, ''), request);
+    }
+    if (/\.(jpe?g|webp|png)$/i.test(path)) {
+      return cacheFirst(RUNTIME, request.url, request);
+    }
+    return fetch(request);
+  }, function() {
+    return fetch(request);
+  }));
+});
@@ -4,7 +4,7 @@
 #
 #-------------------------------------------------
 
-QT       += core gui
+QT       += core gui network
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets opengl
 
@@ -17,6 +17,9 @@ TEMPLATE = app
 # deprecated API in order to know how to port your code away from it.
 DEFINES += QT_DEPRECATED_WARNINGS
 
+# Tile JPEG encoding uses libjpeg(-turbo) directly
+LIBS += -ljpeg -lz -lbrotlienc
+
 # You can also make your code fail to compile if you use deprecated APIs.
 # In order to do so, uncomment the following line.
 # You can also select to disable deprecated APIs only up to a certain version of Qt.
@@ -33,33 +36,77 @@ SOURCES += \
         main.cpp \
         mainwindow.cpp \
         mainwindow_export.cpp \
+        cli/commandline.cpp \
+        cli/buildserver.cpp \
+        export/tourexporter.cpp \
+        export/tourimporter.cpp \
+        export/exportjournal.cpp \
+        export/assetcompressor.cpp \
+        export/precachemanifest.cpp \
+        export/exportplanner.cpp \
         project/project.cpp \
+        project/project_binary.cpp \
+        project/project_journal.cpp \
+        project/projectjournal.cpp \
+        project/projecthistory.cpp \
         project/scene.cpp \
         project/node.cpp \
+        project/id.cpp \
         icons/icons.cpp \
         sceneimage/sceneimage.cpp \
         sceneimage/face.cpp \
         sceneimage/maptranslation.cpp \
+        sceneimage/warmcache.cpp \
+        sceneimage/tilededuplicator.cpp \
+        sceneimage/tilepack.cpp \
+        sceneimage/tileencoder.cpp \
+        sceneimage/tilewriter.cpp \
+        sceneimage/facesizing.cpp \
+        sceneimage/equirectsampler.cpp \
         dialogs/progress/progressdialog.cpp \
         dialogs/tourproperties/tourpropertiesdialog.cpp \
         dialogs/about/aboutdialog.cpp \
         dialogs/webserver/webserver.cpp \
-        widgets/sceneview/sceneviewwidget.cpp
+        widgets/sceneview/sceneviewwidget.cpp \
+        widgets/listmodels/scenelistmodel.cpp \
+        widgets/listmodels/nodelistmodel.cpp
 
 HEADERS += \
         mainwindow.h \
+        cli/commandline.h \
+        cli/buildserver.h \
+        export/tourexporter.h \
+        export/tourimporter.h \
+        export/exportjournal.h \
+        export/assetcompressor.h \
+        export/precachemanifest.h \
+        export/exportplanner.h \
         project/project.h \
+        project/projectjournal.h \
+        project/projecthistory.h \
         project/scene.h \
         project/node.h \
+        project/id.h \
+        project/generation.h \
+        project/projectobserver.h \
         icons/icons.h \
         sceneimage/maptranslation.h \
         sceneimage/sceneimage.h \
         sceneimage/face.h \
+        sceneimage/warmcache.h \
+        sceneimage/tilededuplicator.h \
+        sceneimage/tilepack.h \
+        sceneimage/tileencoder.h \
+        sceneimage/tilewriter.h \
+        sceneimage/facesizing.h \
+        sceneimage/equirectsampler.h \
         dialogs/progress/progressdialog.h \
         dialogs/tourproperties/tourpropertiesdialog.h \
         dialogs/about/aboutdialog.h \
         dialogs/webserver/webserver.h \
         widgets/sceneview/sceneviewwidget.h \
+        widgets/listmodels/scenelistmodel.h \
+        widgets/listmodels/nodelistmodel.h \
         errors/pmerrors.h \
         version.h
 
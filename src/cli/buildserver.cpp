@@ -0,0 +1,217 @@
+//    PanoManager - Interactive panorama tour manager program
+//    Copyright (C) 2018  Steve M Clarke
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+//
+// Build Server
+//
+
+#include "buildserver.h"
+#include "commandline.h"
+
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QFileInfo>
+#include <QDir>
+#include <QStringList>
+
+//======================================================================================================================
+//
+// BuildJob
+//
+
+// A path which doesn't exist yet (e.g. a new output folder) can't be made canonical
+static QString canonicalPath(QString path)
+{
+    QFileInfo info(path) ;
+    QString canonical = info.canonicalFilePath() ;
+    return canonical.isEmpty() ? QDir::cleanPath(info.absoluteFilePath()) : canonical ;
+}
+
+BuildJob::BuildJob(int id, QJsonObject request, QString libFolder, QLocalSocket *socket) : QObject(0)
+{
+    m_id = id ;
+    m_request = request ;
+    m_libFolder = libFolder ;
+    m_socket = socket ;
+
+    static const char *keys[] = { "project", "marzipano", "pannellum" } ;
+    for (unsigned int i=0; i<sizeof(keys)/sizeof(keys[0]); i++) {
+        QString path = request.value(keys[i]).toString() ;
+        if (!path.isEmpty()) m_paths.append(canonicalPath(path)) ;
+    }
+
+    // The job is deleted on the server thread, once its last event has been written
+    setAutoDelete(false) ;
+}
+
+QStringList BuildJob::paths()
+{
+    return m_paths ;
+}
+
+void BuildJob::run()
+{
+    CommandLine cli ;
+    cli.setWriteStdout(false) ;
+    cli.setJobId(m_id) ;
+    cli.setProjectFile(m_request.value("project").toString()) ;
+    cli.setBuild(m_request.value("build").toBool(false)) ;
+    cli.setMarzipanoFolder(m_request.value("marzipano").toString()) ;
+    cli.setPannellumFolder(m_request.value("pannellum").toString()) ;
+    cli.setLibraryFolder(m_request.value("library").toString(m_libFolder)) ;
+    cli.setDeduplicateTiles(m_request.value("dedup").toBool(true)) ;
+    cli.setPlan(m_request.value("plan").toBool(false)) ;
+    cli.setPreviewLevels(m_request.value("preview").toInt(0)) ;
+
+    QStringList scenes ;
+    QJsonArray ja_scenes = m_request.value("scenes").toArray() ;
+    for (int i=0; i<ja_scenes.count(); i++) scenes.append(ja_scenes.at(i).toString()) ;
+    cli.setScenes(scenes) ;
+
+    // The job object lives on the server thread, so events are queued back to it
+    connect(&cli, SIGNAL(reportLine(QByteArray)), this, SLOT(handleReportLine(QByteArray)), Qt::QueuedConnection) ;
+    cli.run() ;
+    disconnect(&cli, SIGNAL(reportLine(QByteArray)), this, SLOT(handleReportLine(QByteArray))) ;
+
+    // Queued to the server, after the job's last event
+    emit(finished(this)) ;
+}
+
+void BuildJob::handleReportLine(QByteArray line)
+{
+    if (m_socket && m_socket->state()==QLocalSocket::ConnectedState) {
+        m_socket->write(line) ;
+        m_socket->flush() ;
+    }
+}
+
+//======================================================================================================================
+//
+// BuildServer
+//
+
+BuildServer::BuildServer() : QObject(0)
+{
+    m_nextJob = 1 ;
+    connect(&m_server, SIGNAL(newConnection()), this, SLOT(handleNewConnection())) ;
+}
+
+BuildServer::~BuildServer()
+{
+    qDeleteAll(m_waiting) ;
+    m_waiting.clear() ;
+}
+
+void BuildServer::setLibraryFolder(QString folder)
+{
+    m_libFolder = folder ;
+}
+
+void BuildServer::setThreads(int threads)
+{
+    if (threads>0) m_pool.setMaxThreadCount(threads) ;
+}
+
+bool BuildServer::listen(QString name)
+{
+    // Remove any socket left behind by a server which didn't exit cleanly
+    QLocalServer::removeServer(name) ;
+    return m_server.listen(name) ;
+}
+
+void BuildServer::handleNewConnection()
+{
+    QLocalSocket *socket = m_server.nextPendingConnection() ;
+    while (socket) {
+        connect(socket, SIGNAL(readyRead()), this, SLOT(handleReadyRead())) ;
+        connect(socket, SIGNAL(disconnected()), socket, SLOT(deleteLater())) ;
+        socket = m_server.nextPendingConnection() ;
+    }
+}
+
+void BuildServer::handleReadyRead()
+{
+    QLocalSocket *socket = qobject_cast<QLocalSocket *>(sender()) ;
+    if (!socket) return ;
+
+    while (socket->canReadLine()) {
+
+        QByteArray line = socket->readLine().trimmed() ;
+        if (line.isEmpty()) continue ;
+
+        int id = m_nextJob++ ;
+
+        QJsonParseError parseError ;
+        QJsonDocument doc = QJsonDocument::fromJson(line, &parseError) ;
+
+        if (parseError.error!=QJsonParseError::NoError || !doc.isObject()) {
+            QJsonObject event ;
+            event.insert("event", "done") ;
+            event.insert("job", id) ;
+            event.insert("status", "error") ;
+            event.insert("error", QString("Invalid job request: ") + parseError.errorString()) ;
+            socket->write(QJsonDocument(event).toJson(QJsonDocument::Compact) + QByteArray("\n")) ;
+            continue ;
+        }
+
+        QJsonObject queued ;
+        queued.insert("event", "queued") ;
+        queued.insert("job", id) ;
+        socket->write(QJsonDocument(queued).toJson(QJsonDocument::Compact) + QByteArray("\n")) ;
+
+        BuildJob *job = new BuildJob(id, doc.object(), m_libFolder, socket) ;
+        connect(job, SIGNAL(finished(BuildJob*)), this, SLOT(handleJobFinished(BuildJob*)), Qt::QueuedConnection) ;
+        m_waiting.append(job) ;
+        startJobs() ;
+
+    }
+}
+
+void BuildServer::handleJobFinished(BuildJob *job)
+{
+    QStringList paths = job->paths() ;
+    for (int i=0; i<paths.count(); i++) m_busyPaths.remove(paths.at(i)) ;
+    job->deleteLater() ;
+    startJobs() ;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// startJobs - Start each waiting job whose paths are free.  A job still waiting keeps its
+//             paths from the jobs behind it, so jobs sharing a path run in arrival order.
+//
+
+void BuildServer::startJobs()
+{
+    QSet<QString> reserved = m_busyPaths ;
+    for (int i=0; i<m_waiting.count(); ) {
+
+        BuildJob *job = m_waiting.at(i) ;
+        QStringList paths = job->paths() ;
+
+        bool free = true ;
+        for (int p=0; free && p<paths.count(); p++) free = !reserved.contains(paths.at(p)) ;
+        for (int p=0; p<paths.count(); p++) reserved.insert(paths.at(p)) ;
+
+        if (free) {
+            for (int p=0; p<paths.count(); p++) m_busyPaths.insert(paths.at(p)) ;
+            m_waiting.removeAt(i) ;
+            m_pool.start(job) ;
+        } else {
+            i++ ;
+        }
+    }
+}
@@ -0,0 +1,121 @@
+//    PanoManager - Interactive panorama tour manager program
+//    Copyright (C) 2018  Steve M Clarke
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+//
+// Build Server
+//
+// Long running headless server, which accepts build / export jobs on a local
+// socket, and runs them on a pool of worker threads.  Translation maps and
+// decoded faces are kept in the WarmCache between jobs.
+//
+// Each job is a single line of JSON written to the socket:
+//
+//  {"project":"/tours/house.pmp","build":true,"marzipano":"/www/house",
+//   "pannellum":"/www/house-p","scenes":["Hall","Kitchen"],"library":"/opt/pm/lib","dedup":true,
+//   "plan":true,"preview":2}
+//
+// All fields except project are optional.  The job's progress is streamed back
+// on the same socket as JSON lines (see CommandLine), each tagged with the job
+// number, and ending with a "done" event.
+//
+// Jobs for the same project, or writing to the same output folder, are run in
+// the order they arrived, one at a time, as they would otherwise build the same
+// faces and write the same tiles and journals.  Other jobs run alongside them.
+//
+
+#ifndef BUILDSERVER_H
+#define BUILDSERVER_H
+
+#include <QObject>
+#include <QRunnable>
+#include <QString>
+#include <QByteArray>
+#include <QStringList>
+#include <QList>
+#include <QSet>
+#include <QJsonObject>
+#include <QPointer>
+#include <QThreadPool>
+#include <QLocalServer>
+#include <QLocalSocket>
+
+class BuildJob : public QObject, public QRunnable
+{
+    Q_OBJECT
+
+private:
+    int m_id ;
+    QJsonObject m_request ;
+    QString m_libFolder ;
+    QPointer<QLocalSocket> m_socket ;
+    QStringList m_paths ;
+
+public:
+    BuildJob(int id, QJsonObject request, QString libFolder, QLocalSocket *socket) ;
+
+    // The project file and output folders the job uses, as canonical paths.  They
+    // are found when the job is made, so they're the same once folders are created.
+    QStringList paths() ;
+
+    // Called on a worker thread
+    void run() ;
+
+signals:
+    void finished(BuildJob *job) ;
+
+private slots:
+    void handleReportLine(QByteArray line) ;
+
+};
+
+
+class BuildServer : public QObject
+{
+    Q_OBJECT
+
+private:
+    QLocalServer m_server ;
+    QThreadPool m_pool ;
+    QString m_libFolder ;
+    int m_nextJob ;
+    QSet<QString> m_busyPaths ;         // Paths used by running jobs
+    QList<BuildJob *> m_waiting ;       // Jobs waiting for a path, in arrival order
+
+    void startJobs() ;
+
+public:
+    BuildServer() ;
+    ~BuildServer() ;
+
+private:
+    BuildServer(const BuildServer& other) ;
+    BuildServer& operator=(const BuildServer& rhs) ;
+
+public:
+    void setLibraryFolder(QString folder) ;
+    void setThreads(int threads) ;
+
+    // Start listening on the named local socket, returns false on failure
+    bool listen(QString name) ;
+
+private slots:
+    void handleNewConnection() ;
+    void handleReadyRead() ;
+    void handleJobFinished(BuildJob *job) ;
+
+};
+
+#endif // BUILDSERVER_H
@@ -0,0 +1,333 @@
+//    PanoManager - Interactive panorama tour manager program
+//    Copyright (C) 2018  Steve M Clarke
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+//
+// Command Line (headless) Build and Export
+//
+
+#include "commandline.h"
+
+#include <stdio.h>
+#include <QFileInfo>
+#include <QDir>
+#include <QJsonDocument>
+
+#include "../project/project.h"
+#include "../export/tourexporter.h"
+#include "../export/exportplanner.h"
+#include "../export/tourimporter.h"
+
+CommandLine::CommandLine() : QObject(0)
+{
+    m_build = false ;
+    m_deduplicate = true ;
+    m_plan = false ;
+    m_previewLevels = 0 ;
+    m_writeStdout = true ;
+    m_jobId = 0 ;
+    m_lastPercent = -1 ;
+}
+
+void CommandLine::setProjectFile(QString file) { m_projectFile = file ; }
+void CommandLine::setLibraryFolder(QString folder) { m_libFolder = folder ; }
+void CommandLine::setBuild(bool build) { m_build = build ; }
+void CommandLine::setMarzipanoFolder(QString folder) { m_marzipanoFolder = folder ; }
+void CommandLine::setPannellumFolder(QString folder) { m_pannellumFolder = folder ; }
+void CommandLine::setScenes(QStringList scenes) { m_scenes = scenes ; }
+void CommandLine::setDeduplicateTiles(bool yes) { m_deduplicate = yes ; }
+void CommandLine::setPlan(bool yes) { m_plan = yes ; }
+void CommandLine::setPreviewLevels(int levels) { m_previewLevels = levels ; }
+void CommandLine::setImportFolder(QString folder) { m_importFolder = folder ; }
+void CommandLine::setImportTours(QStringList tours) { m_importTours = tours ; }
+void CommandLine::setWriteStdout(bool yes) { m_writeStdout = yes ; }
+void CommandLine::setJobId(int id) { m_jobId = id ; }
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// report - Write a single event to stdout as a line of compact JSON
+//
+
+void CommandLine::report(QJsonObject event)
+{
+    if (m_jobId>0) event.insert("job", m_jobId) ;
+    QJsonDocument doc(event) ;
+    QByteArray line = doc.toJson(QJsonDocument::Compact) + QByteArray("\n") ;
+    if (m_writeStdout) {
+        fputs(line.constData(), stdout) ;
+        fflush(stdout) ;
+    }
+    emit(reportLine(line)) ;
+}
+
+void CommandLine::finishStage()
+{
+    if (m_stage.isEmpty()) return ;
+    QJsonObject event ;
+    event.insert("event", "stagedone") ;
+    event.insert("step", m_step) ;
+    event.insert("message", m_stage) ;
+    event.insert("ms", (double)m_stageTimer.elapsed()) ;
+    report(event) ;
+    m_stage.clear() ;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// run - Open the project, and perform the build / export steps in order
+//
+
+int CommandLine::run()
+{
+    m_timer.start() ;
+    if (!m_importFolder.isEmpty()) return runImport() ;
+
+    if (m_projectFile.isEmpty() || !QFileInfo(m_projectFile).exists()) {
+        QJsonObject event ;
+        event.insert("event", "done") ;
+        event.insert("status", "error") ;
+        event.insert("error", QString("Project file not found: ") + m_projectFile) ;
+        event.insert("ms", (double)m_timer.elapsed()) ;
+        report(event) ;
+        return 1 ;
+    }
+
+    Project project ;
+    if (!project.OpenProject(QFileInfo(m_projectFile).absoluteFilePath())) {
+        QJsonObject event ;
+        event.insert("event", "done") ;
+        event.insert("status", "error") ;
+        event.insert("error", QString("Unable to read project file: ") + m_projectFile) ;
+        event.insert("ms", (double)m_timer.elapsed()) ;
+        report(event) ;
+        return 1 ;
+    }
+
+    QJsonObject opened ;
+    opened.insert("event", "open") ;
+    opened.insert("project", m_projectFile) ;
+    opened.insert("scenes", project.sceneCount()) ;
+    opened.insert("ms", (double)m_timer.elapsed()) ;
+    report(opened) ;
+
+    TourExporter exporter(&project) ;
+    if (!m_libFolder.isEmpty()) exporter.setLibraryFolder(m_libFolder) ;
+    exporter.setSceneFilter(m_scenes) ;
+    exporter.setDeduplicateTiles(m_deduplicate) ;
+    exporter.setPreviewLevels(m_previewLevels) ;
+
+    if (m_plan) {
+        ExportPlanner planner(&project, &exporter) ;
+        planner.setRebuildStale(m_build) ;
+        planner.plan() ;
+        QJsonObject event ;
+        event.insert("event", "plan") ;
+        event.insert("plan", planner.toJson()) ;
+        event.insert("ms", (double)m_timer.elapsed()) ;
+        report(event) ;
+    }
+
+    connect(&exporter, SIGNAL(stageUpdate(QString)), this, SLOT(handleStageUpdate(QString))) ;
+    connect(&exporter, SIGNAL(progressUpdate(QString)), this, SLOT(handleProgressUpdate(QString))) ;
+    connect(&exporter, SIGNAL(percentUpdate(int)), this, SLOT(handlePercentUpdate(int))) ;
+
+    PM::Err err = PM::Ok ;
+    if (err==PM::Ok && m_build) err = runStep(&exporter, "build", QString()) ;
+    if (err==PM::Ok && !m_marzipanoFolder.isEmpty()) err = runStep(&exporter, "export-marzipano", m_marzipanoFolder) ;
+    if (err==PM::Ok && !m_pannellumFolder.isEmpty()) err = runStep(&exporter, "export-pannellum", m_pannellumFolder) ;
+
+    disconnect(&exporter, SIGNAL(percentUpdate(int)), this, SLOT(handlePercentUpdate(int))) ;
+    disconnect(&exporter, SIGNAL(progressUpdate(QString)), this, SLOT(handleProgressUpdate(QString))) ;
+    disconnect(&exporter, SIGNAL(stageUpdate(QString)), this, SLOT(handleStageUpdate(QString))) ;
+
+    QJsonObject done ;
+    done.insert("event", "done") ;
+    done.insert("status", err==PM::Ok ? "ok" : "error") ;
+    if (err!=PM::Ok) done.insert("error", PM::errString(err)) ;
+    done.insert("ms", (double)m_timer.elapsed()) ;
+    report(done) ;
+
+    return (err==PM::Ok) ? 0 : 1 ;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// runImport - Import each tour into a project of its own.  A tour which fails is reported,
+//             and the rest are still imported.
+//
+
+int CommandLine::runImport()
+{
+    QDir dir ;
+    QString folder = QDir::cleanPath(QFileInfo(m_importFolder).absoluteFilePath()) ;
+    dir.mkpath(folder) ;
+
+    int failed = 0 ;
+    for (int i=0; i<m_importTours.count(); i++) {
+
+        QElapsedTimer tourTimer ;
+        tourTimer.start() ;
+
+        QString tour = QDir::cleanPath(QFileInfo(m_importTours.at(i)).absoluteFilePath()) ;
+        QString name = QFileInfo(tour).fileName() ;
+        QString projectFile = folder + "/" + name + "." + PROJECT_BINARY_SUFFIX ;
+
+        QJsonObject event ;
+        event.insert("event", "import") ;
+        event.insert("tour", m_importTours.at(i)) ;
+        event.insert("project", projectFile) ;
+
+        QString error ;
+        if (!TourImporter::isTour(tour)) {
+            error = PM::errString(PM::TourReadError) ;
+        } else if (QFileInfo(projectFile).exists()) {
+            error = QString("Project file already exists: ") + projectFile ;
+        } else {
+            Project project ;
+            TourImporter importer(&project) ;
+            PM::Err err = importer.importTour(tour, folder + "/" + name) ;
+            if (err!=PM::Ok) error = PM::errString(err) ;
+            else if (importer.scenesImported()==0) error = PM::errString(PM::TourReadError) ;
+            else if (!project.SaveProject(projectFile)) error = QString("Unable to save project file: ") + projectFile ;
+            event.insert("scenes", importer.scenesImported()) ;
+            event.insert("faces", importer.facesAdopted()) ;
+        }
+
+        if (!error.isEmpty()) failed++ ;
+        event.insert("status", error.isEmpty() ? "ok" : "error") ;
+        if (!error.isEmpty()) event.insert("error", error) ;
+        event.insert("ms", (double)tourTimer.elapsed()) ;
+        report(event) ;
+    }
+
+    QJsonObject done ;
+    done.insert("event", "done") ;
+    done.insert("status", failed==0 ? "ok" : "error") ;
+    done.insert("tours", m_importTours.count()) ;
+    done.insert("failed", failed) ;
+    done.insert("ms", (double)m_timer.elapsed()) ;
+    report(done) ;
+
+    return (failed==0) ? 0 : 1 ;
+}
+
+PM::Err CommandLine::runStep(TourExporter *exporter, QString step, QString folder)
+{
+    QElapsedTimer stepTimer ;
+    stepTimer.start() ;
+    m_step = step ;
+    m_lastPercent = -1 ;
+
+    PM::Err err = PM::Ok ;
+    QString error ;
+
+    if (step.compare("build")==0) {
+
+        err = exporter->buildScenes(true) ;
+        if (err!=PM::Ok) error = PM::errString(err) ;
+
+    } else {
+
+        QDir dir ;
+        QString absFolder = QFileInfo(folder).absoluteFilePath() ;
+        dir.mkpath(absFolder) ;
+
+        error = exporter->checkProject(absFolder) ;
+        if (!error.isEmpty()) {
+            err = PM::InputNotDefined ;
+        } else {
+            if (step.compare("export-marzipano")==0) err = exporter->exportMarzipano(absFolder) ;
+            else err = exporter->exportPannellum(absFolder) ;
+            if (err!=PM::Ok) error = PM::errString(err) ;
+        }
+
+    }
+
+    finishStage() ;
+
+    QJsonObject event ;
+    event.insert("event", "stepdone") ;
+    event.insert("step", step) ;
+    event.insert("status", err==PM::Ok ? "ok" : "error") ;
+    if (!error.isEmpty()) event.insert("error", error) ;
+    event.insert("ms", (double)stepTimer.elapsed()) ;
+    if (err==PM::Ok && step.compare("build")!=0) {
+        const TileEncoder& encoder = exporter->encoderStats() ;
+        event.insert("tilesEncoded", encoder.tilesEncoded()) ;
+        event.insert("bytesEncoded", (double)encoder.bytesEncoded()) ;
+        event.insert("encodeMs", (double)encoder.encodeMs()) ;
+        if (encoder.compareTiles()>0) {
+            event.insert("webpSampleTiles", encoder.compareTiles()) ;
+            event.insert("webpSampleBytes", (double)encoder.compareWebpBytes()) ;
+            event.insert("jpegSampleBytes", (double)encoder.compareJpegBytes()) ;
+        }
+        const TileWriter& writer = exporter->writerStats() ;
+        if (writer.tilesWritten()>0) {
+            event.insert("writeMs", (double)writer.writeMs()) ;
+            event.insert("writeKBps", (double)writer.kbPerSecond()) ;
+            event.insert("writeStallMs", (double)writer.stallMs()) ;
+        }
+        if (m_deduplicate) {
+            const TileDeduplicator& stats = exporter->tileStats() ;
+            event.insert("tiles", stats.tilesWritten() + stats.tilesLinked()) ;
+            event.insert("tilesLinked", stats.tilesLinked()) ;
+            event.insert("bytesWritten", (double)stats.bytesWritten()) ;
+            event.insert("bytesSaved", (double)stats.bytesSaved()) ;
+        }
+    }
+    report(event) ;
+
+    return err ;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// Exporter Progress Handlers
+//
+
+void CommandLine::handleStageUpdate(QString message)
+{
+    finishStage() ;
+    m_stage = message ;
+    m_stageTimer.start() ;
+
+    QJsonObject event ;
+    event.insert("event", "stage") ;
+    event.insert("step", m_step) ;
+    event.insert("message", message) ;
+    event.insert("ms", (double)m_timer.elapsed()) ;
+    report(event) ;
+}
+
+void CommandLine::handleProgressUpdate(QString message)
+{
+    QJsonObject event ;
+    event.insert("event", "message") ;
+    event.insert("step", m_step) ;
+    event.insert("message", message) ;
+    report(event) ;
+}
+
+void CommandLine::handlePercentUpdate(int percent)
+{
+    if (percent==m_lastPercent) return ;
+    m_lastPercent = percent ;
+
+    QJsonObject event ;
+    event.insert("event", "progress") ;
+    event.insert("step", m_step) ;
+    event.insert("percent", percent) ;
+    report(event) ;
+}
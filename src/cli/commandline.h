@@ -0,0 +1,134 @@
+//    PanoManager - Interactive panorama tour manager program
+//    Copyright (C) 2018  Steve M Clarke
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+//
+// Command Line (headless) Build and Export
+//
+// Opens a project, builds stale scenes and exports the tour without creating
+// any widgets.  Progress is written to stdout as one JSON object per line:
+//
+//  {"event":"open","project":"...","scenes":12,"ms":35}
+//  {"event":"plan","plan":{"tiles":8064,"bytes":91000000,"ms":62000,"peakMemory":470000000,...},"ms":40}
+//  {"event":"stage","step":"export-marzipano","message":"Exporting Hall","ms":1200}
+//  {"event":"message","step":"export-marzipano","message":"Loading Face: 0"}
+//  {"event":"progress","step":"export-marzipano","percent":42}
+//  {"event":"stagedone","step":"export-marzipano","message":"Exporting Hall","ms":5230}
+//  {"event":"stepdone","step":"export-marzipano","status":"ok","ms":60210,
+//   "tilesEncoded":7020,"bytesEncoded":91552011,"encodeMs":21950,
+//   "writeMs":23104,"writeKBps":3869,"writeStallMs":1240,
+//   "tiles":8064,"tilesLinked":1044,"bytesWritten":91552011,"bytesSaved":5210230}
+//  {"event":"done","status":"ok","ms":61002}
+//
+// Tours whose projects are lost are imported in bulk (see TourImporter), each into
+// <folder>/<tour>.pmb with its scene images in <folder>/<tour>.  An existing
+// project is never overwritten.  One event is reported per tour, then done:
+//
+//  {"event":"import","tour":"...","project":"...","status":"ok","scenes":12,"faces":72,"ms":410}
+//  {"event":"done","status":"ok","tours":1,"failed":0,"ms":415}
+//
+// The plan event is only reported when requested, before any steps are run (see
+// ExportPlanner for its contents).
+//
+// Timings (ms) are durations for stagedone / stepdone / done, and elapsed time
+// since start for all other events.
+//
+// The same events are streamed back to clients of the BuildServer.
+//
+
+#ifndef COMMANDLINE_H
+#define COMMANDLINE_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include "../errors/pmerrors.h"
+
+class TourExporter ;
+
+class CommandLine : public QObject
+{
+    Q_OBJECT
+
+private:
+    QString m_projectFile ;
+    QString m_libFolder ;
+    QString m_marzipanoFolder ;
+    QString m_pannellumFolder ;
+    QStringList m_scenes ;
+    QString m_importFolder ;
+    QStringList m_importTours ;
+    bool m_build ;
+    bool m_deduplicate ;
+    bool m_plan ;
+    int m_previewLevels ;
+    bool m_writeStdout ;
+    int m_jobId ;
+
+    QElapsedTimer m_timer ;
+    QElapsedTimer m_stageTimer ;
+    QString m_step ;
+    QString m_stage ;
+    int m_lastPercent ;
+
+    void report(QJsonObject event) ;
+    void finishStage() ;
+    PM::Err runStep(TourExporter *exporter, QString step, QString folder) ;
+    int runImport() ;
+
+public:
+    CommandLine() ;
+
+private:
+    CommandLine(const CommandLine& other) ;
+    CommandLine& operator=(const CommandLine& rhs) ;
+
+public:
+    void setProjectFile(QString file) ;
+    void setLibraryFolder(QString folder) ;
+    void setBuild(bool build) ;
+    void setMarzipanoFolder(QString folder) ;
+    void setPannellumFolder(QString folder) ;
+    void setScenes(QStringList scenes) ;
+    void setDeduplicateTiles(bool yes) ;
+    void setPlan(bool yes) ;
+    void setPreviewLevels(int levels) ;
+
+    // Import the tours into new projects in folder, rather than opening a project
+    void setImportFolder(QString folder) ;
+    void setImportTours(QStringList tours) ;
+
+    // Events are always emitted with reportLine, and optionally written to stdout.
+    // When a job id is set, it is included in every event.
+    void setWriteStdout(bool yes) ;
+    void setJobId(int id) ;
+
+    // Run the requested steps, returns the process exit code
+    int run() ;
+
+signals:
+    void reportLine(QByteArray line) ;
+
+public slots:
+    void handleStageUpdate(QString message) ;
+    void handleProgressUpdate(QString message) ;
+    void handlePercentUpdate(int percent) ;
+
+};
+
+#endif // COMMANDLINE_H
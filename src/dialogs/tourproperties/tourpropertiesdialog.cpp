@@ -42,15 +42,25 @@ void TourPropertiesDialog::load(Project *proj)
     ui->compass_checkBox->setChecked(proj->compass()) ;
     ui->debug_checkBox->setChecked(proj->debug()) ;
     ui->overwriteLibrary_checkBox->setChecked(proj->overwriteLibrary()) ;
+    ui->packTiles_checkBox->setChecked(proj->packTiles()) ;
+    ui->tileFormat_comboBox->setCurrentIndex(proj->tileFormat().compare("webp")==0 ? 1 : 0) ;
+    ui->jpegQuality_spinBox->setValue(proj->jpegQuality()) ;
+    ui->jpegSubsampling_comboBox->setCurrentIndex(proj->jpeg444() ? 1 : 0) ;
+    ui->jpegOptimize_checkBox->setChecked(proj->jpegOptimize()) ;
+    ui->jpegProgressive_checkBox->setChecked(proj->jpegProgressive()) ;
+    ui->compressAssets_checkBox->setChecked(proj->compressAssets()) ;
+    ui->sceneFiles_checkBox->setChecked(proj->sceneFiles()) ;
+    ui->offlineCache_checkBox->setChecked(proj->offlineCache()) ;
+    ui->faceSizing_comboBox->setCurrentIndex(proj->faceSizing().compare("matched")==0 ? 1 : 0) ;
+    ui->maxFaceSize_spinBox->setValue(proj->maxFaceSize()) ;
     ui->sceneFade_lineEdit->setText(QString::number(proj->sceneFade())) ;
     ui->firstSceneLat_lineEdit->setText(QString::number(proj->startingSceneLat()/1000)) ;
     ui->firstSceneLon_lineEdit->setText(QString::number(proj->startingSceneLon()/1000)) ;
     ui->title_LineEdit->setText(proj->title()) ;
     for (int i=0; i<proj->sceneCount(); i++) {
-        ui->firstScene_comboBox->addItem(proj->sceneAt(i).title(), proj->sceneAt(i).id());
+        ui->firstScene_comboBox->addItem(proj->sceneAt(i).title(), QVariant::fromValue(proj->sceneAt(i).id()));
     }
-    QString id = proj->startingSceneId() ;
-    int idx = ui->firstScene_comboBox->findData(id, Qt::UserRole) ;
+    int idx = ui->firstScene_comboBox->findData(QVariant::fromValue(proj->startingSceneId()), Qt::UserRole) ;
     ui->firstScene_comboBox->setCurrentIndex(idx);
 }
 
@@ -63,9 +73,20 @@ void TourPropertiesDialog::save(Project *proj)
     proj->setCompass(ui->compass_checkBox->isChecked()) ;
     proj->setDebug(ui->debug_checkBox->isChecked()) ;
     proj->setOverwriteLibrary(ui->overwriteLibrary_checkBox->isChecked());
+    proj->setPackTiles(ui->packTiles_checkBox->isChecked()) ;
+    proj->setTileFormat(ui->tileFormat_comboBox->currentIndex()==1 ? QString("webp") : QString("jpg")) ;
+    proj->setJpegQuality(ui->jpegQuality_spinBox->value()) ;
+    proj->setJpeg444(ui->jpegSubsampling_comboBox->currentIndex()==1) ;
+    proj->setJpegOptimize(ui->jpegOptimize_checkBox->isChecked()) ;
+    proj->setJpegProgressive(ui->jpegProgressive_checkBox->isChecked()) ;
+    proj->setCompressAssets(ui->compressAssets_checkBox->isChecked()) ;
+    proj->setSceneFiles(ui->sceneFiles_checkBox->isChecked()) ;
+    proj->setOfflineCache(ui->offlineCache_checkBox->isChecked()) ;
+    proj->setFaceSizing(ui->faceSizing_comboBox->currentIndex()==1 ? QString("matched") : QString("height")) ;
+    proj->setMaxFaceSize(ui->maxFaceSize_spinBox->value()) ;
     proj->setSceneFade(ui->sceneFade_lineEdit->text().toInt());
     proj->setStartingScene(
-                ui->firstScene_comboBox->currentData().toString(),
+                ui->firstScene_comboBox->currentData().value<Id>(),
                 ui->firstSceneLat_lineEdit->text().toInt()*1000,
                 ui->firstSceneLon_lineEdit->text().toInt()*1000) ;
     proj->setTitle(ui->title_LineEdit->text());
@@ -21,7 +21,7 @@
 #ifndef PMERRORS_H
 #define PMERRORS_H
 
-static const char *_pmerrors_errstr[13] = {
+static const char *_pmerrors_errstr[15] = {
     "Success",
     "Insufficient Memory",
     "Invalid Map Translation.  Try manually clearing out ~/.cache/PanoManager",
@@ -34,7 +34,9 @@ static const char *_pmerrors_errstr[13] = {
     "Unable to load Full-Size Face",
     "Unable to load Preview Face",
     "Unable to transfer resource files.  Check they are available in the lib folder",
-    "Operation Cancelled"
+    "Operation Cancelled",
+    "Tile format not supported.  WebP tiles require the Qt image formats plugin",
+    "Unable to read the tour configuration (mtour.js or ptour.js)"
 } ;
 
 
@@ -69,12 +71,18 @@ public:
         UnableToTransferResourceFiles,
 
         // Abort
-        OperationCancelled
+        OperationCancelled,
+
+        // Export configuration
+        UnsupportedTileFormat,
+
+        // Import
+        TourReadError
 
     } Err;
 
     static const char *errString(Err n) {
-        if (n<Ok || n>OperationCancelled) return "" ;
+        if (n<Ok || n>TourReadError) return "" ;
         else return _pmerrors_errstr[(int)n] ;
     }
 };
@@ -0,0 +1,130 @@
+//    PanoManager - Interactive panorama tour manager program
+//    Copyright (C) 2018  Steve M Clarke
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+//
+// Asset Compressor
+//
+
+#include "assetcompressor.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QSaveFile>
+#include <QStringList>
+
+#include <zlib.h>
+#include <brotli/encode.h>
+
+bool AssetCompressor::isCompressible(QString filename)
+{
+    static const QStringList extensions = QStringList() << "html" << "htm" << "js" << "css" <<
+                                                          "json" << "svg" << "txt" << "xml" ;
+    return extensions.contains(QFileInfo(filename).suffix().toLower()) ;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// compressFile - Write the .gz and .br copies of a file
+//
+
+bool AssetCompressor::compressFile(QString filename)
+{
+    QFileInfo source(filename) ;
+    QFileInfo gz(filename + QString(".gz")) ;
+    QFileInfo br(filename + QString(".br")) ;
+
+    // Library files are usually unchanged, so are only compressed once
+    bool gzcurrent = gz.exists() && gz.lastModified() >= source.lastModified() ;
+    bool brcurrent = br.exists() && br.lastModified() >= source.lastModified() ;
+    if (gzcurrent && brcurrent) return true ;
+
+    QFile file(filename) ;
+    if (!file.open(QIODevice::ReadOnly)) return false ;
+    QByteArray data = file.readAll() ;
+    file.close() ;
+
+    QByteArray compressed ;
+    bool success = true ;
+    if (!gzcurrent) {
+        success &= gzip(data, compressed) && writeCopy(gz.filePath(), compressed, data.size()) ;
+    }
+    if (!brcurrent) {
+        success &= brotli(data, compressed) && writeCopy(br.filePath(), compressed, data.size()) ;
+    }
+    return success ;
+}
+
+bool AssetCompressor::writeCopy(QString filename, const QByteArray& compressed, qint64 originalsize)
+{
+    // A copy which isn't smaller is no use, and an old one would be out of date
+    if (compressed.size() >= originalsize) {
+        QFile::remove(filename) ;
+        return true ;
+    }
+
+    QSaveFile file(filename) ;
+    if (!file.open(QIODevice::WriteOnly)) return false ;
+    if (file.write(compressed)!=compressed.size()) {
+        file.cancelWriting() ;
+        return false ;
+    }
+    return file.commit() ;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// gzip / brotli - Compress a buffer
+//
+
+bool AssetCompressor::gzip(const QByteArray& data, QByteArray& compressed)
+{
+    z_stream stream ;
+    stream.zalloc = Z_NULL ;
+    stream.zfree = Z_NULL ;
+    stream.opaque = Z_NULL ;
+
+    // 16 + window bits selects the gzip header, rather than zlib's
+    if (deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, 16 + MAX_WBITS, 9, Z_DEFAULT_STRATEGY)!=Z_OK) {
+        return false ;
+    }
+
+    compressed.resize((int)deflateBound(&stream, data.size())) ;
+    stream.next_in = (Bytef *)data.constData() ;
+    stream.avail_in = data.size() ;
+    stream.next_out = (Bytef *)compressed.data() ;
+    stream.avail_out = compressed.size() ;
+
+    int result = deflate(&stream, Z_FINISH) ;
+    compressed.resize((int)stream.total_out) ;
+    deflateEnd(&stream) ;
+    return result==Z_STREAM_END ;
+}
+
+bool AssetCompressor::brotli(const QByteArray& data, QByteArray& compressed)
+{
+    size_t size = BrotliEncoderMaxCompressedSize(data.size()) ;
+    if (size==0) return false ;
+    compressed.resize((int)size) ;
+
+    if (!BrotliEncoderCompress(BROTLI_MAX_QUALITY, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_TEXT,
+                               data.size(), (const uint8_t *)data.constData(),
+                               &size, (uint8_t *)compressed.data())) {
+        return false ;
+    }
+    compressed.resize((int)size) ;
+    return true ;
+}
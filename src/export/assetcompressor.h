@@ -0,0 +1,52 @@
+//    PanoManager - Interactive panorama tour manager program
+//    Copyright (C) 2018  Steve M Clarke
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+//
+// Asset Compressor
+//
+// Writes gzip (.gz) and brotli (.br) copies of the text files in an exported
+// tour (configuration, html, script and style sheets), so that static web
+// servers configured to serve precompressed files (e.g. nginx gzip_static /
+// brotli_static) can send them without compressing on every request.
+//
+// A compressed copy is only written if it is smaller than the original, and is
+// left alone if it is already newer than the original.
+//
+
+#ifndef ASSETCOMPRESSOR_H
+#define ASSETCOMPRESSOR_H
+
+#include <QString>
+#include <QByteArray>
+
+class AssetCompressor
+{
+public:
+    // Returns true if filename is a text asset worth compressing
+    static bool isCompressible(QString filename) ;
+
+    // Write filename.gz and filename.br.  Returns false if they can't be written.
+    static bool compressFile(QString filename) ;
+
+    // Compress data at the maximum level
+    static bool gzip(const QByteArray& data, QByteArray& compressed) ;
+    static bool brotli(const QByteArray& data, QByteArray& compressed) ;
+
+private:
+    static bool writeCopy(QString filename, const QByteArray& compressed, qint64 originalsize) ;
+};
+
+#endif // ASSETCOMPRESSOR_H
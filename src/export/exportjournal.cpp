@@ -0,0 +1,123 @@
+//    PanoManager - Interactive panorama tour manager program
+//    Copyright (C) 2018  Steve M Clarke
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+//
+// Export Journal
+//
+
+#include "exportjournal.h"
+
+#include <QStringList>
+
+ExportJournal::ExportJournal()
+{
+    m_resumed = 0 ;
+}
+
+ExportJournal::~ExportJournal()
+{
+    close() ;
+}
+
+bool ExportJournal::open(QString filename, QString signature)
+{
+    close() ;
+    m_faces.clear() ;
+    m_scenes.clear() ;
+    m_resumed = 0 ;
+
+    QString header = QString("PMJOURNAL\t1\t") + signature ;
+
+    // Load the entries from a previous run, if it used the same settings
+    m_file.setFileName(filename) ;
+    bool resume = false ;
+    if (m_file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        resume = (QString::fromUtf8(m_file.readLine()).trimmed().compare(header)==0) ;
+        while (resume && !m_file.atEnd()) {
+            QStringList fields = QString::fromUtf8(m_file.readLine()).trimmed().split("\t") ;
+            if (fields.count()==5 && fields.at(0).compare("face")==0) {
+                m_faces.insert(fields.at(1) + "\t" + fields.at(2) + "\t" + fields.at(3) + "\t" + fields.at(4)) ;
+            } else if (fields.count()==5 && fields.at(0).compare("scene")==0) {
+                m_scenes.insert(fields.at(1) + "\t" + fields.at(2),
+                                QPair<int,int>(fields.at(3).toInt(), fields.at(4).toInt())) ;
+            }
+            // Anything else is a partly written line from a crash, and is ignored
+        }
+        m_file.close() ;
+    }
+
+    if (resume) {
+        if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) return false ;
+    } else {
+        if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) return false ;
+        append(header) ;
+    }
+    return true ;
+}
+
+void ExportJournal::close()
+{
+    if (m_file.isOpen()) m_file.close() ;
+}
+
+void ExportJournal::finish()
+{
+    close() ;
+    if (!m_file.fileName().isEmpty()) m_file.remove() ;
+    m_faces.clear() ;
+    m_scenes.clear() ;
+}
+
+void ExportJournal::append(QString line)
+{
+    if (!m_file.isOpen()) return ;
+    m_file.write((line + QString("\n")).toUtf8()) ;
+    m_file.flush() ;
+}
+
+bool ExportJournal::faceDone(QString scene, QString stamp, int level, int face)
+{
+    bool done = m_faces.contains(scene + "\t" + stamp + "\t" + QString::number(level) + "\t" + QString::number(face)) ;
+    if (done) m_resumed++ ;
+    return done ;
+}
+
+bool ExportJournal::sceneDone(QString scene, QString stamp, int *levels, int *cuberesolution)
+{
+    QString key = scene + "\t" + stamp ;
+    if (!m_scenes.contains(key)) return false ;
+    if (levels) *levels = m_scenes.value(key).first ;
+    if (cuberesolution) *cuberesolution = m_scenes.value(key).second ;
+    m_resumed++ ;
+    return true ;
+}
+
+void ExportJournal::markFaceDone(QString scene, QString stamp, int level, int face)
+{
+    m_faces.insert(scene + "\t" + stamp + "\t" + QString::number(level) + "\t" + QString::number(face)) ;
+    append(QString("face\t") + scene + "\t" + stamp + "\t" + QString::number(level) + "\t" + QString::number(face)) ;
+}
+
+void ExportJournal::markSceneDone(QString scene, QString stamp, int levels, int cuberesolution)
+{
+    m_scenes.insert(scene + "\t" + stamp, QPair<int,int>(levels, cuberesolution)) ;
+    append(QString("scene\t") + scene + "\t" + stamp + "\t" + QString::number(levels) + "\t" + QString::number(cuberesolution)) ;
+}
+
+int ExportJournal::resumed()
+{
+    return m_resumed ;
+}
@@ -0,0 +1,81 @@
+//    PanoManager - Interactive panorama tour manager program
+//    Copyright (C) 2018  Steve M Clarke
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+//
+// Export Journal
+//
+// Records which scene faces and levels an export has completed, so that an
+// export which was cancelled or crashed can resume where it stopped.  The
+// journal is a text file in the output folder, with one tab separated entry
+// per line:
+//
+//   PMJOURNAL 1 <settings signature>
+//   face <scene> <stamp> <level> <face>
+//   scene <scene> <stamp> <levels> <cuberesolution>
+//
+// Stamp identifies the version of the scene's faces, so a rebuilt scene is
+// exported again.  If the export settings change, the journal is restarted.
+// The journal is removed once an export completes.
+//
+
+#ifndef EXPORTJOURNAL_H
+#define EXPORTJOURNAL_H
+
+#include <QString>
+#include <QFile>
+#include <QSet>
+#include <QHash>
+#include <QPair>
+
+class ExportJournal
+{
+private:
+    QFile m_file ;
+    QSet<QString> m_faces ;                     // scene stamp level face
+    QHash<QString, QPair<int,int> > m_scenes ;  // scene stamp => levels, cuberesolution
+    int m_resumed ;
+
+    void append(QString line) ;
+
+public:
+    ExportJournal() ;
+    ~ExportJournal() ;
+
+private:
+    ExportJournal(const ExportJournal& other) ;
+    ExportJournal& operator=(const ExportJournal& rhs) ;
+
+public:
+    // Open the journal, loading entries from a previous run with the same signature
+    bool open(QString filename, QString signature) ;
+
+    // Close the journal, keeping it so a later export can resume
+    void close() ;
+
+    // Close and remove the journal, once the export has completed
+    void finish() ;
+
+    bool faceDone(QString scene, QString stamp, int level, int face) ;
+    bool sceneDone(QString scene, QString stamp, int *levels, int *cuberesolution) ;
+
+    void markFaceDone(QString scene, QString stamp, int level, int face) ;
+    void markSceneDone(QString scene, QString stamp, int levels, int cuberesolution) ;
+
+    // Number of faces and scenes skipped because they were already complete
+    int resumed() ;
+};
+
+#endif // EXPORTJOURNAL_H
@@ -0,0 +1,345 @@
+//    PanoManager - Interactive panorama tour manager program
+//    Copyright (C) 2018  Steve M Clarke
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+//
+// Export Planner
+//
+
+#include "exportplanner.h"
+
+#include <QSettings>
+#include <QImageReader>
+#include <QSize>
+#include <QJsonArray>
+
+#include "tourexporter.h"
+
+// Costs used until an export has been measured
+#define EXPORTPLANNER_JPEG_BYTES_PER_TILE 18000
+#define EXPORTPLANNER_JPEG_MS_PER_TILE 4.0
+#define EXPORTPLANNER_WEBP_BYTES_PER_TILE 14000
+#define EXPORTPLANNER_WEBP_MS_PER_TILE 12.0
+#define EXPORTPLANNER_BUILD_MS_PER_MEGAPIXEL 1000.0
+
+// Exports with fewer tiles than this are too dominated by loading faces to calibrate from
+#define EXPORTPLANNER_MIN_CALIBRATION_TILES 64
+
+// Size of the tile encoder's output buffer (see tileencoder.cpp)
+#define EXPORTPLANNER_ENCODER_BUFFER (256*1024)
+
+ExportPlanner::ExportPlanner(Project *project, TourExporter *exporter)
+{
+    m_project = project ;
+    m_exporter = exporter ;
+    m_rebuildStale = false ;
+    m_quality = 0 ;
+    m_tileSize = 0 ;
+    m_writerThreads = 1 ;
+    m_maxInFlight = 1 ;
+    m_calibrated = false ;
+    m_bytesPerTile = 0 ;
+    m_msPerTile = 0 ;
+    m_buildMsPerMegapixel = 0 ;
+    m_tiles = 0 ;
+    m_bytes = 0 ;
+    m_buildMs = 0 ;
+    m_exportMs = 0 ;
+    m_peakMemory = 0 ;
+}
+
+void ExportPlanner::setRebuildStale(bool yes) { m_rebuildStale = yes ; }
+
+int ExportPlanner::tiles() { return m_tiles ; }
+qint64 ExportPlanner::bytes() { return m_bytes ; }
+qint64 ExportPlanner::milliseconds() { return m_buildMs + m_exportMs ; }
+qint64 ExportPlanner::peakMemory() { return m_peakMemory ; }
+bool ExportPlanner::calibrated() { return m_calibrated ; }
+
+QString ExportPlanner::settingsGroup(QString format)
+{
+    return QString("ExportPlanner/") + (format.compare("webp", Qt::CaseInsensitive)==0 ? QString("webp") : QString("jpg")) ;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// plan - Estimate the export of every scene in the project
+//
+
+PM::Err ExportPlanner::plan()
+{
+    if (!m_project || !m_exporter) return PM::InvalidPointer ;
+
+    m_sizing = m_exporter->faceSizing() ;
+    m_tileSize = m_sizing.tileSize() ;
+    m_format = m_project->tileFormat() ;
+    m_quality = m_project->jpegQuality() ;
+    m_writerThreads = m_exporter->writerStats().threads() ;
+    m_maxInFlight = m_exporter->writerStats().maxInFlight() ;
+
+    bool webp = (m_format.compare("webp", Qt::CaseInsensitive)==0) ;
+    QSettings settings("trumpton.org.uk", "panomanager") ;
+    settings.beginGroup(settingsGroup(m_format)) ;
+    m_calibrated = settings.contains("msPerTile") ;
+    m_bytesPerTile = settings.value("bytesPerTile", webp ? EXPORTPLANNER_WEBP_BYTES_PER_TILE : EXPORTPLANNER_JPEG_BYTES_PER_TILE).toDouble() ;
+    m_msPerTile = settings.value("msPerTile", webp ? EXPORTPLANNER_WEBP_MS_PER_TILE : EXPORTPLANNER_JPEG_MS_PER_TILE).toDouble() ;
+    settings.endGroup() ;
+    m_buildMsPerMegapixel = settings.value("ExportPlanner/buildMsPerMegapixel", EXPORTPLANNER_BUILD_MS_PER_MEGAPIXEL).toDouble() ;
+
+    m_scenes.clear() ;
+    m_tiles = 0 ;
+    m_bytes = 0 ;
+    m_buildMs = 0 ;
+    m_exportMs = 0 ;
+    m_peakMemory = 0 ;
+
+    for (int i=0; i<m_project->sceneCount(); i++) {
+        planScene(m_project->sceneAt(i)) ;
+    }
+
+    return PM::Ok ;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// planScene - Mirror the build (SceneImage::buildFaces) and tile export (TourExporter::exportFaces) of a scene
+//
+
+void ExportPlanner::planScene(Scene& scene)
+{
+    ScenePlan sp ;
+    sp.id = scene.titleId() ;
+    sp.title = scene.title() ;
+    sp.exported = m_exporter->sceneSelected(scene) ;
+    sp.build = sp.exported && (!scene.imageFilesExist(true) || (m_rebuildStale && m_exporter->sceneIsStale(scene))) ;
+
+    // Faces are rebuilt by the export if they are not the size the policy gives
+    QSize source = QImageReader(scene.filename()).size() ;
+    int facesize = source.isValid() ? m_sizing.faceSize(source.width(), source.height()) : 0 ;
+    int builtsize = QImageReader(scene.faceFilename(0, true)).size().width() ;
+    if (sp.exported && facesize>0 && builtsize>0 && builtsize!=facesize) sp.build = true ;
+    sp.tiles = 0 ;
+    sp.bytes = 0 ;
+    sp.buildMs = 0 ;
+    sp.exportMs = 0 ;
+    sp.peakMemory = 0 ;
+
+    sp.faceSize = sp.build ? facesize : builtsize ;
+    if (sp.faceSize<=0) sp.faceSize = 0 ;
+
+    // Preview exports sample their levels from the source, without building faces
+    int previewlevels = m_exporter->previewLevels() ;
+    if (previewlevels>0) {
+        sp.build = false ;
+        sp.faceSize = facesize ;
+    }
+
+    if (sp.build && source.isValid()) {
+        qint64 pixels = (qint64)source.width() * source.height() ;
+        sp.buildMs = (qint64)((pixels / 1000000.0) * m_buildMsPerMegapixel) ;
+
+        // The source is upscaled to at most 8192x4096, and each face is generated at 3x its size
+        int scale = 7 ;
+        qint64 scaledwidth, scaledheight ;
+        do {
+            scaledwidth = (qint64)source.width() * scale ;
+            scaledheight = (qint64)source.height() * scale ;
+            scale-- ;
+        } while ((scaledwidth>8192 || scaledheight>4096) && scale>1) ;
+        qint64 scaled = scaledwidth * scaledheight * 4 ;
+        qint64 working = (qint64)facesize * 3 * facesize * 3 * 4 ;
+        qint64 output = (qint64)facesize * facesize * 4 ;
+        sp.peakMemory = qMax(pixels * 4 + scaled, scaled + working + output) ;
+    }
+
+    if (sp.exported && sp.faceSize>0) {
+        int width = sp.faceSize ;
+        int tilesize = (m_tileSize>width) ? width : m_tileSize ;
+        int levels = m_sizing.levels(width) ;
+        if (previewlevels>0) levels = qMin(levels, previewlevels) ;
+        for (int level=1; level<=levels; level++) {
+            int imagesize = m_sizing.levelSize(width, level) ;
+            int across = (imagesize + tilesize - 1) / tilesize ;
+            int tiles = 6 * across * across ;
+            sp.levelTiles.append(tiles) ;
+            sp.tiles += tiles ;
+        }
+        sp.bytes = (qint64)(sp.tiles * m_bytesPerTile) ;
+        sp.exportMs = (qint64)(sp.tiles * m_msPerTile) ;
+
+        // Six faces are loaded, and each is scaled to the level being tiled, while encoded
+        // tiles wait in the writer queue.  Previews hold the source and its halvings, and
+        // six faces the size of the top level.
+        qint64 face = (qint64)width * width * 4 ;
+        qint64 exporting = face * 7 ;
+        if (previewlevels>0) {
+            sp.faceSize = m_sizing.levelSize(width, levels) ;
+            exporting = (qint64)source.width() * source.height() * 4 * 4 / 3 + (qint64)sp.faceSize * sp.faceSize * 4 * 7 ;
+        }
+        exporting += (qint64)(m_maxInFlight * m_bytesPerTile) + EXPORTPLANNER_ENCODER_BUFFER ;
+        sp.peakMemory = qMax(sp.peakMemory, exporting) ;
+    }
+
+    m_tiles += sp.tiles ;
+    m_bytes += sp.bytes ;
+    m_buildMs += sp.buildMs ;
+    m_exportMs += sp.exportMs ;
+    m_peakMemory = qMax(m_peakMemory, sp.peakMemory) ;
+    m_scenes.append(sp) ;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// Plan Output
+//
+
+QJsonObject ExportPlanner::toJson()
+{
+    QJsonObject json ;
+    json.insert("format", m_format) ;
+    json.insert("quality", m_quality) ;
+    json.insert("tileSize", m_tileSize) ;
+    json.insert("calibrated", m_calibrated) ;
+    json.insert("writerThreads", m_writerThreads) ;
+    json.insert("maxInFlight", m_maxInFlight) ;
+    if (m_exporter->previewLevels()>0) json.insert("previewLevels", m_exporter->previewLevels()) ;
+
+    QJsonArray ja_scenes ;
+    for (int i=0; i<m_scenes.count(); i++) {
+        const ScenePlan& sp = m_scenes.at(i) ;
+        QJsonObject jo_scene ;
+        jo_scene.insert("id", sp.id) ;
+        jo_scene.insert("title", sp.title) ;
+        jo_scene.insert("faceSize", sp.faceSize) ;
+        jo_scene.insert("levels", sp.levelTiles.count()) ;
+        QJsonArray ja_levels ;
+        for (int l=0; l<sp.levelTiles.count(); l++) ja_levels.append(sp.levelTiles.at(l)) ;
+        jo_scene.insert("levelTiles", ja_levels) ;
+        jo_scene.insert("tiles", sp.tiles) ;
+        jo_scene.insert("bytes", (double)sp.bytes) ;
+        jo_scene.insert("build", sp.build) ;
+        jo_scene.insert("export", sp.exported) ;
+        jo_scene.insert("ms", (double)(sp.buildMs + sp.exportMs)) ;
+        jo_scene.insert("peakMemory", (double)sp.peakMemory) ;
+        ja_scenes.append(jo_scene) ;
+    }
+    json.insert("scenes", ja_scenes) ;
+
+    json.insert("tiles", m_tiles) ;
+    json.insert("bytes", (double)m_bytes) ;
+    json.insert("buildMs", (double)m_buildMs) ;
+    json.insert("exportMs", (double)m_exportMs) ;
+    json.insert("ms", (double)milliseconds()) ;
+    json.insert("peakMemory", (double)m_peakMemory) ;
+    return json ;
+}
+
+QString ExportPlanner::summary()
+{
+    int builds = 0, exports = 0 ;
+    for (int i=0; i<m_scenes.count(); i++) {
+        if (m_scenes.at(i).build) builds++ ;
+        if (m_scenes.at(i).exported) exports++ ;
+    }
+
+    QString text = QString("Scenes: ") + QString::number(m_scenes.count()) +
+            QString(" (") + QString::number(exports) + QString(" to export, ") +
+            QString::number(builds) + QString(" to build)\n") ;
+    text += QString("Tiles: ") + QString::number(m_tiles) + QString(" ") + m_format.toUpper() + QString("\n") ;
+    text += QString("Expected Size: ") + formatBytes(m_bytes) + QString("\n") ;
+    text += QString("Estimated Time: ") + formatTime(milliseconds()) ;
+    if (m_buildMs>0) text += QString(" (building faces ") + formatTime(m_buildMs) + QString(")") ;
+    text += QString("\n") ;
+    text += QString("Peak Memory: ") + formatBytes(m_peakMemory) + QString(" (") +
+            QString::number(m_writerThreads) + QString(" writer threads, ") +
+            QString::number(m_maxInFlight) + QString(" tiles in flight)\n\n") ;
+    if (m_calibrated) text += QString("Estimates are based on the speed of previous exports.") ;
+    else text += QString("Estimates use default costs until a tour has been exported.") ;
+    return text ;
+}
+
+QString ExportPlanner::sceneDetails()
+{
+    QString text ;
+    for (int i=0; i<m_scenes.count(); i++) {
+        const ScenePlan& sp = m_scenes.at(i) ;
+        text += sp.title + QString(": ") ;
+        if (!sp.exported) {
+            text += QString("not exported\n") ;
+            continue ;
+        }
+        text += QString::number(sp.faceSize) + QString("px faces, ") +
+                QString::number(sp.levelTiles.count()) + QString(" levels, ") +
+                QString::number(sp.tiles) + QString(" tiles, ") +
+                formatBytes(sp.bytes) + QString(", ") + formatTime(sp.buildMs + sp.exportMs) ;
+        if (sp.build) text += QString(" (including build)") ;
+        text += QString("\n") ;
+    }
+    return text ;
+}
+
+QString ExportPlanner::formatBytes(qint64 bytes)
+{
+    if (bytes >= (qint64)1024*1024*1024) return QString::number(bytes / (1024.0*1024.0*1024.0), 'f', 1) + QString(" GB") ;
+    if (bytes >= 1024*1024) return QString::number(bytes / (1024.0*1024.0), 'f', 1) + QString(" MB") ;
+    return QString::number(bytes / 1024) + QString(" KB") ;
+}
+
+QString ExportPlanner::formatTime(qint64 ms)
+{
+    qint64 s = (ms + 500) / 1000 ;
+    if (s >= 3600) return QString::number(s/3600) + QString(" h ") + QString::number((s%3600)/60) + QString(" min") ;
+    if (s >= 60) return QString::number(s/60) + QString(" min ") + QString::number(s%60) + QString(" s") ;
+    return QString::number(s) + QString(" s") ;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// Calibration
+//
+// Each measurement is averaged with the previous one, so a single unusual export
+// (e.g. to a network share) doesn't replace the history
+//
+
+void ExportPlanner::calibrateExport(QString format, int tiles, qint64 bytes, qint64 ms)
+{
+    if (tiles < EXPORTPLANNER_MIN_CALIBRATION_TILES) return ;
+
+    double bytesPerTile = (double)bytes / tiles ;
+    double msPerTile = (double)ms / tiles ;
+
+    QSettings settings("trumpton.org.uk", "panomanager") ;
+    settings.beginGroup(settingsGroup(format)) ;
+    if (settings.contains("msPerTile")) {
+        bytesPerTile = (bytesPerTile + settings.value("bytesPerTile").toDouble()) / 2 ;
+        msPerTile = (msPerTile + settings.value("msPerTile").toDouble()) / 2 ;
+    }
+    settings.setValue("bytesPerTile", bytesPerTile) ;
+    settings.setValue("msPerTile", msPerTile) ;
+    settings.endGroup() ;
+}
+
+void ExportPlanner::calibrateBuild(qint64 pixels, qint64 ms)
+{
+    if (pixels<=0 || ms<=0) return ;
+
+    double msPerMegapixel = ms / (pixels / 1000000.0) ;
+
+    QSettings settings("trumpton.org.uk", "panomanager") ;
+    if (settings.contains("ExportPlanner/buildMsPerMegapixel")) {
+        msPerMegapixel = (msPerMegapixel + settings.value("ExportPlanner/buildMsPerMegapixel").toDouble()) / 2 ;
+    }
+    settings.setValue("ExportPlanner/buildMsPerMegapixel", msPerMegapixel) ;
+}
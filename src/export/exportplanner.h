@@ -0,0 +1,129 @@
+//    PanoManager - Interactive panorama tour manager program
+//    Copyright (C) 2018  Steve M Clarke
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+//
+// Export Planner
+//
+// Estimates what an export will produce before it is started: the tiles and
+// bytes each scene will write, how long the build and export will take, and
+// the peak memory used while doing so.
+//
+// Times and sizes are predicted from per-tile costs measured by earlier
+// exports (and a per-megapixel cost for building faces), which are kept in
+// the application settings for each tile format.  Until an export has been
+// run, conservative defaults are used.  The plan is available as text for
+// the main window, and as JSON for the command line:
+//
+//  {"format":"jpg","quality":75,"tileSize":256,"calibrated":true,
+//   "writerThreads":4,"maxInFlight":64,"scenes":[{"id":"Hall","title":"Hall",
+//   "faceSize":2560,"levels":5,"levelTiles":[6,24,54,150,600],"tiles":834,
+//   "bytes":15012000,"build":false,"export":true,"ms":3336,"peakMemory":184000000}],
+//   "tiles":834,"bytes":15012000,"buildMs":0,"exportMs":3336,"ms":3336,
+//   "peakMemory":184000000}
+//
+
+#ifndef EXPORTPLANNER_H
+#define EXPORTPLANNER_H
+
+#include <QString>
+#include <QList>
+#include <QJsonObject>
+#include "../project/project.h"
+#include "../errors/pmerrors.h"
+#include "../sceneimage/facesizing.h"
+
+class TourExporter ;
+
+class ExportPlanner
+{
+private:
+    typedef struct {
+        QString id ;
+        QString title ;
+        int faceSize ;
+        QList<int> levelTiles ;
+        int tiles ;
+        qint64 bytes ;
+        bool build ;               // Faces are missing or stale, so are built first
+        bool exported ;            // False if excluded by the scene filter
+        qint64 buildMs ;
+        qint64 exportMs ;
+        qint64 peakMemory ;
+    } ScenePlan ;
+
+    Project *m_project ;
+    TourExporter *m_exporter ;
+    bool m_rebuildStale ;
+
+    FaceSizing m_sizing ;
+    QString m_format ;
+    int m_quality ;
+    int m_tileSize ;
+    int m_writerThreads ;
+    int m_maxInFlight ;
+
+    // Calibrated costs
+    bool m_calibrated ;
+    double m_bytesPerTile ;
+    double m_msPerTile ;
+    double m_buildMsPerMegapixel ;
+
+    QList<ScenePlan> m_scenes ;
+    int m_tiles ;
+    qint64 m_bytes ;
+    qint64 m_buildMs ;
+    qint64 m_exportMs ;
+    qint64 m_peakMemory ;
+
+    void planScene(Scene& scene) ;
+    static QString settingsGroup(QString format) ;
+
+public:
+    ExportPlanner(Project *project, TourExporter *exporter) ;
+
+private:
+    ExportPlanner(const ExportPlanner& other) ;
+    ExportPlanner& operator=(const ExportPlanner& rhs) ;
+
+public:
+    // Include scenes whose faces are older than their source in the build (as buildScenes(true) does)
+    void setRebuildStale(bool yes) ;
+
+    // Plan an export of the project's scenes, using the exporter's scene filter.
+    // Returns PM::InvalidPointer if there is no project.
+    PM::Err plan() ;
+
+    int tiles() ;
+    qint64 bytes() ;
+    qint64 milliseconds() ;
+    qint64 peakMemory() ;
+    bool calibrated() ;
+
+    QJsonObject toJson() ;
+
+    // A short summary, and a line per scene
+    QString summary() ;
+    QString sceneDetails() ;
+
+    // Record the costs measured by an export / build, for future plans
+    static void calibrateExport(QString format, int tiles, qint64 bytes, qint64 ms) ;
+    static void calibrateBuild(qint64 pixels, qint64 ms) ;
+
+    static QString formatBytes(qint64 bytes) ;
+    static QString formatTime(qint64 ms) ;
+};
+
+#endif // EXPORTPLANNER_H
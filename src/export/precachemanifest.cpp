@@ -0,0 +1,95 @@
+//    PanoManager - Interactive panorama tour manager program
+//    Copyright (C) 2018  Steve M Clarke
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+//
+// Precache Manifest
+//
+
+#include "precachemanifest.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDirIterator>
+#include <QSaveFile>
+#include <QCryptographicHash>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+// Hex digits of the SHA-1 kept, which is plenty to tell versions of a file apart
+#define PRECACHE_HASH_LENGTH 16
+
+PrecacheManifest::PrecacheManifest(QString root)
+{
+    m_root = root ;
+}
+
+QString PrecacheManifest::fileHash(QString filename)
+{
+    QFile file(filename) ;
+    if (!file.open(QIODevice::ReadOnly)) return QString() ;
+    QCryptographicHash hash(QCryptographicHash::Sha1) ;
+    if (!hash.addData(&file)) return QString() ;
+    return QString::fromLatin1(hash.result().toHex().left(PRECACHE_HASH_LENGTH)) ;
+}
+
+void PrecacheManifest::addFile(QString file)
+{
+    QString hash = fileHash(m_root + QString("/") + file) ;
+    if (!hash.isEmpty()) m_files.insert(file, hash) ;
+}
+
+void PrecacheManifest::addPage(QString file)
+{
+    m_files.insert(file, QString()) ;
+}
+
+void PrecacheManifest::addFolder(QString folder)
+{
+    QDir root(m_root) ;
+    QDirIterator it(m_root + QString("/") + folder, QDir::Files, QDirIterator::Subdirectories) ;
+    while (it.hasNext()) {
+        addFile(root.relativeFilePath(it.next())) ;
+    }
+}
+
+QString PrecacheManifest::version()
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1) ;
+    QMap<QString, QString>::const_iterator it ;
+    for (it = m_files.constBegin(); it != m_files.constEnd(); ++it) {
+        hash.addData((it.key() + QString("\t") + it.value() + QString("\n")).toUtf8()) ;
+    }
+    return QString::fromLatin1(hash.result().toHex().left(PRECACHE_HASH_LENGTH)) ;
+}
+
+bool PrecacheManifest::write(QString filename)
+{
+    QJsonObject jo_files ;
+    QMap<QString, QString>::const_iterator it ;
+    for (it = m_files.constBegin(); it != m_files.constEnd(); ++it) {
+        jo_files.insert(it.key(), it.value()) ;
+    }
+
+    QJsonObject jo_manifest ;
+    jo_manifest.insert("version", version()) ;
+    jo_manifest.insert("files", jo_files) ;
+
+    QSaveFile file(filename) ;
+    if (!file.open(QIODevice::WriteOnly)) return false ;
+    file.write(QJsonDocument(jo_manifest).toJson(QJsonDocument::Compact)) ;
+    return file.commit() ;
+}
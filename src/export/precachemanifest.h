@@ -0,0 +1,71 @@
+//    PanoManager - Interactive panorama tour manager program
+//    Copyright (C) 2018  Steve M Clarke
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+//
+// Precache Manifest
+//
+// Lists the files a tour's service worker (tour-sw.js) stores when it is
+// installed, so that revisits (e.g. kiosks) and offline viewing are served
+// from the browser's cache.  Each file is listed with a hash of its contents,
+// which the service worker adds to the request, so a changed file is never
+// served from an old cache entry:
+//
+//   {"version":"3f7a...","files":{"mtour.js":"9c1e...","Hall/1/f/0/0.jpg":"04bd...",
+//    "mtour.html":""}}
+//
+// Files listed without a hash (the tour's html) are always fetched from the
+// network when it is available.  The version is a hash of the whole list.
+//
+
+#ifndef PRECACHEMANIFEST_H
+#define PRECACHEMANIFEST_H
+
+#include <QString>
+#include <QStringList>
+#include <QMap>
+
+class PrecacheManifest
+{
+private:
+    QString m_root ;
+    QMap<QString, QString> m_files ;   // Path relative to root => content hash
+
+public:
+    explicit PrecacheManifest(QString root) ;
+
+private:
+    PrecacheManifest(const PrecacheManifest& other) ;
+    PrecacheManifest& operator=(const PrecacheManifest& rhs) ;
+
+public:
+    // Add a file, relative to the root, if it exists
+    void addFile(QString file) ;
+
+    // Add a file which is always fetched when online, so has no hash (and may not be written yet)
+    void addPage(QString file) ;
+
+    // Add every file in a folder (relative to the root), and its sub folders
+    void addFolder(QString folder) ;
+
+    // Hash of the files and their hashes, which changes when any of them do
+    QString version() ;
+
+    bool write(QString filename) ;
+
+    static QString fileHash(QString filename) ;
+};
+
+#endif // PRECACHEMANIFEST_H
@@ -0,0 +1,1180 @@
+//    PanoManager - Interactive panorama tour manager program
+//    Copyright (C) 2018  Steve M Clarke
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+//
+// Tour Exporter
+//
+
+#include "tourexporter.h"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QSaveFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QDir>
+#include <QImage>
+#include <QImageReader>
+#include <QStringList>
+#include <QtCore/qmath.h>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+
+#include "../sceneimage/sceneimage.h"
+#include "../sceneimage/tilepack.h"
+#include "../sceneimage/equirectsampler.h"
+#include "assetcompressor.h"
+#include "precachemanifest.h"
+#include "exportplanner.h"
+#include "../icons/icons.h"
+
+// Tile levels of each scene stored by the service worker when a tour is first visited
+#define PRECACHE_TILE_LEVELS 2
+
+// Tile size used by both exporters
+#define TILE_RESOLUTION 256
+
+TourExporter::TourExporter(Project *project) : QObject(0)
+{
+    m_abort = false ;
+    m_project = project ;
+    m_libFolder = defaultLibraryFolder() ;
+    m_deduplicate = true ;
+    m_previewLevels = 0 ;
+    m_progressPos = 0 ;
+    m_progressMax = 1 ;
+    m_exportBuildMs = 0 ;
+}
+
+QString TourExporter::defaultLibraryFolder()
+{
+    QFileInfo exe(QCoreApplication::applicationFilePath()) ;
+    return exe.absolutePath() + QString("/../lib/PanoManager") ;
+}
+
+void TourExporter::setLibraryFolder(QString folder)
+{
+    m_libFolder = folder ;
+}
+
+QString TourExporter::libraryFolder()
+{
+    return m_libFolder ;
+}
+
+void TourExporter::setSceneFilter(QStringList scenes)
+{
+    m_sceneFilter = scenes ;
+}
+
+bool TourExporter::sceneSelected(Scene& scene)
+{
+    if (m_sceneFilter.isEmpty()) return true ;
+    return m_sceneFilter.contains(scene.id().toString()) || m_sceneFilter.contains(scene.title()) ;
+}
+
+void TourExporter::setDeduplicateTiles(bool yes)
+{
+    m_deduplicate = yes ;
+}
+
+bool TourExporter::deduplicateTiles()
+{
+    return m_deduplicate ;
+}
+
+void TourExporter::setPreviewLevels(int levels)
+{
+    m_previewLevels = (levels>0) ? levels : 0 ;
+}
+
+int TourExporter::previewLevels()
+{
+    return m_previewLevels ;
+}
+
+const TileDeduplicator& TourExporter::tileStats()
+{
+    return m_dedup ;
+}
+
+const TileEncoder& TourExporter::encoderStats()
+{
+    return m_encoder ;
+}
+
+const TileWriter& TourExporter::writerStats()
+{
+    return m_writer ;
+}
+
+QString TourExporter::tileSummary()
+{
+    QString summary = QString("Tiles encoded: ") + QString::number(m_encoder.tilesEncoded()) +
+            QString(" (") + QString::number(m_encoder.bytesEncoded()/1024) + QString(" KB in ") +
+            QString::number(m_encoder.encodeMs()) + QString(" ms)") ;
+    if (m_encoder.compareTiles()>0 && m_encoder.compareJpegBytes()>0) {
+        qint64 saving = ((m_encoder.compareJpegBytes() - m_encoder.compareWebpBytes()) * 100) / m_encoder.compareJpegBytes() ;
+        summary += QString(", WebP ") + QString::number(saving) + QString("% smaller than JPEG (") +
+                QString::number(m_encoder.compareTiles()) + QString(" tiles sampled)") ;
+    }
+    if (m_writer.tilesWritten()>0) {
+        summary += QString(", written: ") + QString::number(m_writer.bytesWritten()/1024) + QString(" KB at ") +
+                QString::number(m_writer.kbPerSecond()) + QString(" KB/s (encoder waited ") +
+                QString::number(m_writer.stallMs()) + QString(" ms)") ;
+    }
+    if (m_deduplicate) {
+        summary += QString(", duplicates linked: ") + QString::number(m_dedup.tilesLinked()) +
+                QString(" (") + QString::number(m_dedup.bytesSaved()/1024) + QString(" KB saved)") ;
+    }
+    return summary ;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// startExport - Reset the per export state, and configure the tile encoder from the project
+//
+
+void TourExporter::startExport()
+{
+    m_dedup.clear() ;
+    m_tilePacks = QJsonObject() ;
+
+    m_writer.clearStats() ;
+    m_encoder.clearStats() ;
+    m_encoder.setQuality(m_project->jpegQuality()) ;
+    m_encoder.setSubsampling(m_project->jpeg444() ? TileEncoder::Subsample444 : TileEncoder::Subsample420) ;
+    m_encoder.setOptimize(m_project->jpegOptimize()) ;
+    m_encoder.setProgressive(m_project->jpegProgressive()) ;
+
+    m_exportBuildMs = 0 ;
+    m_exportTimer.start() ;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// calibratePlanner - Record the cost of the tiles just exported, excluding any faces built along the way
+//
+
+void TourExporter::calibratePlanner(QString tileformat)
+{
+    ExportPlanner::calibrateExport(tileformat, m_encoder.tilesEncoded(), m_encoder.bytesEncoded(),
+                                   m_exportTimer.elapsed() - m_exportBuildMs) ;
+}
+
+//======================================================================================================================
+//
+// Progress Reporting
+//
+// startProgress     - Reset progress, and set the maximum number of units
+// setProgressDelta  - Report progress as the saved position + delta
+// addProgress       - Move the saved position on by delta
+//
+
+void TourExporter::startProgress(int max)
+{
+    m_progressPos = 0 ;
+    m_progressMax = (max>0) ? max : 1 ;
+    emit(percentUpdate(0)) ;
+}
+
+void TourExporter::setProgressDelta(int delta)
+{
+    emit(percentUpdate(((m_progressPos + delta) * 100) / m_progressMax)) ;
+}
+
+void TourExporter::addProgress(int delta)
+{
+    m_progressPos += delta ;
+    emit(percentUpdate((m_progressPos * 100) / m_progressMax)) ;
+}
+
+void TourExporter::handleProgressUpdate(QString message)
+{
+    emit(progressUpdate(message)) ;
+}
+
+void TourExporter::handleBuildPercentUpdate(int percent)
+{
+    setProgressDelta(percent) ;
+}
+
+void TourExporter::handleAbort()
+{
+    m_abort = true ;
+    emit(abort()) ;
+}
+
+//======================================================================================================================
+//
+// Scene Build
+//
+// sceneIsStale  - Check if the high resolution faces need (re)building
+// buildScenes   - Build the high resolution faces
+//
+
+FaceSizing TourExporter::faceSizing()
+{
+    return faceSizing(m_project) ;
+}
+
+FaceSizing TourExporter::faceSizing(Project *project)
+{
+    if (!project) return FaceSizing() ;
+    return FaceSizing(FaceSizing::policyFromString(project->faceSizing()), TILE_RESOLUTION, project->maxFaceSize()) ;
+}
+
+bool TourExporter::sceneIsStale(Scene& scene)
+{
+    if (!scene.imageFilesExist(true)) return true ;
+
+    QDateTime sourceModified = QFileInfo(scene.filename()).lastModified() ;
+    for (int f=0; f<6; f++) {
+        if (QFileInfo(scene.faceFilename(f, true)).lastModified() < sourceModified) return true ;
+    }
+
+    // Faces built with a different size policy
+    int facesize = faceSizing().faceSize(scene.filename()) ;
+    if (facesize>0 && QImageReader(scene.faceFilename(0, true)).size().width()!=facesize) return true ;
+
+    return false ;
+}
+
+PM::Err TourExporter::buildScenes(bool rebuildOutdated)
+{
+    if (!m_project) return PM::InvalidPointer ;
+
+    PM::Err err = PM::Ok ;
+    m_abort = false ;
+
+    int n = m_project->sceneCount() ;
+    startProgress(n*100) ;
+
+    for (int i=0; err==PM::Ok && i<n; i++) {
+
+        Scene& scene = m_project->sceneAt(i) ;
+        if (!sceneSelected(scene)) {
+            addProgress(100) ;
+            continue ;
+        }
+
+        // Out of date faces are removed, so that loadImage rebuilds them
+        if (rebuildOutdated && scene.imageFilesExist(true) && sceneIsStale(scene)) {
+            for (int f=0; f<6; f++) QFile::remove(scene.faceFilename(f, true)) ;
+        }
+
+        if (!scene.imageFilesExist(true)) {
+
+            emit(stageUpdate(QString("Building Scene: ") + scene.title())) ;
+
+            SceneImage img ;
+            img.setFaceSizing(faceSizing()) ;
+            connect(&img, SIGNAL(progressUpdate(QString)), this, SLOT(handleProgressUpdate(QString))) ;
+            connect(&img, SIGNAL(percentUpdate(int)), this, SLOT(handleBuildPercentUpdate(int))) ;
+            connect(this, SIGNAL(abort()), &img, SLOT(handleAbort())) ;
+            QElapsedTimer buildTimer ;
+            buildTimer.start() ;
+            err = img.loadImage(scene.filename(), false, false, true, true) ;
+            if (err==PM::Ok) {
+                QSize source = QImageReader(scene.filename()).size() ;
+                ExportPlanner::calibrateBuild((qint64)source.width() * source.height(), buildTimer.elapsed()) ;
+            }
+            disconnect(this, SIGNAL(abort()), &img, SLOT(handleAbort())) ;
+            disconnect(&img, SIGNAL(percentUpdate(int)), this, SLOT(handleBuildPercentUpdate(int))) ;
+            disconnect(&img, SIGNAL(progressUpdate(QString)), this, SLOT(handleProgressUpdate(QString))) ;
+
+        }
+
+        if (err==PM::Ok && m_abort) err = PM::OperationCancelled ;
+        addProgress(100) ;
+    }
+
+    return err ;
+}
+
+//======================================================================================================================
+//
+// Export
+//
+// exportMarzipano    - Export to Marzipano
+// exportPannellum    - Export to Panellum
+// exportFaces        - Create the face fragments
+//
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// exportMarzipano
+//
+
+PM::Err TourExporter::exportMarzipano(QString dir)
+{
+    static int exportpreviewsequence[6] = { 2, 5, 0, 3, 1, 4 } ;
+    int tileresolution = TILE_RESOLUTION ;
+    FaceSizing sizing = faceSizing() ;
+
+    if (!m_project) return PM::InvalidPointer ;
+    if (dir.isEmpty()) return PM::OutputNotDefined ;
+
+    Project& project = *m_project ;
+    QString libFolder = m_libFolder + QString("/marzipano") ;
+    QString tileformat = project.tileFormat() ;
+    QStringList masks = tileMasks(tileformat) ;
+    if (!TileEncoder::formatSupported(tileformat)) return PM::UnsupportedTileFormat ;
+
+    PM::Err err = PM::Ok ;
+    m_abort = false ;
+    startExport() ;
+    // Without its journal, an interrupted export couldn't be resumed, and the folder can't be written anyway
+    if (!m_journal.open(dir + QString("/.marzipano.journal"), journalSignature(tileresolution))) return PM::OutputWriteError ;
+    startProgress(200+project.sceneCount()*100) ;
+
+    QJsonObject json ;
+    QString marzlist = "" ;
+    QStringList sceneFiles ;
+
+    // Title & Initial scene
+    json.insert("name", project.title()) ;
+    json.insert("initialscene", project.scene(project.startingSceneId()).titleId());
+
+    // Default Section
+    QJsonObject jo_settings ;
+    jo_settings.insert("mouseViewMode", "drag") ;
+    jo_settings.insert("autorotateEnabled", false) ;
+    jo_settings.insert("fullscreenButton", true) ;
+    jo_settings.insert("viewControlButtons", true) ;
+    jo_settings.insert("tileExtension", tileformat) ;
+    json.insert("settings", jo_settings) ;
+
+    QJsonArray ja_scenes ;
+
+    for (int i=0; err==PM::Ok && i<project.sceneCount(); i++) {
+
+        Scene& scene = project.sceneAt(i) ;
+        emit(stageUpdate(QString("Exporting ") + scene.title())) ;
+        int levels, cuberesolution ;
+        err = exportFaces(scene, tileresolution, masks, dir + QString("/") + scene.titleId(), &levels, &cuberesolution, 256, exportpreviewsequence) ;
+
+        // List for the html file
+        marzlist = marzlist + QString("<a href='#' class='scene' data-id='") +
+                scene.titleId() +
+                QString("'><li class='text'>") +
+                scene.title() +
+                QString("</li></a>\n") ;
+
+        QJsonObject jo_scene ;
+        jo_scene.insert("id", scene.titleId()) ;
+        jo_scene.insert("name", scene.title()) ;
+        jo_scene.insert("faceSize", cuberesolution) ;
+
+        QJsonArray ja_levels ;
+        for (int l=0; l<levels; l++) {
+            QJsonObject jo_level ;
+            jo_level.insert("tileSize", tileresolution) ;
+            jo_level.insert("size", sizing.levelSize(cuberesolution, l+1)) ;
+            ja_levels.append(jo_level) ;
+            if (l==0) ja_levels.append(jo_level) ; // First level needs repeating for marzipano
+        }
+        jo_scene.insert("levels", ja_levels) ;
+
+        // initial view when scene opened without link
+        QJsonObject jo_initialView ;
+        jo_initialView.insert("yaw", 0) ;
+        jo_initialView.insert("pitch", 0) ;
+        jo_initialView.insert("fov", 1.2) ;
+        jo_scene.insert("initialViewParameters", jo_initialView) ;
+
+        QJsonArray ja_links ;
+        QJsonArray ja_info ;
+
+        for (int h=0; h<scene.nodeCount(); h++) {
+
+            const Node& node = scene.constNodeAt(h) ;
+
+            QJsonObject jo_node ;
+            jo_node.insert("yaw", (node.lon() * 3.141592654*2)/360000) ;
+            jo_node.insert("pitch", ((node.lat() * 3.141592654)/180000) * -1) ;
+            jo_node.insert("icon", QString("pmicons/") + Icon::uprightIconName(node.type()) + QString(".png")) ;
+            jo_node.insert("rotation", (Icon::textureOrientation(node.type())*3.141592654*2)/360) ;
+            jo_node.insert("title", node.title()) ;
+
+            if (node.isInfo()) {
+
+                jo_node.insert("text", node.description().replace("\n","br/>")) ;
+                ja_info.append(jo_node) ;
+
+            } else if (node.isLink()) {
+
+                Scene& dest = project.scene(node.destId()) ;
+
+                jo_node.insert("target", dest.titleId()) ;
+
+                // Initial view when link followed
+                QJsonObject jo_destView ;
+                jo_destView.insert("yaw", (node.arrivalLon() * 3.141592654*2)/360000) ;
+                jo_destView.insert("pitch", (node.arrivalLat() * 3.141592654)/180000) ;
+                jo_destView.insert("fov", 1.2) ;
+                jo_node.insert("initialViewParameters", jo_destView) ;
+
+                QJsonObject jo_options ;
+                jo_options.insert("transitionDuration", 2000) ;
+                jo_node.insert("options", jo_options) ;
+
+                ja_links.append(jo_node) ;
+            }
+
+        }
+
+        jo_scene.insert("linkHotspots", ja_links) ;
+        jo_scene.insert("infoHotspots", ja_info) ;
+
+        if (err==PM::Ok && project.sceneFiles()) {
+            // The index only lists the scene, mindex.js loads the rest when it's needed
+            QString file ;
+            if (!writeSceneFile(dir, scene, jo_scene, &file)) err = PM::OutputWriteError ;
+            sceneFiles.append(file) ;
+            QJsonObject jo_entry ;
+            jo_entry.insert("id", scene.titleId()) ;
+            jo_entry.insert("name", scene.title()) ;
+            jo_entry.insert("file", file) ;
+            ja_scenes.append(jo_entry) ;
+        } else {
+            ja_scenes.append(jo_scene) ;
+        }
+
+        addProgress(100) ;
+
+    }
+    json.insert("scenes", ja_scenes) ;
+    if (err==PM::Ok && m_previewLevels==0) calibratePlanner(tileformat) ;
+    if (err==PM::Ok) emit(progressUpdate(tileSummary())) ;
+    if (err==PM::Ok && m_journal.resumed()>0) {
+        emit(progressUpdate(QString("Resumed previous export, skipping ") + QString::number(m_journal.resumed()) +
+                            QString(" completed scenes / faces"))) ;
+    }
+
+    if (err==PM::Ok) {
+        // Write the configuration file
+        emit(stageUpdate("Saving Tour Configuration")) ;
+        QJsonDocument doc ;
+        doc.setObject(json);
+        QFile configoutput(dir + "/mtour.js") ;
+        configoutput.open(QIODevice::WriteOnly | QIODevice::Text) ;
+        configoutput.write(QString("var APP_DATA = ").toLatin1()) ;
+        configoutput.write(doc.toJson(project.compressAssets() ? QJsonDocument::Compact : QJsonDocument::Indented)) ;
+        configoutput.write(tilePacksScript()) ;
+        configoutput.close() ;
+        addProgress(100) ;
+    }
+
+    if (err==PM::Ok) {
+        // Write the Marzipano Supporting Files
+        emit(stageUpdate("Saving Marzipano Files")) ;
+        if (!copyResourceFolder(libFolder, dir, project.overwriteLibrary()))
+            err=PM::UnableToTransferResourceFiles ;
+    }
+
+    if (err==PM::Ok) {
+        // Write the Marzipano Supporting Files
+        emit(stageUpdate("Saving Custom Icons")) ;
+        if (!copyResourceIcons(dir + QString("/pmicons"), 256, true)) {
+            err=PM::UnableToTransferResourceFiles ;
+        }
+    }
+
+    QString serviceworker ;
+    if (err==PM::Ok && project.offlineCache()) {
+        emit(stageUpdate("Saving Offline Cache Manifest")) ;
+        serviceworker = writePrecacheManifest(dir, libFolder, QStringList() << "mtour.js" << sceneFiles, QString("mtour.html")) ;
+        if (serviceworker.isEmpty()) err=PM::OutputWriteError ;
+    }
+
+    if (err==PM::Ok) {
+        // mtour.html is a special case file, where $TITLE$, $MPSCENESLIST$ and $SERVICEWORKER$ are parsed
+        QFile htmlin(libFolder + QString("/mtour.html")) ;
+        htmlin.open(QIODevice::ReadOnly) ;
+        QString htmldata(htmlin.readAll()) ;
+        htmlin.close() ;
+        QFile htmlout(dir + QString("/mtour.html")) ;
+        htmlout.open(QIODevice::WriteOnly) ;
+        if (!htmlout.write(htmldata.replace("$MPSCENESLIST$", marzlist).replace("$TITLE$",project.title()).
+                           replace("$SERVICEWORKER$", serviceworker).toLatin1())>0) {
+            err=PM::UnableToTransferResourceFiles ;
+        }
+        htmlout.close() ;
+        addProgress(100) ;
+    }
+
+    if (err==PM::Ok && project.compressAssets()) {
+        emit(stageUpdate("Compressing Text Files")) ;
+        if (!compressTextFiles(libFolder, dir, QStringList() << "mtour.js" << "mtour.html" << sceneFiles << "precache-manifest.json"))
+            err=PM::OutputWriteError ;
+    }
+
+    // A completed export doesn't need resuming, an incomplete one keeps its journal
+    if (err==PM::Ok) m_journal.finish() ;
+    else m_journal.close() ;
+
+    return err ;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// exportPannellum
+//
+
+PM::Err TourExporter::exportPannellum(QString dir)
+{
+    static int exportpreviewsequence[6] = { 2, 5, 0, 3, 1, 4 } ;
+    int tileresolution = TILE_RESOLUTION ;
+
+    if (!m_project) return PM::InvalidPointer ;
+    if (dir.isEmpty()) return PM::OutputNotDefined ;
+
+    Project& project = *m_project ;
+    QString libFolder = m_libFolder + QString("/pannellum") ;
+    QString tileformat = project.tileFormat() ;
+    QStringList masks = tileMasks(tileformat) ;
+    if (!TileEncoder::formatSupported(tileformat)) return PM::UnsupportedTileFormat ;
+
+    PM::Err err = PM::Ok ;
+    m_abort = false ;
+    startExport() ;
+    if (!m_journal.open(dir + QString("/.pannellum.journal"), journalSignature(tileresolution))) return PM::OutputWriteError ;
+    startProgress(200+project.sceneCount()*100) ;
+
+    QJsonObject json ;
+
+    // Default Section
+
+    QJsonObject jo_default ;
+    if (!project.title().isEmpty()) jo_default.insert("title", project.author()) ;
+    if (!project.author().isEmpty()) jo_default.insert("author", project.author()) ;
+    if (!project.startingSceneId().isNull()) {
+        jo_default.insert("firstScene", project.scene(project.startingSceneId()).titleId()) ;
+        jo_default.insert("pitch", project.startingSceneLat()/1000.0) ;
+        jo_default.insert("yaw", project.startingSceneLon()/1000.0) ;
+    }
+    if (project.sceneFade()>=0) jo_default.insert("sceneFadeDuration", project.sceneFade()) ;
+    jo_default.insert("compass", project.compass()) ;
+    jo_default.insert("autoLoad", project.autoLoad()) ;
+    if (project.autoRotate()>=0) jo_default.insert("autoRotateInactivityDelay", project.autoRotate()) ;
+    jo_default.insert("hotSpotDebug", project.debug()) ;
+    json.insert("default", jo_default) ;
+
+    // Scenes Section
+
+    QJsonObject jo_scenes ;
+    QJsonObject jo_sceneFiles ;
+    QStringList sceneFiles ;
+
+    for (int i=0; err==PM::Ok && i<project.sceneCount(); i++) {
+
+        Scene& scene = project.sceneAt(i) ;
+        emit(stageUpdate(QString("Exporting ") + scene.title())) ;
+
+        int levels, cuberesolution ;
+        err = exportFaces(scene, tileresolution, masks, dir + QString("/") + scene.titleId(), &levels, &cuberesolution, 256, exportpreviewsequence) ;
+
+        QJsonObject jo_scene ;
+        jo_scene.insert("northoffset", scene.northOffset()/1000) ;
+        jo_scene.insert("title", scene.title()) ;
+        jo_scene.insert("preview", QString("/1/f/0/0.") + tileformat) ;
+        jo_scene.insert("type", "multires") ;
+
+        QJsonObject jo_multires ;
+        jo_multires.insert("basePath", QString("./") + scene.titleId()) ;
+        jo_multires.insert("path", "/%l/%s/%y/%x") ;
+        jo_multires.insert("fallbackPath", "/1/%s/%y/%x") ;
+        jo_multires.insert("tileResolution", tileresolution) ;
+        jo_multires.insert("maxLevel", levels) ;
+        jo_multires.insert("extension", tileformat) ;
+        jo_multires.insert("cubeResolution", cuberesolution) ;
+        jo_scene.insert("multiRes", jo_multires) ;
+
+        // Hotspots within a scene
+
+        QJsonArray ja_hotspots ;
+        for (int j=0; j<scene.nodeCount(); j++) {
+
+            const Node& node = scene.constNodeAt(j) ;
+            QJsonObject jo_hotspot ;
+            jo_hotspot.insert("pitch", node.lat()/1000.0) ;
+            jo_hotspot.insert("yaw", node.lon()/1000.0) ;
+
+            if (node.isLink()) {
+
+                jo_hotspot.insert("type", "scene") ;
+                jo_hotspot.insert("text", node.title()) ;
+                jo_hotspot.insert("sceneId", project.scene(node.destId()).titleId()) ;
+                jo_hotspot.insert("targetPitch", node.arrivalLat()/1000.0) ;
+                jo_hotspot.insert("targetYaw", node.arrivalLon()/1000.0) ;
+
+            } else if (node.isInfo() || node.isMedia() || node.isMusic()){
+
+                jo_hotspot.insert("type", "info") ;
+                QString title = node.title() ;
+                if (!node.description().isEmpty()) title = title + QString(" - ") + node.description() ;
+                jo_hotspot.insert("text", node.title() + QString(" ") + node.description()) ;
+                if (!node.url().isEmpty()) { jo_hotspot.insert("URL", node.url()) ; }
+
+            }
+
+            ja_hotspots.append(jo_hotspot) ;
+        }
+        jo_scene.insert("hotSpots", ja_hotspots) ;
+
+        if (err==PM::Ok && project.sceneFiles()) {
+            // sceneloader.js loads the scene when it, or a scene linking to it, is viewed
+            QString file ;
+            if (!writeSceneFile(dir, scene, jo_scene, &file)) err = PM::OutputWriteError ;
+            sceneFiles.append(file) ;
+            jo_sceneFiles.insert(scene.titleId(), file) ;
+        } else {
+            jo_scenes.insert(scene.titleId(), jo_scene) ;
+        }
+
+        addProgress(100) ;
+
+    }
+
+    json.insert("scenes", jo_scenes) ;
+    if (project.sceneFiles()) json.insert("sceneFiles", jo_sceneFiles) ;
+    if (err==PM::Ok && m_previewLevels==0) calibratePlanner(tileformat) ;
+    if (err==PM::Ok) emit(progressUpdate(tileSummary())) ;
+    if (err==PM::Ok && m_journal.resumed()>0) {
+        emit(progressUpdate(QString("Resumed previous export, skipping ") + QString::number(m_journal.resumed()) +
+                            QString(" completed scenes / faces"))) ;
+    }
+
+
+    if (err==PM::Ok) {
+        // Write the configuration file
+        emit(stageUpdate("Saving Tour Configuration")) ;
+        QJsonDocument doc ;
+        doc.setObject(json);
+        QFile configoutput(dir + "/ptour.js") ;
+        configoutput.open(QIODevice::WriteOnly | QIODevice::Text) ;
+        configoutput.write(QString("var tourdata = ").toLatin1()) ;
+        configoutput.write(doc.toJson(project.compressAssets() ? QJsonDocument::Compact : QJsonDocument::Indented)) ;
+        configoutput.write(tilePacksScript()) ;
+        configoutput.close() ;
+        addProgress(100) ;
+    }
+
+    if (err==PM::Ok) {
+        // Write the Panellum Supporting Files
+        emit(stageUpdate("Saving Panellum Files")) ;
+        if (!copyResourceFolder(libFolder, dir, project.overwriteLibrary()))
+            err=PM::UnableToTransferResourceFiles ;
+    }
+
+    QString serviceworker ;
+    if (err==PM::Ok && project.offlineCache()) {
+        emit(stageUpdate("Saving Offline Cache Manifest")) ;
+        serviceworker = writePrecacheManifest(dir, libFolder, QStringList() << "ptour.js" << sceneFiles, QString("ptour.html")) ;
+        if (serviceworker.isEmpty()) err=PM::OutputWriteError ;
+    }
+
+    if (err==PM::Ok) {
+        // ptour.html is a special case file, where $TITLE$ and $SERVICEWORKER$ are parsed
+        QFile htmlin(libFolder + QString("/ptour.html")) ;
+        htmlin.open(QIODevice::ReadOnly) ;
+        QString htmldata(htmlin.readAll()) ;
+        htmlin.close() ;
+        QFile htmlout(dir + QString("/ptour.html")) ;
+        htmlout.open(QIODevice::WriteOnly) ;
+        if (!(htmlout.write(htmldata.replace("$TITLE$",project.title()).
+                            replace("$SERVICEWORKER$", serviceworker).toLatin1())>0)) {
+            err=PM::UnableToTransferResourceFiles ;
+        }
+        htmlout.close() ;
+        addProgress(100) ;
+    }
+
+    if (err==PM::Ok && project.compressAssets()) {
+        emit(stageUpdate("Compressing Text Files")) ;
+        if (!compressTextFiles(libFolder, dir, QStringList() << "ptour.js" << "ptour.html" << sceneFiles << "precache-manifest.json"))
+            err=PM::OutputWriteError ;
+    }
+
+    // A completed export doesn't need resuming, an incomplete one keeps its journal
+    if (err==PM::Ok) m_journal.finish() ;
+    else m_journal.close() ;
+
+    return err ;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// copyResourceIcons
+//
+
+bool TourExporter::copyResourceIcons(QString destfolder, int size, bool ignorerotated)
+{
+    bool success=true ;
+    QDir icondir ;
+    icondir.mkpath(destfolder) ;
+    for (int i=(int)Icon::WInfo; i<=(int)Icon::BMusic; i++) {
+        if (Icon::textureOrientation((Icon::IconType)i)==0 || !ignorerotated) {
+            QImage icon(Icon::textureFile((Icon::IconType)i)) ;
+            success &= icon.scaled(size, size).
+                    save(destfolder +
+                         QString("/") +
+                         Icon::name((Icon::IconType)i) +
+                        QString(".png")) ;
+    }
+    }
+    return success ;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// copyResourceFolder
+//
+
+QStringList TourExporter::resourceFiles(QString source)
+{
+    QFile config(source + "/files.lst") ;
+    config.open(QIODevice::ReadOnly) ;
+    QString fileData(config.readAll()) ;
+    config.close() ;
+    return fileData.replace("\r","\n").replace("\n\n","\n").split("\n") ;
+}
+
+bool TourExporter::copyResourceFolder(QString source, QString dest, bool forceOverwrite)
+{
+    bool success = true ;
+    QDir d ;
+    d.mkdir(dest) ;
+
+    QStringList files = resourceFiles(source) ;
+
+    if (files.isEmpty()) success = false ;
+
+    foreach (QString file, files) {
+
+        if (!file.isEmpty()) {
+            success &= copyFile(source + QString("/") + file, dest + QString("/") + file, forceOverwrite) ;
+        }
+    }
+
+    return success ;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// compressTextFiles - Write .gz and .br copies of the library's text files, and the generated files
+//
+
+bool TourExporter::compressTextFiles(QString source, QString dest, QStringList generated)
+{
+    bool success = true ;
+    QStringList files = resourceFiles(source) + generated ;
+    files.removeDuplicates() ;
+
+    foreach (QString file, files) {
+        if (!file.isEmpty() && AssetCompressor::isCompressible(file)) {
+            success &= AssetCompressor::compressFile(dest + QString("/") + file) ;
+        }
+    }
+
+    return success ;
+}
+
+bool TourExporter::copyFile(QString source, QString dest, bool forceOverwrite)
+{
+    if (!QFile::exists(dest) || forceOverwrite) {
+        QFile::remove(dest) ;
+        QFileInfo fi(dest) ;
+        QString folder = fi.absolutePath() ;
+        QDir dir ;
+        dir.mkpath(folder) ;
+        return QFile::copy(source, dest) ;
+    } else {
+        return true ;
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// journalSignature - Settings which must match for an export to resume from a journal
+// faceStamp        - Identifies the version of a scene's faces
+//
+
+QString TourExporter::journalSignature(int tilesize)
+{
+    Project& project = *m_project ;
+    return project.tileFormat() + QString(" q") + QString::number(project.jpegQuality()) +
+            (project.jpeg444() ? QString(" 444") : QString(" 420")) +
+            (project.jpegOptimize() ? QString(" opt") : QString("")) +
+            (project.jpegProgressive() ? QString(" prog") : QString("")) +
+            (project.packTiles() ? QString(" pack") : QString("")) +
+            (m_deduplicate ? QString(" dedup") : QString("")) +
+            (m_previewLevels>0 ? QString(" preview") + QString::number(m_previewLevels) : QString("")) +
+            QString(" t") + QString::number(tilesize) +
+            QString(" ") + project.faceSizing() + QString::number(project.maxFaceSize()) ;
+}
+
+QString TourExporter::faceStamp(Scene& scene)
+{
+    QFileInfo face(scene.faceFilename(0, true)) ;
+    if (!face.exists()) return QString("none") ;
+    return QString::number(face.lastModified().toMSecsSinceEpoch()) + QString("-") + QString::number(face.size()) ;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// tileMasks - Tile filename masks for each face, in the order f, r, b, l, u, d
+//
+
+QStringList TourExporter::tileMasks(QString extension)
+{
+    static const char *faces[] = { "f", "r", "b", "l", "u", "d" } ;
+    QStringList masks ;
+    for (int f=0; f<6; f++) masks.append(QString(faces[f]) + QString("/%y/%x.") + extension) ;
+    return masks ;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// tilePacksScript - Pack indexes for the tour configuration file, read by tilepack.js
+//
+
+QByteArray TourExporter::tilePacksScript()
+{
+    if (m_tilePacks.isEmpty()) return QByteArray() ;
+
+    // With a file per scene, each scene's pack index is in its file, and is added when it loads
+    if (m_project->sceneFiles()) return QByteArray("\nvar TILE_PACKS = {} ;\n") ;
+
+    QJsonDocument doc(m_tilePacks) ;
+    return QByteArray("\nvar TILE_PACKS = ") + doc.toJson(QJsonDocument::Compact) + QByteArray(" ;\n") ;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// checkProject - Check scene names are unique and all required fields are filled in
+//
+
+QString TourExporter::checkProject(QString dir)
+{
+    if (!m_project) return QString("No Project Loaded") ;
+    Project& project = *m_project ;
+
+    if (dir.isEmpty()) {
+        // Error, output folder not specified
+        return QString("Output Folder Not Defined.  Please configure in Tour/Properties") ;
+    }
+
+    for (int i=0; i<project.sceneCount(); i++) {
+        QString name = project.sceneAt(i).titleId() ;
+        int matches=0 ;
+        for (int j=0; j<project.sceneCount(); j++) {
+            if (project.sceneAt(j).titleId().compare(name)==0) {
+                matches++ ;
+            }
+        }
+        if (matches!=1) {
+            return QString("The follwing scene name exists multiple times: ") + project.sceneAt(i).title() ;
+        }
+    }
+
+    if (project.title().isEmpty()) {
+        return QString("Tour Title Not Defined.  Please configure in Tour/Properties") ;
+    }
+
+    if (!project.scene(project.startingSceneId()).isValid()) {
+        return QString("Invalid Starting Scene.  Please configure in Tour/Properties") ;
+    }
+
+    return QString("") ;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// exportFaces - Perform the export
+//
+
+PM::Err TourExporter::exportFaces(Scene& scene, int tilesize, QStringList masks, QString folder, int *levels, int *cuberesolution, int previewwidth, int *previewsequence)
+{
+    SceneImage sceneimg ;
+    if (!levels || !cuberesolution) return PM::InvalidPointer ;
+
+    setProgressDelta(0) ;
+
+    // Packed tiles are referenced from the tour configuration relative to the tour folder
+    QString sceneFolder = QFileInfo(folder).fileName() ;
+    QString packFile = folder + QString("/tiles.pack") ;
+    QString packName = sceneFolder + QString("/tiles.pack") ;
+
+    if (m_previewLevels>0) {
+        return exportSampledFaces(scene, tilesize, masks, folder, levels, cuberesolution, previewwidth, previewsequence) ;
+    }
+
+    FaceSizing sizing = faceSizing() ;
+
+    if (!sceneSelected(scene)) {
+        // Tiles are not re-exported, but the tour still needs the face size and levels
+        int width = QImageReader(scene.faceFilename(0, true)).size().width() ;
+        if (width<=0) return PM::FaceLoadError ;
+        *cuberesolution = width ;
+        *levels = sizing.levels(width) ;
+        if (m_project->packTiles()) {
+            QJsonObject jo_pack = TilePack::readIndex(packFile, packName) ;
+            if (!jo_pack.isEmpty()) m_tilePacks.insert(sceneFolder, jo_pack) ;
+        }
+        setProgressDelta(100) ;
+        return PM::Ok ;
+    }
+
+    // Scenes completed by an earlier, interrupted export are not exported again
+    QString stamp = faceStamp(scene) ;
+    if (m_journal.sceneDone(sceneFolder, stamp, levels, cuberesolution)) {
+        if (m_project->packTiles()) {
+            QJsonObject jo_pack = TilePack::readIndex(packFile, packName) ;
+            if (!jo_pack.isEmpty()) m_tilePacks.insert(sceneFolder, jo_pack) ;
+        }
+        setProgressDelta(100) ;
+        return PM::Ok ;
+    }
+
+    connect(&sceneimg, SIGNAL(progressUpdate(QString)), this, SLOT(handleProgressUpdate(QString))) ;
+    connect(this, SIGNAL(abort()), &sceneimg, SLOT(handleAbort())) ;
+
+    // Faces built with a different size policy are rebuilt, so the tiles match the configuration
+    int facesize = sizing.faceSize(scene.filename()) ;
+    if (facesize>0 && scene.imageFilesExist(true) && QImageReader(scene.faceFilename(0, true)).size().width()!=facesize) {
+        for (int f=0; f<6; f++) QFile::remove(scene.faceFilename(f, true)) ;
+    }
+
+    // Load the high resolution version of the image, building the faces if they are missing
+    sceneimg.setFaceSizing(sizing) ;
+    bool building = !scene.imageFilesExist(true) ;
+    QElapsedTimer loadTimer ;
+    loadTimer.start() ;
+    PM::Err err = sceneimg.loadImage(scene.filename(), false, false, false, false) ;
+    if (building) m_exportBuildMs += loadTimer.elapsed() ;
+
+    if (err==PM::Ok) {
+
+        setProgressDelta(50) ;
+
+        int width = sceneimg.getFace(0).width() ;
+
+        // The faces may have just been built
+        stamp = faceStamp(scene) ;
+
+        TilePack pack ;
+        TilePack *packptr = NULL ;
+        if (m_project->packTiles()) {
+            if (!pack.open(packFile, folder)) err = PM::OutputWriteError ;
+            packptr = &pack ;
+        }
+
+        // Levels halve from the face size, down to a single tile
+        int res=0 ;
+        int numlevels = sizing.levels(width) ;
+        if (tilesize>width) tilesize=width ;
+        while ( err==PM::Ok && res<numlevels) {
+            int imagesize = sizing.levelSize(width, res+1) ;
+            QList<int> exported ;
+            for (int f=0; err==PM::Ok && f<6; f++) {
+                QString filename = folder + QString("/") + QString::number(res+1) ;
+                QString mask = masks.at(f) ;
+                // Packs are written whole, so only loose tiles are resumed face by face
+                if (!packptr && m_journal.faceDone(sceneFolder, stamp, res+1, f)) continue ;
+                connect(this, SIGNAL(abort()), &sceneimg.getFace(f), SLOT(handleAbort())) ;
+                err = sceneimg.getFace(f).exportTiles(imagesize, tilesize, filename, mask, m_deduplicate ? &m_dedup : NULL,
+                                                      packptr, &m_encoder, packptr ? NULL : &m_writer) ;
+                disconnect(this, SIGNAL(abort()), &sceneimg.getFace(f), SLOT(handleAbort())) ;
+                if (err==PM::Ok) exported.append(f) ;
+                setProgressDelta((f*100)/6) ;
+            }
+
+            // Faces are only journalled once their tiles have reached the disk
+            if (!m_writer.finish() && err==PM::Ok) err = PM::OutputWriteError ;
+            for (int i=0; err==PM::Ok && !packptr && i<exported.count(); i++) {
+                m_journal.markFaceDone(sceneFolder, stamp, res+1, exported.at(i)) ;
+            }
+            res++ ;
+        }
+
+        if (packptr) {
+            if (err==PM::Ok && pack.close()) {
+                m_tilePacks.insert(sceneFolder, pack.index(packName)) ;
+            } else {
+                pack.discard() ;
+                if (err==PM::Ok) err = PM::OutputWriteError ;
+            }
+        }
+
+        *cuberesolution = width ;
+        *levels = res ;
+        setProgressDelta(100) ;
+
+    }
+
+    if (err==PM::Ok) {
+        err=sceneimg.exportVerticalPreview(previewwidth, previewsequence, folder + QString("/preview.jpg")) ;
+    }
+
+    if (err==PM::Ok) m_journal.markSceneDone(sceneFolder, stamp, *levels, *cuberesolution) ;
+
+    disconnect(this, SIGNAL(abort()), &sceneimg, SLOT(handleAbort())) ;
+    disconnect(&sceneimg, SIGNAL(progressUpdate(QString)), this, SLOT(handleProgressUpdate(QString))) ;
+
+    return err ;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// exportSampledFaces - Export the first tile levels of a preview, sampling each level directly
+//                      from the equirectangular image.  The hi-res faces are not built, used or
+//                      changed, and the tour's face size is the top level exported.
+//
+
+PM::Err TourExporter::exportSampledFaces(Scene& scene, int tilesize, QStringList masks, QString folder, int *levels, int *cuberesolution, int previewwidth, int *previewsequence)
+{
+    QString sceneFolder = QFileInfo(folder).fileName() ;
+    QString packFile = folder + QString("/tiles.pack") ;
+    QString packName = sceneFolder + QString("/tiles.pack") ;
+
+    FaceSizing sizing = faceSizing() ;
+    int facesize = sizing.faceSize(scene.filename()) ;
+    if (facesize<=0) return PM::EquirectReadError ;
+
+    int numlevels = qMin(m_previewLevels, sizing.levels(facesize)) ;
+    *levels = numlevels ;
+    *cuberesolution = sizing.levelSize(facesize, numlevels) ;
+
+    if (!sceneSelected(scene)) {
+        if (m_project->packTiles()) {
+            QJsonObject jo_pack = TilePack::readIndex(packFile, packName) ;
+            if (!jo_pack.isEmpty()) m_tilePacks.insert(sceneFolder, jo_pack) ;
+        }
+        setProgressDelta(100) ;
+        return PM::Ok ;
+    }
+
+    emit(progressUpdate(QString("Loading Equirectangular Image"))) ;
+    EquirectSampler sampler ;
+    if (!sampler.load(scene.filename())) return PM::EquirectReadError ;
+
+    SceneImage sceneimg ;
+    connect(&sceneimg, SIGNAL(progressUpdate(QString)), this, SLOT(handleProgressUpdate(QString))) ;
+    connect(this, SIGNAL(abort()), &sceneimg, SLOT(handleAbort())) ;
+
+    PM::Err err = PM::Ok ;
+    TilePack pack ;
+    TilePack *packptr = NULL ;
+    if (m_project->packTiles()) {
+        if (!pack.open(packFile, folder)) err = PM::OutputWriteError ;
+        packptr = &pack ;
+    }
+
+    if (tilesize>facesize) tilesize=facesize ;
+    for (int res=0; err==PM::Ok && res<numlevels; res++) {
+        int imagesize = sizing.levelSize(facesize, res+1) ;
+        err = sceneimg.sampleFaces(sampler, imagesize) ;
+        for (int f=0; err==PM::Ok && f<6; f++) {
+            QString filename = folder + QString("/") + QString::number(res+1) ;
+            connect(this, SIGNAL(abort()), &sceneimg.getFace(f), SLOT(handleAbort())) ;
+            err = sceneimg.getFace(f).exportTiles(imagesize, tilesize, filename, masks.at(f), m_deduplicate ? &m_dedup : NULL,
+                                                  packptr, &m_encoder, packptr ? NULL : &m_writer) ;
+            disconnect(this, SIGNAL(abort()), &sceneimg.getFace(f), SLOT(handleAbort())) ;
+        }
+        if (!m_writer.finish() && err==PM::Ok) err = PM::OutputWriteError ;
+        setProgressDelta(((res+1)*90)/numlevels) ;
+    }
+
+    if (packptr) {
+        if (err==PM::Ok && pack.close()) {
+            m_tilePacks.insert(sceneFolder, pack.index(packName)) ;
+        } else {
+            pack.discard() ;
+            if (err==PM::Ok) err = PM::OutputWriteError ;
+        }
+    }
+
+    if (err==PM::Ok) err = sceneimg.sampleFaces(sampler, previewwidth) ;
+    if (err==PM::Ok) {
+        err = sceneimg.exportVerticalPreview(previewwidth, previewsequence, folder + QString("/preview.jpg")) ;
+    }
+
+    disconnect(this, SIGNAL(abort()), &sceneimg, SLOT(handleAbort())) ;
+    disconnect(&sceneimg, SIGNAL(progressUpdate(QString)), this, SLOT(handleProgressUpdate(QString))) ;
+
+    setProgressDelta(100) ;
+    return err ;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// writeSceneFile - Write a scene's configuration, and its pack index, to <scene>/scene.json
+//
+
+bool TourExporter::writeSceneFile(QString dir, Scene& scene, QJsonObject config, QString *file)
+{
+    *file = scene.titleId() + QString("/scene.json") ;
+    if (m_tilePacks.contains(scene.titleId())) config.insert("tilePack", m_tilePacks.value(scene.titleId())) ;
+
+    QDir d ;
+    d.mkpath(dir + QString("/") + scene.titleId()) ;
+
+    QJsonDocument doc(config) ;
+    QSaveFile output(dir + QString("/") + *file) ;
+    if (!output.open(QIODevice::WriteOnly | QIODevice::Text)) return false ;
+    output.write(doc.toJson(m_project->compressAssets() ? QJsonDocument::Compact : QJsonDocument::Indented)) ;
+    return output.commit() ;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// writePrecacheManifest - List the library, configuration and low level tiles for the service worker
+//
+// Returns the html which registers the service worker, or an empty string if the manifest can't be written
+//
+
+QString TourExporter::writePrecacheManifest(QString dir, QString libFolder, QStringList files, QString page)
+{
+    PrecacheManifest manifest(dir) ;
+
+    foreach (QString file, resourceFiles(libFolder) + files) {
+        if (!file.isEmpty()) manifest.addFile(file) ;
+    }
+    manifest.addFolder("pmicons") ;
+    manifest.addPage(page) ;
+
+    // The preview and first levels of each scene, which are shown first.  Packed tiles
+    // are read with range requests, which aren't cached, so only their preview is listed.
+    for (int i=0; i<m_project->sceneCount(); i++) {
+        QString scene = m_project->sceneAt(i).titleId() ;
+        manifest.addFile(scene + QString("/preview.jpg")) ;
+        if (m_tilePacks.contains(scene)) continue ;
+        for (int level=1; level<=PRECACHE_TILE_LEVELS; level++) {
+            manifest.addFolder(scene + QString("/") + QString::number(level)) ;
+        }
+    }
+
+    if (!manifest.write(dir + QString("/precache-manifest.json"))) return QString() ;
+
+    // The version is part of the worker's url, so the browser installs it again when anything changes
+    return QString("<script>if ('serviceWorker' in navigator) navigator.serviceWorker.register('tour-sw.js?v=") +
+            manifest.version() + QString("');</script>") ;
+}
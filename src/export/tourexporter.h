@@ -0,0 +1,150 @@
+//    PanoManager - Interactive panorama tour manager program
+//    Copyright (C) 2018  Steve M Clarke
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+//
+// Tour Exporter
+//
+// Builds scene faces and exports tours to Marzipano / Pannellum.  The exporter
+// does not use any widgets, so it can be driven from the main window or from
+// the command line.
+//
+
+#ifndef TOUREXPORTER_H
+#define TOUREXPORTER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QJsonObject>
+#include <QElapsedTimer>
+#include "../project/project.h"
+#include "../errors/pmerrors.h"
+#include "../sceneimage/tilededuplicator.h"
+#include "../sceneimage/tileencoder.h"
+#include "../sceneimage/tilewriter.h"
+#include "../sceneimage/facesizing.h"
+#include "exportjournal.h"
+
+class TourExporter : public QObject
+{
+    Q_OBJECT
+
+private:
+    bool m_abort ;
+    Project *m_project ;
+    QString m_libFolder ;
+    QStringList m_sceneFilter ;
+    bool m_deduplicate ;
+    int m_previewLevels ;
+    TileDeduplicator m_dedup ;
+    TileEncoder m_encoder ;
+    TileWriter m_writer ;
+    ExportJournal m_journal ;
+    QJsonObject m_tilePacks ;   // Scene titleId => pack index, when tiles are packed
+
+    // Time spent exporting, and building faces during the export, to calibrate the ExportPlanner
+    QElapsedTimer m_exportTimer ;
+    qint64 m_exportBuildMs ;
+
+    // Progress is tracked in units (100 per scene), and reported as a percentage
+    int m_progressPos ;
+    int m_progressMax ;
+
+    void startExport() ;
+    void startProgress(int max) ;
+    void setProgressDelta(int delta) ;
+    void addProgress(int delta) ;
+
+    void calibratePlanner(QString tileformat) ;
+    PM::Err exportFaces(Scene& scene, int tilesize, QStringList masks, QString folder, int *levels, int *cuberesolution, int previewwidth, int *previewsequence) ;
+    PM::Err exportSampledFaces(Scene& scene, int tilesize, QStringList masks, QString folder, int *levels, int *cuberesolution, int previewwidth, int *previewsequence) ;
+    QStringList resourceFiles(QString source) ;
+    bool copyResourceFolder(QString source, QString dest, bool forceOverwrite) ;
+    bool compressTextFiles(QString source, QString dest, QStringList generated) ;
+    bool copyResourceIcons(QString destfolder, int size, bool ignorerotated) ;
+    bool copyFile(QString source, QString dest, bool forceOverwrite) ;
+    QString journalSignature(int tilesize) ;
+    QString faceStamp(Scene& scene) ;
+    QStringList tileMasks(QString extension) ;
+    QByteArray tilePacksScript() ;
+    bool writeSceneFile(QString dir, Scene& scene, QJsonObject config, QString *file) ;
+    QString writePrecacheManifest(QString dir, QString libFolder, QStringList files, QString page) ;
+
+public:
+    explicit TourExporter(Project *project) ;
+
+private:
+    TourExporter(const TourExporter& other) ;
+    TourExporter& operator=(const TourExporter& rhs) ;
+
+public:
+    // Folder containing the marzipano and pannellum library folders
+    static QString defaultLibraryFolder() ;
+    void setLibraryFolder(QString folder) ;
+    QString libraryFolder() ;
+
+    // Limit building and tile export to the listed scenes (ids or titles).  Scenes which
+    // are not listed are still included in the tour, using their previously exported tiles.
+    void setSceneFilter(QStringList scenes) ;
+    bool sceneSelected(Scene& scene) ;
+
+    // Write tiles identical to ones already exported as hard links (on by default)
+    void setDeduplicateTiles(bool yes) ;
+    bool deduplicateTiles() ;
+
+    // Export only the first levels tile levels (0 exports them all), sampled directly from the
+    // equirectangular images, so a quick preview of a tour can be made without building faces
+    void setPreviewLevels(int levels) ;
+    int previewLevels() ;
+
+    // Tile counts and encoder statistics from the last export, and a one line summary of them
+    const TileDeduplicator& tileStats() ;
+    const TileEncoder& encoderStats() ;
+    const TileWriter& writerStats() ;
+    QString tileSummary() ;
+
+    // Returns an empty string if the project can be exported to dir, or the reason it can't
+    QString checkProject(QString dir) ;
+
+    // Hi-res face and tile level sizes, from the project settings.  The editor uses the
+    // static version, so the faces it builds are the ones an export expects.
+    FaceSizing faceSizing() ;
+    static FaceSizing faceSizing(Project *project) ;
+
+    // Returns true if the high resolution faces for the scene are missing, older than the
+    // source, or not the size the face sizing policy gives
+    bool sceneIsStale(Scene& scene) ;
+
+    // Build any missing high resolution faces, and optionally rebuild out of date ones
+    PM::Err buildScenes(bool rebuildOutdated) ;
+
+    PM::Err exportMarzipano(QString dir) ;
+    PM::Err exportPannellum(QString dir) ;
+
+signals:
+    void stageUpdate(QString message) ;
+    void progressUpdate(QString message) ;
+    void percentUpdate(int percent) ;
+    void abort() ;
+
+public slots:
+    void handleAbort() ;
+    void handleProgressUpdate(QString message) ;
+    void handleBuildPercentUpdate(int percent) ;
+
+};
+
+#endif // TOUREXPORTER_H
@@ -0,0 +1,415 @@
+//    PanoManager - Interactive panorama tour manager program
+//    Copyright (C) 2018  Steve M Clarke
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+//
+// Tour Importer
+//
+
+#include "tourimporter.h"
+#include "../sceneimage/tilepack.h"
+#include "../sceneimage/tilededuplicator.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QSaveFile>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QStringList>
+#include <QtMath>
+
+TourImporter::TourImporter(Project *project)
+{
+    m_project = project ;
+    m_facesAdopted = 0 ;
+    m_imageFailed = false ;
+}
+
+TourImporter::~TourImporter()
+{
+}
+
+bool TourImporter::isTour(QString folder)
+{
+    return QFile::exists(folder + "/mtour.js") || QFile::exists(folder + "/ptour.js") ;
+}
+
+int TourImporter::scenesImported() { return m_sceneIds.count() ; }
+int TourImporter::facesAdopted() { return m_facesAdopted ; }
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// importTour
+//
+
+PM::Err TourImporter::importTour(QString folder, QString imageFolder)
+{
+    if (!m_project) return PM::InvalidPointer ;
+    if (folder.isEmpty()) return PM::InputNotDefined ;
+    if (imageFolder.isEmpty()) return PM::OutputNotDefined ;
+
+    // The faces would otherwise be written among the tour's tiles
+    m_folder = QDir::cleanPath(QFileInfo(folder).absoluteFilePath()) ;
+    m_imageFolder = QDir::cleanPath(QFileInfo(imageFolder).absoluteFilePath()) ;
+    if (m_imageFolder.compare(m_folder)==0) return PM::OutputNotDefined ;
+    QDir dir ;
+    if (!dir.mkpath(m_imageFolder)) return PM::OutputWriteError ;
+
+    m_extension.clear() ;
+    m_sceneIds.clear() ;
+    m_facesAdopted = 0 ;
+    m_imageFailed = false ;
+
+    QJsonObject jo_marzipano = readConfig(m_folder + "/mtour.js") ;
+    QJsonObject jo_pannellum = readConfig(m_folder + "/ptour.js") ;
+    if (jo_marzipano.isEmpty() && jo_pannellum.isEmpty()) return PM::TourReadError ;
+
+    // Marzipano first, as it keeps the scene order and hotspot icons.  Pannellum
+    // then adds the north offsets, settings, and any scenes Marzipano lacks.
+    if (!jo_marzipano.isEmpty()) importMarzipano(jo_marzipano) ;
+    if (!jo_pannellum.isEmpty()) importPannellum(jo_pannellum, keyOrder(m_folder + "/ptour.js", "scenes") +
+                                                 keyOrder(m_folder + "/ptour.js", "sceneFiles")) ;
+
+    if (m_extension.isEmpty()) m_extension = "jpg" ;
+    m_project->setTileFormat(m_extension) ;
+
+    // A scene without its faces still imports, and is built from its image when it's available
+    for (int i=0; i<m_project->sceneCount(); i++) {
+        Scene& scene = m_project->sceneAt(i) ;
+        QString id = m_sceneIds.key(scene.id()) ;
+        if (!id.isEmpty() && adoptFaces(scene, id)) m_facesAdopted += 6 ;
+    }
+
+    return m_imageFailed ? PM::OutputWriteError : PM::Ok ;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// readConfig - Read the object from "var name = {...}", which may be followed by further
+//              statements, each on a new line.  Plain JSON files (scene.json) are read too.
+//
+
+QJsonObject TourImporter::readConfig(QString filename)
+{
+    QFile file(filename) ;
+    if (!file.open(QIODevice::ReadOnly)) return QJsonObject() ;
+    QByteArray data = file.readAll() ;
+
+    // A newline can't appear within a JSON string, so the object ends before the next statement
+    int start = data.indexOf('{') ;
+    if (start<0) return QJsonObject() ;
+    int end = data.indexOf("\nvar ", start) ;
+
+    QJsonDocument doc = QJsonDocument::fromJson(data.mid(start, end<0 ? -1 : end-start)) ;
+    if (!doc.isObject()) return QJsonObject() ;
+    return doc.object() ;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// keyOrder - The keys of the config's object called name, in the order the file holds them,
+//            as a QJsonObject sorts its keys.  Only the config's own members are searched.
+//
+
+QStringList TourImporter::keyOrder(QString filename, QString name)
+{
+    QStringList keys ;
+    QFile file(filename) ;
+    if (!file.open(QIODevice::ReadOnly)) return keys ;
+    QByteArray data = file.readAll() ;
+
+    int start = data.indexOf('{') ;
+    if (start<0) return keys ;
+
+    int depth = 0 ;
+    int inside = -1 ;       // Depth of the named object's keys, once it's found
+    for (int i=start; i<data.size(); i++) {
+
+        char c = data.at(i) ;
+        if (c=='{' || c=='[') {
+            depth++ ;
+        } else if (c=='}' || c==']') {
+            if (depth==inside) return keys ;
+            if (--depth==0) return keys ;
+        } else if (c=='"') {
+
+            // Find the end of the string, and whether it's a key
+            int end = i+1 ;
+            while (end<data.size() && data.at(end)!='"') end += (data.at(end)=='\\') ? 2 : 1 ;
+            if (end>=data.size()) return keys ;
+            int next = end+1 ;
+            while (next<data.size() && QChar(data.at(next)).isSpace()) next++ ;
+
+            if (next<data.size() && data.at(next)==':') {
+                // Decoded as a JSON string, for any escapes
+                QString key = QJsonDocument::fromJson("[" + data.mid(i, end-i+1) + "]").array().at(0).toString() ;
+                if (depth==inside) {
+                    keys.append(key) ;
+                } else if (depth==1 && key.compare(name)==0) {
+                    int value = next+1 ;
+                    while (value<data.size() && QChar(data.at(value)).isSpace()) value++ ;
+                    if (value<data.size() && data.at(value)=='{') inside = 2 ;
+                }
+            }
+            i = end ;
+        }
+    }
+
+    return keys ;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// tourScene - Find the scene with a tour id, adding it if it's new
+//
+
+Scene& TourImporter::tourScene(QString id)
+{
+    if (m_sceneIds.contains(id)) return m_project->scene(m_sceneIds.value(id)) ;
+
+    // The scene's image is expected beside its tile folder, and is linked into the image folder
+    static const char *suffixes[] = { "jpg", "jpeg", "tif", "tiff", "png" } ;
+    QString image = m_imageFolder + "/" + id + ".jpg" ;
+    for (unsigned int i=0; i<sizeof(suffixes)/sizeof(suffixes[0]); i++) {
+        QString candidate = m_folder + "/" + id + "." + suffixes[i] ;
+        if (QFile::exists(candidate)) {
+            image = m_imageFolder + "/" + id + "." + suffixes[i] ;
+            if (!QFile::exists(image) && !TileDeduplicator::hardLink(candidate, image) &&
+                !QFile::copy(candidate, image)) m_imageFailed = true ;
+            break ;
+        }
+    }
+
+    Scene newScene ;
+    newScene.setFilename(image) ;
+    newScene.setTitle(id) ;
+    newScene.setNorthOffset(0) ;
+    Scene& added = m_project->addScene(newScene) ;
+    m_sceneIds.insert(id, added.id()) ;
+    return added ;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// importMarzipano - Inverse of TourExporter::exportMarzipano
+//
+
+void TourImporter::importMarzipano(const QJsonObject& json)
+{
+    QString title = json.value("name").toString() ;
+    if (!title.isEmpty()) m_project->setTitle(title) ;
+    QString extension = json.value("settings").toObject().value("tileExtension").toString() ;
+    if (!extension.isEmpty()) m_extension = extension ;
+
+    // Scenes are all added before any hotspots, so links can refer to later scenes
+    QList<QJsonObject> scenes ;
+    QJsonArray ja_scenes = json.value("scenes").toArray() ;
+    for (int i=0; i<ja_scenes.count(); i++) {
+
+        // With a file per scene, the tour only lists the scene
+        QJsonObject jo_scene = ja_scenes.at(i).toObject() ;
+        if (jo_scene.contains("file") && !jo_scene.contains("levels")) {
+            QJsonObject jo_file = readConfig(m_folder + "/" + jo_scene.value("file").toString()) ;
+            if (!jo_file.isEmpty()) jo_scene = jo_file ;
+        }
+
+        QString id = jo_scene.value("id").toString() ;
+        if (id.isEmpty()) continue ;
+        Scene& scene = tourScene(id) ;
+        QString name = jo_scene.value("name").toString() ;
+        if (!name.isEmpty()) scene.setTitle(name) ;
+        scenes.append(jo_scene) ;
+    }
+
+    for (int i=0; i<scenes.count(); i++) {
+        Scene& scene = tourScene(scenes.at(i).value("id").toString()) ;
+        QJsonArray ja_links = scenes.at(i).value("linkHotspots").toArray() ;
+        for (int h=0; h<ja_links.count(); h++) addMarzipanoHotspot(scene, ja_links.at(h).toObject(), true) ;
+        QJsonArray ja_info = scenes.at(i).value("infoHotspots").toArray() ;
+        for (int h=0; h<ja_info.count(); h++) addMarzipanoHotspot(scene, ja_info.at(h).toObject(), false) ;
+    }
+
+    QString initial = json.value("initialscene").toString() ;
+    if (m_sceneIds.contains(initial)) m_project->setStartingScene(m_sceneIds.value(initial), 0, 0) ;
+}
+
+void TourImporter::addMarzipanoHotspot(Scene& scene, const QJsonObject& jo_node, bool link)
+{
+    Node node ;
+    node.setLon(qRound(jo_node.value("yaw").toDouble() * 360000 / (2*M_PI))) ;
+    node.setLat(qRound(jo_node.value("pitch").toDouble() * -180000 / M_PI)) ;
+    node.setType(marzipanoIcon(jo_node.value("icon").toString(), jo_node.value("rotation").toDouble(),
+                               link ? Icon::WLink000 : Icon::WInfo)) ;
+    node.setTitle(jo_node.value("title").toString()) ;
+
+    if (link) {
+        QString target = jo_node.value("target").toString() ;
+        if (m_sceneIds.contains(target)) node.setDestId(m_sceneIds.value(target)) ;
+        QJsonObject jo_view = jo_node.value("initialViewParameters").toObject() ;
+        node.setArrivalLon(qRound(jo_view.value("yaw").toDouble() * 360000 / (2*M_PI))) ;
+        node.setArrivalLat(qRound(jo_view.value("pitch").toDouble() * 180000 / M_PI)) ;
+    } else {
+        node.setDescription(jo_node.value("text").toString().replace("br/>", "\n")) ;
+    }
+
+    scene.addNode(node) ;
+}
+
+// The tour holds each icon upright, with a rotation (radians)
+Icon::IconType TourImporter::marzipanoIcon(QString icon, double rotation, Icon::IconType fallback)
+{
+    QString name = QFileInfo(icon).completeBaseName() ;
+    int degrees = ((qRound(rotation * 360 / (2*M_PI)) % 360) + 360) % 360 ;
+
+    for (unsigned int i=0; i<Icon::numTextures; i++) {
+        Icon::IconType type = (Icon::IconType)i ;
+        if (name.compare(Icon::uprightIconName(type))==0 && (Icon::textureOrientation(type) % 360)==degrees) return type ;
+    }
+    return fallback ;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// importPannellum - Inverse of TourExporter::exportPannellum
+//
+
+void TourImporter::importPannellum(const QJsonObject& json, const QStringList& order)
+{
+    QJsonObject jo_default = json.value("default").toObject() ;
+    if (m_project->title().isEmpty() && jo_default.contains("title")) m_project->setTitle(jo_default.value("title").toString()) ;
+    if (jo_default.contains("author")) m_project->setAuthor(jo_default.value("author").toString()) ;
+    if (jo_default.contains("sceneFadeDuration")) m_project->setSceneFade(jo_default.value("sceneFadeDuration").toInt()) ;
+    if (jo_default.contains("compass")) m_project->setCompass(jo_default.value("compass").toBool()) ;
+    if (jo_default.contains("autoLoad")) m_project->setAutoLoad(jo_default.value("autoLoad").toBool()) ;
+    if (jo_default.contains("autoRotateInactivityDelay")) m_project->setAutoRotate(jo_default.value("autoRotateInactivityDelay").toInt()) ;
+    if (jo_default.contains("hotSpotDebug")) m_project->setDebug(jo_default.value("hotSpotDebug").toBool()) ;
+
+    // With a file per scene, the tour only lists the scene's file
+    QJsonObject jo_scenes = json.value("scenes").toObject() ;
+    QJsonObject jo_sceneFiles = json.value("sceneFiles").toObject() ;
+    for (QJsonObject::const_iterator it=jo_sceneFiles.constBegin(); it!=jo_sceneFiles.constEnd(); ++it) {
+        if (jo_scenes.contains(it.key())) continue ;
+        QJsonObject jo_file = readConfig(m_folder + "/" + it.value().toString()) ;
+        if (!jo_file.isEmpty()) jo_scenes.insert(it.key(), jo_file) ;
+    }
+
+    // The scenes are added in the file's order, not jo_scenes' sorted order, with the
+    // first scene leading.  Any the order missed follow.
+    QStringList ids ;
+    QString first = jo_default.value("firstScene").toString() ;
+    if (jo_scenes.contains(first)) ids.append(first) ;
+    for (int i=0; i<order.count(); i++) {
+        if (jo_scenes.contains(order.at(i)) && !ids.contains(order.at(i))) ids.append(order.at(i)) ;
+    }
+    for (QJsonObject::const_iterator it=jo_scenes.constBegin(); it!=jo_scenes.constEnd(); ++it) {
+        if (!ids.contains(it.key())) ids.append(it.key()) ;
+    }
+
+    // Scenes Marzipano already added only take their north offset from here
+    QStringList added ;
+    for (int i=0; i<ids.count(); i++) {
+        QJsonObject jo_scene = jo_scenes.value(ids.at(i)).toObject() ;
+        if (!m_sceneIds.contains(ids.at(i))) {
+            Scene& scene = tourScene(ids.at(i)) ;
+            QString title = jo_scene.value("title").toString() ;
+            if (!title.isEmpty()) scene.setTitle(title) ;
+            added.append(ids.at(i)) ;
+        }
+        tourScene(ids.at(i)).setNorthOffset(jo_scene.value("northoffset").toInt() * 1000) ;
+        QString extension = jo_scene.value("multiRes").toObject().value("extension").toString() ;
+        if (m_extension.isEmpty() && !extension.isEmpty()) m_extension = extension ;
+    }
+
+    for (int i=0; i<added.count(); i++) {
+        Scene& scene = tourScene(added.at(i)) ;
+        QJsonArray ja_hotspots = jo_scenes.value(added.at(i)).toObject().value("hotSpots").toArray() ;
+        for (int h=0; h<ja_hotspots.count(); h++) {
+
+            QJsonObject jo_hotspot = ja_hotspots.at(h).toObject() ;
+            Node node ;
+            node.setLat(qRound(jo_hotspot.value("pitch").toDouble() * 1000)) ;
+            node.setLon(qRound(jo_hotspot.value("yaw").toDouble() * 1000)) ;
+
+            if (jo_hotspot.value("type").toString().compare("scene")==0) {
+                node.setType(Icon::WLink000) ;
+                node.setTitle(jo_hotspot.value("text").toString()) ;
+                QString target = jo_hotspot.value("sceneId").toString() ;
+                if (m_sceneIds.contains(target)) node.setDestId(m_sceneIds.value(target)) ;
+                node.setArrivalLat(qRound(jo_hotspot.value("targetPitch").toDouble() * 1000)) ;
+                node.setArrivalLon(qRound(jo_hotspot.value("targetYaw").toDouble() * 1000)) ;
+            } else {
+                // The export joins the title and description, so they can't be separated again
+                node.setType(Icon::WInfo) ;
+                node.setTitle(jo_hotspot.value("text").toString()) ;
+                node.setUrl(jo_hotspot.value("URL").toString()) ;
+            }
+
+            scene.addNode(node) ;
+        }
+    }
+
+    if (m_sceneIds.contains(first)) {
+        m_project->setStartingScene(m_sceneIds.value(first), qRound(jo_default.value("pitch").toDouble() * 1000),
+                                    qRound(jo_default.value("yaw").toDouble() * 1000)) ;
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// adoptFaces - Use the single tile of each face at level 1 as the scene's preview face
+//
+
+bool TourImporter::adoptFaces(Scene& scene, QString id)
+{
+    // Face order, as TourExporter::tileMasks
+    static const char *faces[] = { "f", "r", "b", "l", "u", "d" } ;
+
+    // Faces already built from the scene's image are better than the tiles
+    if (scene.imageFilesExist(false)) return true ;
+
+    QString tiles = m_folder + "/" + id ;
+    QDir dir ;
+    if (!dir.mkpath(scene.folder())) return false ;
+
+    // Packed tiles are copied out of the pack, still encoded
+    QFile pack(tiles + "/tiles.pack") ;
+    QJsonObject jo_packed = TilePack::readIndex(pack.fileName(), QString()).value("tiles").toObject() ;
+    if (!jo_packed.isEmpty() && !pack.open(QIODevice::ReadOnly)) return false ;
+
+    for (int f=0; f<6; f++) {
+
+        QString facefile = scene.faceFilename(f, false) ;
+        QString key = QString("1/") + faces[f] + QString("/0/0") ;
+        QString tile = tiles + "/" + key + "." + m_extension ;
+        QFile::remove(facefile) ;
+
+        if (QFile::exists(tile)) {
+            if (!TileDeduplicator::hardLink(tile, facefile) && !QFile::copy(tile, facefile)) return false ;
+            continue ;
+        }
+
+        QJsonArray ja_entry = jo_packed.value(key).toArray() ;
+        if (ja_entry.count()!=2 || !pack.seek((qint64)ja_entry.at(0).toDouble())) return false ;
+        qint64 length = (qint64)ja_entry.at(1).toDouble() ;
+        QByteArray data = pack.read(length) ;
+        if (data.size()!=length) return false ;
+
+        QSaveFile face(facefile) ;
+        if (!face.open(QIODevice::WriteOnly) || face.write(data)!=length || !face.commit()) return false ;
+    }
+
+    return true ;
+}
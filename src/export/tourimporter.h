@@ -0,0 +1,91 @@
+//    PanoManager - Interactive panorama tour manager program
+//    Copyright (C) 2018  Steve M Clarke
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+//
+// Tour Importer
+//
+// Builds a project from a tour exported to Marzipano (mtour.js) and/or
+// Pannellum (ptour.js), for tours whose project file is not available.
+// mtour.js holds each hotspot's icon and arrival view, and ptour.js each
+// scene's north offset and the tour's settings, so both are read if present.
+//
+// Nothing is decoded or re-tiled.  The first level of a tour holds each face
+// in a single tile, which is linked (or copied out of the scene's tile pack)
+// into the scene's face folder as its preview face, so the tour opens in the
+// editor straight away.  The tile keeps its format, which Qt recognises by
+// its content.
+//
+// The tour is only read.  Each scene's image (<tour>/<scene>.jpg), where the
+// tour has one, is linked or copied into the project's image folder, and the
+// scene's face folder is <images>/<scene>, beside it.  Hi-res faces can't be
+// made without decoding the tiles, so a scene needs its image to be exported
+// again.
+//
+
+#ifndef TOURIMPORTER_H
+#define TOURIMPORTER_H
+
+#include <QString>
+#include <QHash>
+#include <QStringList>
+#include <QJsonObject>
+#include "../project/project.h"
+#include "../errors/pmerrors.h"
+#include "../icons/icons.h"
+
+class TourImporter
+{
+private:
+    Project *m_project ;
+    QString m_folder ;
+    QString m_imageFolder ;
+    QString m_extension ;
+    QHash<QString, Id> m_sceneIds ;     // Tour scene id (the scene's titleId) => project scene id
+    int m_facesAdopted ;
+    bool m_imageFailed ;
+
+    Scene& tourScene(QString id) ;
+    void importMarzipano(const QJsonObject& json) ;
+    void importPannellum(const QJsonObject& json, const QStringList& order) ;
+    void addMarzipanoHotspot(Scene& scene, const QJsonObject& jo_node, bool link) ;
+    bool adoptFaces(Scene& scene, QString id) ;
+
+    static QJsonObject readConfig(QString filename) ;
+    static QStringList keyOrder(QString filename, QString name) ;
+    static Icon::IconType marzipanoIcon(QString icon, double rotation, Icon::IconType fallback) ;
+
+public:
+    TourImporter(Project *project) ;
+    ~TourImporter() ;
+
+private:
+    TourImporter(const TourImporter& other) ;
+    TourImporter& operator=(const TourImporter& rhs) ;
+
+public:
+    // True if folder holds an exported tour
+    static bool isTour(QString folder) ;
+
+    // Add the scenes and hotspots of the tour in folder to the project, which
+    // should be empty.  The scenes' images and faces are put in imageFolder,
+    // which can't be the tour's folder.  The project is not saved.
+    PM::Err importTour(QString folder, QString imageFolder) ;
+
+    int scenesImported() ;
+    int facesAdopted() ;
+};
+
+#endif // TOURIMPORTER_H
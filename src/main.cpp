@@ -19,9 +19,16 @@
 //
 
 #include "mainwindow.h"
+#include "cli/commandline.h"
+#include "cli/buildserver.h"
+#include "sceneimage/warmcache.h"
+#include "project/id.h"
 #include <QApplication>
+#include <QCoreApplication>
 #include <QFontDatabase>
 #include <QFont>
+#include <string.h>
+#include <stdlib.h>
 
 
 /*#ifdef __MINGW32__
@@ -32,10 +39,21 @@
 */
 
 int getopt(int nargc, char * const nargv[], const char *ostr) ;
+extern char *optarg ;
+extern int optind ;
+int runCommandLine(int argc, char *argv[]) ;
 
 int main(int argc, char *argv[])
 {
+    // Command line mode must be detected before the application is created,
+    // as it runs without a QApplication, widgets or GL context
+    for (int i=1; i<argc; i++) {
+        if (strncmp(argv[i], "-c", 2)==0 || strncmp(argv[i], "-d", 2)==0 ||
+            strncmp(argv[i], "-i", 2)==0) return runCommandLine(argc, argv) ;
+    }
+
     QApplication a(argc, argv);
+    Id::registerMetaType() ;
 
     bool useNativeFileDialog = false ;
     bool useSystemFonts = true ;
@@ -58,10 +76,24 @@ int main(int argc, char *argv[])
             case 'h':
             case '?':
                 printf("panomanager [-h] [-n|N] [-f|F]\n") ;
+                printf("panomanager -c project.pmp [-b] [-P] [-m folder] [-p folder] [-l folder] [-s scenes] [-x] [-r levels]\n") ;
+                printf("panomanager -d socketname [-j threads] [-k megabytes] [-l folder]\n") ;
+                printf("panomanager -i folder tour...\n") ;
                 printf(" -N       Use Native File Dialog (default)\n") ;
                 printf(" -n       Use System File Dialog\n") ;
                 printf(" -f       Use in-built Fonts\n") ;
                 printf(" -F       Use System Fonts (default)\n") ;
+                printf(" -c file  Command line mode: open project file (no GUI)\n") ;
+                printf(" -b       Command line mode: build stale scenes\n") ;
+                printf(" -P       Command line mode: report the export plan (tiles, size, time and memory)\n") ;
+                printf(" -m dir   Command line mode: export Marzipano tour to dir\n") ;
+                printf(" -p dir   Command line mode: export Pannellum tour to dir\n") ;
+                printf(" -l dir   Command line mode: library folder (default ../lib/PanoManager)\n") ;
+                printf(" -s list  Command line mode: only build / export the comma separated scenes\n") ;
+                printf(" -x       Command line mode: write duplicate tiles, rather than hard linking them\n") ;
+                printf(" -r num   Command line mode: preview export of the first num tile levels, without building faces\n") ;
+                printf(" -d name  Run as a build server, listening on local socket name (no GUI)\n") ;
+                printf(" -i dir   Import each tour folder into a project of its own in dir (no GUI)\n") ;
                 break ;
         }
     }
@@ -81,6 +113,103 @@ int main(int argc, char *argv[])
     return a.exec();
 }
 
+int runCommandLine(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    CommandLine cli ;
+    QString serverName ;
+    QString libFolder ;
+    int threads = 0 ;
+    int cacheMegabytes = 1024 ;
+
+    int c ;
+    while ((c = getopt(argc, argv, "hc:bPm:p:l:s:xr:d:j:k:i:")) != -1) {
+        switch (c) {
+            case 'c':
+                cli.setProjectFile(QString::fromLocal8Bit(optarg)) ;
+                break ;
+            case 'b':
+                cli.setBuild(true) ;
+                break ;
+            case 'P':
+                cli.setPlan(true) ;
+                break ;
+            case 'm':
+                cli.setMarzipanoFolder(QString::fromLocal8Bit(optarg)) ;
+                break ;
+            case 'p':
+                cli.setPannellumFolder(QString::fromLocal8Bit(optarg)) ;
+                break ;
+            case 'l':
+                libFolder = QString::fromLocal8Bit(optarg) ;
+                cli.setLibraryFolder(libFolder) ;
+                break ;
+            case 's':
+                cli.setScenes(QString::fromLocal8Bit(optarg).split(",", QString::SkipEmptyParts)) ;
+                break ;
+            case 'x':
+                cli.setDeduplicateTiles(false) ;
+                break ;
+            case 'r':
+                cli.setPreviewLevels(atoi(optarg)) ;
+                break ;
+            case 'd':
+                serverName = QString::fromLocal8Bit(optarg) ;
+                break ;
+            case 'j':
+                threads = atoi(optarg) ;
+                break ;
+            case 'k':
+                cacheMegabytes = atoi(optarg) ;
+                break ;
+            case 'i':
+                cli.setImportFolder(QString::fromLocal8Bit(optarg)) ;
+                break ;
+            case 'h':
+            case '?':
+                printf("panomanager -c project.pmp [-b] [-P] [-m folder] [-p folder] [-l folder] [-s scenes] [-x] [-r levels]\n") ;
+                printf("panomanager -d socketname [-j threads] [-k megabytes] [-l folder]\n") ;
+                printf("panomanager -i folder tour...\n") ;
+                printf(" -c file  Open project file\n") ;
+                printf(" -b       Build stale scenes\n") ;
+                printf(" -P       Report the export plan (tiles, size, time and memory) before running\n") ;
+                printf(" -m dir   Export Marzipano tour to dir\n") ;
+                printf(" -p dir   Export Pannellum tour to dir\n") ;
+                printf(" -l dir   Library folder (default ../lib/PanoManager)\n") ;
+                printf(" -s list  Only build / export the comma separated scenes (ids or titles)\n") ;
+                printf(" -x       Write duplicate tiles, rather than hard linking them\n") ;
+                printf(" -r num   Preview export of the first num tile levels, sampled without building faces\n") ;
+                printf(" -d name  Run as a build server, listening on local socket name\n") ;
+                printf(" -j num   Build server worker threads (default: number of cores)\n") ;
+                printf(" -k mb    Build server cache size for maps and faces (default 1024)\n") ;
+                printf(" -i dir   Import each tour folder into dir/<tour>.pmb, with its images in dir/<tour>\n") ;
+                return 2 ;
+        }
+    }
+
+    // The tours to import follow the options
+    QStringList tours ;
+    for (int i=optind; i<argc; i++) tours.append(QString::fromLocal8Bit(argv[i])) ;
+    cli.setImportTours(tours) ;
+
+    if (serverName.isEmpty()) {
+        return cli.run() ;
+    }
+
+    // Build server - keep maps and faces warm between jobs
+    WarmCache::enable(cacheMegabytes, cacheMegabytes) ;
+    BuildServer server ;
+    server.setLibraryFolder(libFolder) ;
+    server.setThreads(threads) ;
+    if (!server.listen(serverName)) {
+        printf("Unable to listen on %s\n", serverName.toLocal8Bit().constData()) ;
+        return 1 ;
+    }
+    printf("Listening on %s\n", serverName.toLocal8Bit().constData()) ;
+    fflush(stdout) ;
+    return a.exec() ;
+}
+
 
 #include <string.h>
 #include <stdio.h>
@@ -24,7 +24,6 @@
 #include "ui_mainwindow.h"
 
 #include <QMessageBox>
-#include <QListWidgetItem>
 #include <QFileDialog>
 #include <QFileInfo>
 #include <QBitmap>
@@ -40,17 +39,32 @@
 #include "dialogs/tourproperties/tourpropertiesdialog.h"
 #include "dialogs/about/aboutdialog.h"
 
+// How often edits are written to the project journal (ms)
+#define JOURNAL_INTERVAL 2000
+
 MainWindow::MainWindow(QWidget *parent) :
     QMainWindow(parent),
+    m_sceneModel(&project),
+    m_nodeModel(&project),
     ui(new Ui::MainWindow)
 {
-    m_currentScene="" ;
-    m_currentNode="" ;
+    m_currentScene = Id() ;
+    m_currentNode = Id() ;
 
     ui->setupUi(this);
     this->setWindowTitle("Pano Manager") ;
     this->setAccessibleName("Pano Manager") ;
 
+    // Scene and node lists are views of the project, kept sorted by title.  The
+    // node destinations are in project order, so match project.sceneAt().
+    m_sceneSort.setSourceModel(&m_sceneModel) ;
+    m_sceneSort.sort(0) ;
+    ui->scenes_listView->setModel(&m_sceneSort) ;
+    m_nodeSort.setSourceModel(&m_nodeModel) ;
+    m_nodeSort.sort(0) ;
+    ui->node_listView->setModel(&m_nodeSort) ;
+    ui->nodedestination_comboBox->setModel(&m_sceneModel) ;
+
     settings = new QSettings("trumpton.org.uk", "panomanager") ;
 
     // Populate Node Types Menu
@@ -70,23 +84,33 @@ MainWindow::MainWindow(QWidget *parent) :
     webserver.setCommand(settings->value("webservercommand","php -S localhost:8000").toString()) ;
     webserver.setServerFolder(settings->value("webserverfolder", "").toString());
 
+    // Scenes are shown one at a time, so their nodes are only read when needed
+    project.setLazyLoad(true) ;
+
     // Clear out, and put app in a known fixed state
     on_action_New_Project_triggered();
 
     // Signal and Slot Connection for live update of bearing
     connect(ui->display, SIGNAL(realBearingChanged(int,int)), this, SLOT(on_realBearingChanged(int,int)));
+
+    // Edits are written to the project's journal as they are made
+    connect(&m_journalTimer, SIGNAL(timeout()), this, SLOT(handleJournalTimer())) ;
+    m_journalTimer.start(JOURNAL_INTERVAL) ;
 }
 
 MainWindow::~MainWindow()
 {
     ui->display->clearScene() ;
-
-    // Refresh to free allocated memory
-    refreshScenes("") ;
-    refreshNodes("") ;
     delete ui;
 }
 
+void MainWindow::handleJournalTimer()
+{
+    if (!project.journalChanges()) {
+        qDebug() << "handleJournalTimer: unable to write project journal" ;
+    }
+}
+
 void MainWindow::setOptions(bool useNativeFileDialog)
 {
     qDebug() << "setOption(" << useNativeFileDialog << ")" ;
@@ -104,9 +128,12 @@ void MainWindow::setOptions(bool useNativeFileDialog)
 //
 // Form Refresh Functions
 //
-// refreshScenes            - Update the scenes form
-// refreshNodes             - Update the nodes and enable the appropriate parts of the form
-// findListWidgetItemById   - Search the list widget, and return pointer to item which has matching id, or NULL
+// refreshScenes            - Select the current scene, and enable the appropriate parts of the form
+// refreshNodes             - Select the current node, show its details and enable the appropriate parts of the form
+//
+// The lists themselves are models of the project (see SceneListModel and NodeListModel),
+// which the project keeps up to date as scenes and nodes are added and removed.  These
+// only redraw the selected row, in case its title has changed.
 //
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -114,95 +141,37 @@ void MainWindow::setOptions(bool useNativeFileDialog)
 // refreshScenes
 //
 
-void MainWindow::refreshScenes(QString selectedScene)
+void MainWindow::refreshScenes(Id selectedScene)
 {
-
-    static int mutex=0 ;
-    if (mutex>0) {
-        // Deleting listwidgetitem removes it from the list
-        // It also de-selects it if it was selected, resulting in a
-        // QListWidget_selection_changed message, and an attempted
-        // call to refresScenes(), which is ignored by the mutex
-        qDebug() << "refreshScenes() re-entrant call - exited" ;
-        return ;
-    }
-    mutex++ ;
-
-    qDebug() << "refreshScenes(" << selectedScene << ") started" ;
-
-    for (int i=0; i<project.sceneCount(); i++) {
-        Scene& scene = project.sceneAt(i) ;
-        QString scenetitle = scene.title() ;
-        QString sceneId = scene.id() ;
-        QListWidgetItem *item = findListWidgetItemById(ui->scenes_listWidget, sceneId) ;
-        if (item) {
-            // Update Entry
-            item->setText(scenetitle) ;
-            qDebug() << " --- scene update:  " << sceneId ;
-        } else {
-            // Add New Entry
-            item = new QListWidgetItem;
-            item->setText(scenetitle) ;
-            item->setData(Qt::UserRole, sceneId) ;
-            ui->scenes_listWidget->addItem(item) ;
-            qDebug() << " --- scene add:     " << sceneId ;
-        }
-    }
-
-    // Remove invalid scene entries (note findItems takes a COPY of the list)
-    // so it is safe to iterate through this list despite deleteing actual items.
-    QList<QListWidgetItem*> items = ui->scenes_listWidget->findItems("", Qt::MatchContains) ;
-    foreach (QListWidgetItem *item, items) {
-        QString sceneId = item->data(Qt::UserRole).toString() ;
-        Scene& scene = project.scene(sceneId) ;
-        if (!scene.isValid()) {
-            // delete item removes it from the list
-            QListWidgetItem *lwi = findListWidgetItemById(ui->scenes_listWidget, sceneId) ;
-            if (lwi) delete lwi ;
-            qDebug() << " --- scene remove: " << sceneId ;
-        }
-    }
+    qDebug() << "refreshScenes(" << selectedScene.toString() << ") started" ;
 
     if (project.scene(selectedScene).isValid()) {
         // Update current scene to match selected, and highlight it as selected
         m_currentScene=selectedScene ;
-        QListWidgetItem *item = findListWidgetItemById(ui->scenes_listWidget, m_currentScene) ;
-        if (item && ui->scenes_listWidget->currentItem()!=item) {
-            ui->scenes_listWidget->clearSelection() ;
-            ui->scenes_listWidget->setCurrentItem(item, QItemSelectionModel::Select) ;
+        m_sceneModel.sceneChanged(m_currentScene) ;
+        QModelIndex index = m_sceneSort.mapFromSource(m_sceneModel.indexOf(m_currentScene)) ;
+        if (ui->scenes_listView->currentIndex()!=index) {
+            ui->scenes_listView->selectionModel()->setCurrentIndex(index, QItemSelectionModel::ClearAndSelect) ;
         }
         ui->sceneTitle_lineEdit->setText(project.scene(m_currentScene).title()) ;
     } else {
         // Unset the current item
-        ui->scenes_listWidget->setCurrentRow(-1) ;
-        ui->scenes_listWidget->clearSelection() ;
+        ui->scenes_listView->selectionModel()->clear() ;
         ui->sceneTitle_lineEdit->setText("") ;
-        m_currentScene="" ;
+        m_currentScene = Id() ;
     }
 
-    // Refresh Node Destinations
-    int nodeDest = ui->nodedestination_comboBox->currentIndex() ;
-    ui->nodedestination_comboBox->clear() ;
-    for (int i=0; i<project.scenes().count(); i++) {
-        Scene& scene = project.sceneAt(i) ;
-        QString scenetitle = scene.title() ;
-        QString sceneid = scene.id() ;
-        ui->nodedestination_comboBox->addItem(scenetitle, sceneid);
-    }
-    ui->nodedestination_comboBox->setCurrentIndex(nodeDest);
+    m_nodeModel.setScene(m_currentScene) ;
 
-    bool showSceneDetails = !m_currentScene.isEmpty() ;
+    bool showSceneDetails = !m_currentScene.isNull() ;
     ui->scenedetails_groupBox->setEnabled(showSceneDetails) ;
     ui->action_Add_Scene->setEnabled(true) ;
 
-    bool someScenes = ui->scenes_listWidget->selectedItems().count()>0 ;
+    bool someScenes = !m_currentScene.isNull() ;
     ui->action_Delete_Scene->setEnabled(someScenes) ;
     ui->deletescene_pushButton->setEnabled(someScenes) ;
 
-    qDebug() << "refreshScenes(" << selectedScene << ") completed" ;
-
-    mutex-- ;
-
+    qDebug() << "refreshScenes(" << selectedScene.toString() << ") completed" ;
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -210,70 +179,23 @@ void MainWindow::refreshScenes(QString selectedScene)
 // refreshNodes
 //
 
-void MainWindow::refreshNodes(QString selectedNode)
+void MainWindow::refreshNodes(Id selectedNode)
 {
-    static int mutex=0 ;
-    if (mutex>0) {
-        // Deleting listwidgetitem removes it from the list
-        // It also de-selects it if it was selected, resulting in a
-        // QListWidget_selection_changed message, and an attempted
-        // call to refreshNodes(), which is ignored by the mutex
-        qDebug() << "refreshNodes() re-entrant call - exited" ;
-        return ;
-    }
-    mutex++ ;
-
-    qDebug() << "refreshNodes(" << selectedNode << ") started" ;
+    qDebug() << "refreshNodes(" << selectedNode.toString() << ") started" ;
 
     Scene& scene = project.scene(m_currentScene) ;
 
-    // Update Existing Entries and Add New
-    for (int j=0; j<scene.nodeCount(); j++) {
-        Node& node = scene.nodeAt(j) ;
-        QString nodeId = scene.nodeAt(j).id() ;
-        QIcon icon(Icon::menuFile(node.type())) ;
-        QListWidgetItem *item = findListWidgetItemById(ui->node_listWidget, nodeId) ;
-        if (item) {
-            // Update Entry
-            item->setText(node.title());
-            item->setIcon(icon) ;
-            qDebug() << " --- node update:  " << nodeId ;
-        } else {
-            // Add New Entry
-            item = new QListWidgetItem ;
-            item->setText(node.title());
-            item->setData(Qt::UserRole, nodeId) ;
-            item->setIcon(icon) ;
-            ui->node_listWidget->addItem(item) ;
-            qDebug() << " --- node add:     " << nodeId ;
-        }
-    }
-
-    // Remove invalid node entries (note findItems takes a COPY of the list)
-    QList<QListWidgetItem*> items = ui->node_listWidget->findItems("", Qt::MatchContains) ;
-    foreach (QListWidgetItem *item, items) {
-        QString nodeId = item->data(Qt::UserRole).toString() ;
-        Node& node = scene.node(nodeId) ;
-        if (!node.isValid()) {
-            QListWidgetItem *lwi = findListWidgetItemById(ui->node_listWidget, nodeId) ;
-            if (lwi) delete lwi ;
-            qDebug() << " --- node remove: " << nodeId ;
-        }
-    }
-
-    if (project.scene(m_currentScene).node(selectedNode).isValid()) {
+    if (scene.constNode(selectedNode).isValid()) {
 
         m_currentNode = selectedNode ;
 
         // Node has changed
-        Node& node = scene.node(m_currentNode) ;
+        const Node& node = scene.constNode(m_currentNode) ;
 
         // Force item to be selected
-        QListWidgetItem *item = findListWidgetItemById(ui->node_listWidget, m_currentNode) ;
-        ui->node_listWidget->clearSelection() ;
-        if (item) {
-            ui->node_listWidget->setCurrentItem(item, QItemSelectionModel::Select) ;
-        }
+        m_nodeModel.nodeChanged(m_currentNode) ;
+        QModelIndex index = m_nodeSort.mapFromSource(m_nodeModel.indexOf(m_currentNode)) ;
+        ui->node_listView->selectionModel()->setCurrentIndex(index, QItemSelectionModel::ClearAndSelect) ;
 
         // Extract parameters for Node
         int bearing = node.arrivalLon() ;
@@ -281,13 +203,12 @@ void MainWindow::refreshNodes(QString selectedNode)
         int type = node.type() ;
         QString title = node.title() ;
         QString desc = node.description() ;
-        QString destsceneref = node.destId() ;
+        Id destsceneref = node.destId() ;
         QString url = node.url() ;
 
         // Select node destination index
-        if (ui->nodedestination_comboBox->currentData().toString().compare(destsceneref)!=0) {
-            int row = ui->nodedestination_comboBox->findData(destsceneref, Qt::UserRole) ;
-            ui->nodedestination_comboBox->setCurrentIndex(row);
+        if (ui->nodedestination_comboBox->currentData().value<Id>()!=destsceneref) {
+            ui->nodedestination_comboBox->setCurrentIndex(project.sceneIndex(destsceneref));
         }
 
         // icon type index
@@ -314,52 +235,30 @@ void MainWindow::refreshNodes(QString selectedNode)
         ui->nodedestination_comboBox->setCurrentIndex(-1) ;
 
         // Unset the current item
-        ui->node_listWidget->setCurrentRow(-1) ;
-        ui->node_listWidget->clearSelection() ;
-        m_currentNode="" ;
+        ui->node_listView->selectionModel()->clear() ;
+        m_currentNode = Id() ;
     }
 
-    bool showNodes = !m_currentScene.isEmpty() ;
+    bool showNodes = !m_currentScene.isNull() ;
     ui->nodelist_groupBox->setEnabled(showNodes) ;
     ui->nodedetails_groupBox->setEnabled(showNodes) ;
     ui->action_Add_Node->setEnabled(showNodes) ;
     ui->nodeAdd_pushButton->setEnabled(showNodes) ;
 
-    bool someNodes = ui->node_listWidget->selectedItems().count()>0 ;
+    bool someNodes = !m_currentNode.isNull() ;
     ui->action_Delete_Node->setEnabled(someNodes) ;
     ui->nodeDelete_pushButton->setEnabled(someNodes) ;
 
-    bool someScenes = ui->scenes_listWidget->selectedItems().count()>0 ;
+    bool someScenes = !m_currentScene.isNull() ;
     ui->action_Delete_Scene->setEnabled(someScenes) ;
     ui->action_Delete_Scene->setEnabled(someScenes) ;
 
+    ui->action_Undo->setEnabled(m_history.canUndo()) ;
+    ui->action_Redo->setEnabled(m_history.canRedo()) ;
+
    ui->display->setSelectedNode(m_currentNode);
    ui->display->refresh();
-   qDebug() << "refreshNode(" << selectedNode << ") complete" ;
-
-   mutex-- ;
-}
-
-//----------------------------------------------------------------------------------------------------------------------
-//
-// findListWidgetItemById
-//
-
-QListWidgetItem* MainWindow::findListWidgetItemById(QListWidget *widget, QString id)
-{
-    qDebug() << "findListWidgetById(" << id << ")" ;
-
-    if (widget) {
-        int count = widget->count() ;
-        for (int i=0; i<count; i++) {
-            if (widget->item(i)->data(Qt::UserRole).toString().compare(id)==0) {
-                qDebug() << "findListWidgetById completed, index=" << i ;
-                return widget->item(i) ;
-            }
-        }
-    }
-    qDebug() << "findListWidgetById completed (nothing found)" ;
-    return NULL ;
+   qDebug() << "refreshNode(" << selectedNode.toString() << ") complete" ;
 }
 
 
@@ -369,7 +268,7 @@ QListWidgetItem* MainWindow::findListWidgetItemById(QListWidget *widget, QString
 //
 //  on_addscene_pushButton_clicked          -   Add a new Scene
 //  on_deletescene_pushButton_clicked       -   Delete the current scene
-//  on_scenes_listWidget_itemClicked        -   User selected different scene
+//  on_scenes_listView_clicked              -   User selected different scene
 //
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -390,7 +289,7 @@ void MainWindow::on_addscene_pushButton_clicked()
         newScene.setFilename(fileName) ;
         newScene.setTitle(path.baseName()) ;
         newScene.setNorthOffset(0) ;
-        project.scenes().append(newScene) ;
+        m_history.addScene(project, newScene) ;
         changeScene(newScene.id()) ;
     }
     qDebug() << "Add_Scene() complete" ;
@@ -408,9 +307,9 @@ void MainWindow::on_deletescene_pushButton_clicked()
     if (project.scene(m_currentScene).isValid()) {
         // Remove the scene from the display, then the scenes list, then refresh
         ui->display->clearScene() ;
-        project.removeScene(m_currentScene) ;
-        refreshScenes("") ;
-        refreshNodes("") ;
+        m_history.removeScene(project, m_currentScene) ;
+        refreshScenes(Id()) ;
+        refreshNodes(Id()) ;
     }
 
 
@@ -419,25 +318,21 @@ void MainWindow::on_deletescene_pushButton_clicked()
 
 //----------------------------------------------------------------------------------------------------------------------
 //
-// on_scenes_listWidget_itemClicked
+// on_scenes_listView_clicked
 //
 
-void MainWindow::on_scenes_listWidget_itemClicked(QListWidgetItem *item)
+void MainWindow::on_scenes_listView_clicked(const QModelIndex &index)
 {
-    QString newsceneId ;
+    Id newsceneId = index.data(Qt::UserRole).value<Id>() ;
 
-    if (item) {
-        newsceneId = item->data(Qt::UserRole).toString() ;
-    }
-
-    if (m_currentScene.compare(newsceneId)==0) return ;
+    if (m_currentScene==newsceneId) return ;
 
-    qDebug() << "scenes_listWidget_itemClicked(" << newsceneId << ")" ;
+    qDebug() << "scenes_listView_clicked(" << newsceneId.toString() << ")" ;
 
     changeScene(newsceneId) ;
     ui->display->setCamera(0, project.scene(m_currentScene).northOffset()) ;
 
-    qDebug() << "scenes_listWidget_itemClicked() complete" ;
+    qDebug() << "scenes_listView_clicked() complete" ;
 
 }
 
@@ -446,13 +341,13 @@ void MainWindow::handleChangeScenePercentUpdate(int percent)
     m_prog.setValue(percent) ;
 }
 
-void MainWindow::changeScene(QString id)
+void MainWindow::changeScene(Id id)
 {
     int north ;
     QString title ;
     PM::Err err = PM::Ok ;
 
-    qDebug() << "changeScene( " << id << ")" ;
+    qDebug() << "changeScene( " << id.toString() << ")" ;
 
     Scene& selectedScene = project.scene(id) ;
 
@@ -466,6 +361,9 @@ void MainWindow::changeScene(QString id)
         m_prog.setMaximum(100);
         m_prog.show() ;
 
+        // Hi-res faces are sized as an export would size them, so it doesn't find them stale
+        sceneimage.setFaceSizing(TourExporter::faceSizing(&project)) ;
+
         connect(&sceneimage, SIGNAL(percentUpdate(int)), this, SLOT(handleChangeScenePercentUpdate(int))) ;
         err=DoBuild(selectedScene.filename(), &sceneimage, 0, 1, !loadhires, true, true, false) ;
         disconnect(&sceneimage, SIGNAL(percentUpdate(int)), this, SLOT(handleChangeScenePercentUpdate(int))) ;
@@ -495,7 +393,7 @@ void MainWindow::changeScene(QString id)
         // Update scene and node list
         refreshScenes(id) ;
         ui->display->setNorthCompassLon(north);
-        refreshNodes("") ;
+        refreshNodes(Id()) ;
 
         m_prog.hide() ;
 
@@ -522,10 +420,11 @@ void MainWindow::on_setNorth_pushButton_clicked()
 {
     qDebug() << "Set_North(" << ui->display->lon() << ", " << ui->display->lat() << ")" ;
 
-    if (m_currentScene<0) return ;
+    if (m_currentScene.isNull()) return ;
     int north = ui->display->lon() ;
-    project.scene(m_currentScene).setNorthOffset(north) ;
+    m_history.setNorthOffset(project, m_currentScene, north) ;
     ui->display->setNorthCompassLon(north) ;
+    refreshNodes(m_currentNode) ;
 }
 
 
@@ -540,7 +439,7 @@ void MainWindow::on_sceneTitle_lineEdit_editingFinished()
     Scene& scene = project.scene(m_currentScene) ;
     QString arg1 = ui->sceneTitle_lineEdit->text() ;
     if (scene.title().compare(arg1)!=0) {
-        scene.setTitle(arg1) ;
+        m_history.setSceneTitle(project, m_currentScene, arg1) ;
         refreshScenes(m_currentScene) ;
     }
 
@@ -594,7 +493,7 @@ void MainWindow::on_turnAround_pushButton_clicked()
 // Node Selection and Management Handlers
 //
 // on_nodeAdd_pushButton_clicked      - Add a new node
-// on_node_listWidget_itemClicked     - Change selected node
+// on_node_listView_clicked           - Change selected node
 // on_nodeDelete_pushButton_clicked   - Remove a node
 //
 
@@ -612,7 +511,7 @@ void MainWindow::on_nodeAdd_pushButton_clicked()
     Node node ;
     node.setLat(ui->display->lat()) ;
     node.setLon(ui->display->lon()) ;
-    scene.nodes().append(node) ;
+    m_history.addNode(project, m_currentScene, node) ;
     refreshNodes(node.id()) ;
 }
 
@@ -622,32 +521,31 @@ void MainWindow::on_nodeAdd_pushButton_clicked()
 //
 void MainWindow::on_nodeDelete_pushButton_clicked()
 {
-    qDebug() << "Node_Delete(" << m_currentNode << ")" ;
-    Node& node = project.scene(m_currentScene).node(m_currentNode) ;
+    qDebug() << "Node_Delete(" << m_currentNode.toString() << ")" ;
+    const Node& node = project.scene(m_currentScene).constNode(m_currentNode) ;
     if (node.isValid()) {
-        project.scene(m_currentScene).removeNode(m_currentNode) ;
+        m_history.removeNode(project, m_currentScene, m_currentNode) ;
     }
-    refreshNodes("") ;
+    refreshNodes(Id()) ;
 
     qDebug() << "Node_Delete() complete" ;
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 //
-// on_node_listWidget_itemClicked
+// on_node_listView_clicked
 //
 
-void MainWindow::on_node_listWidget_itemClicked(QListWidgetItem *item)
+void MainWindow::on_node_listView_clicked(const QModelIndex &index)
 {
-    QString newNodeId ;
-    if (item) newNodeId=item->data(Qt::UserRole).toString() ;
+    Id newNodeId = index.data(Qt::UserRole).value<Id>() ;
 
-    qDebug() << "node_listWidget_itemClicked(" << newNodeId << ")" ;
+    qDebug() << "node_listView_clicked(" << newNodeId.toString() << ")" ;
     refreshNodes(newNodeId) ;
-    int lat = project.scene(m_currentScene).node(m_currentNode).lat() ;
-    int lon = project.scene(m_currentScene).node(m_currentNode).lon() ;
+    int lat = project.scene(m_currentScene).constNode(m_currentNode).lat() ;
+    int lon = project.scene(m_currentScene).constNode(m_currentNode).lon() ;
     ui->display->setCamera(lat, lon) ;
-    qDebug() << "node_listWidget_currentItemChanged() complete" ;
+    qDebug() << "node_listView_clicked() complete" ;
 }
 
 //======================================================================================================================
@@ -655,7 +553,7 @@ void MainWindow::on_node_listWidget_itemClicked(QListWidgetItem *item)
 // Node Editing Handlers
 //
 // on_nodeGo_pushButton_clicked                     - Change scene (follow link)
-// on_nodedestination_comboBox_currentIndexChanged  - User has selected a different destination for a link
+// on_nodedestination_comboBox_activated            - User has selected a different destination for a link
 // on_node_arrivaLlat_lineEdit_textEdited           - User has updated the node's arrival latitude
 // on_node_arrivaLlon_lineEdit_textEdited           - User has updated the node's arrival longitude
 // on_nodetitle_lineEdit_textChanged                - User has updated the node's title
@@ -673,7 +571,7 @@ void MainWindow::on_nodeGo_pushButton_clicked()
 {
     qDebug() << "on_nodeGo_pushButton_clicked()" ;
 
-    Node& node = project.scene(m_currentScene).node(m_currentNode) ;
+    const Node& node = project.scene(m_currentScene).constNode(m_currentNode) ;
     Scene& dest = project.scene(node.destId()) ;
     if (dest.isValid()) {
         changeScene(dest.id()) ;
@@ -689,20 +587,25 @@ void MainWindow::on_nodeGo_pushButton_clicked()
 
 //----------------------------------------------------------------------------------------------------------------------
 //
-// on_nodedestination_comboBox_currentIndexChanged
+// on_nodedestination_comboBox_activated
+//
+// Only user selections are handled, as the current index also moves when scenes
+// are added to or removed from the list
 //
 
-void MainWindow::on_nodedestination_comboBox_currentIndexChanged(int index)
+void MainWindow::on_nodedestination_comboBox_activated(int index)
 {
-    qDebug() << "on_nodedestination_comboBox_currentIndexChanged( " << index << ")" ;
+    qDebug() << "on_nodedestination_comboBox_activated( " << index << ")" ;
 
-    Node& node = project.scene(m_currentScene).node(m_currentNode) ;
-    if (node.destId().compare(project.sceneAt(index).id())!=0) {
+    // Changed as a copy, which the history puts in place of the node
+    Node node = project.scene(m_currentScene).constNode(m_currentNode) ;
+    if (node.destId()!=project.sceneAt(index).id()) {
         node.setDestId(project.sceneAt(index).id()) ;
+        m_history.setNodeDetails(project, m_currentScene, node) ;
         refreshNodes(m_currentNode) ;
     }
 
-    qDebug() << "on_nodedestination_comboBox_currentIndexChanged complete" ;
+    qDebug() << "on_nodedestination_comboBox_activated complete" ;
 
 }
 
@@ -714,11 +617,12 @@ void MainWindow::on_node_arrivalLat_lineEdit_editingFinished()
 {
     qDebug() << "on_node_arrivalLat_lineEdit_editingFinished()" ;
 
-    Node& node = project.scene(m_currentScene).node(m_currentNode) ;
+    Node node = project.scene(m_currentScene).constNode(m_currentNode) ;
     QString arg1 = ui->node_arrivalLat_lineEdit->text() ;
     int bearing = arg1.toDouble() * 1000 ;
     if (node.arrivalLat()!=bearing) {
         node.setArrivalLat(bearing) ;
+        m_history.setNodeDetails(project, m_currentScene, node) ;
         refreshNodes(m_currentNode) ;
     }
     qDebug() << "on_node_arrivalLat_lineEdit_editingFinished complete" ;
@@ -733,11 +637,12 @@ void MainWindow::on_node_arrivalLon_lineEdit_editingFinished()
 {
     qDebug() << "on_node_arrivalLon_lineEdit_editingFinished()" ;
 
-    Node& node = project.scene(m_currentScene).node(m_currentNode) ;
+    Node node = project.scene(m_currentScene).constNode(m_currentNode) ;
     QString arg1 = ui->node_arrivalLon_lineEdit->text() ;
     int bearing = arg1.toDouble() * 1000 ;
     if (node.arrivalLon()!=bearing) {
         node.setArrivalLon(bearing) ;
+        m_history.setNodeDetails(project, m_currentScene, node) ;
         refreshNodes(m_currentNode) ;
     }
 
@@ -753,10 +658,11 @@ void MainWindow::on_nodetitle_lineEdit_editingFinished()
 {
     qDebug() << "on_nodetitle_lineEdit_editingFinished()" ;
 
-    Node& node = project.scene(m_currentScene).node(m_currentNode) ;
+    Node node = project.scene(m_currentScene).constNode(m_currentNode) ;
     QString text = ui->nodetitle_lineEdit->text() ;
     if (node.title().compare(text)!=0) {
-        node.setTitle(text); ;
+        node.setTitle(text) ;
+        m_history.setNodeDetails(project, m_currentScene, node) ;
         refreshNodes(m_currentNode) ;
     }
 
@@ -773,10 +679,11 @@ void MainWindow::on_nodedescription_plainTextEdit_textChanged()
 {
     qDebug() << "on_nodedescription_plainTextEdit_textChanged()" ;
 
-    Node& node = project.scene(m_currentScene).node(m_currentNode) ;
+    Node node = project.scene(m_currentScene).constNode(m_currentNode) ;
     QString text = ui->nodedescription_plainTextEdit->document()->toPlainText() ;
     if (node.description().compare(text)!=0) {
-        node.setDescription(text); ;
+        node.setDescription(text) ;
+        m_history.setNodeDetails(project, m_currentScene, node, true) ;
         refreshNodes(m_currentNode) ;
     }
 
@@ -792,10 +699,11 @@ void MainWindow::on_nodeUrl_lineEdit_editingFinished()
 {
     qDebug() << "on_nodeUrl_lineEdit_editingFinished()" ;
 
-    Node& node = project.scene(m_currentScene).node(m_currentNode) ;
+    Node node = project.scene(m_currentScene).constNode(m_currentNode) ;
     QString arg1 = ui->nodeUrl_lineEdit->text() ;
     if (node.url().compare(arg1)!=0) {
         node.setUrl(arg1) ;
+        m_history.setNodeDetails(project, m_currentScene, node) ;
         refreshNodes(m_currentNode) ;
     }
 
@@ -812,9 +720,7 @@ void MainWindow::on_nodeSet_pushButton_clicked()
 {
     qDebug() << "on_nodeSet_pushButton_clicked(" << ui->display->lon() << ", " << ui->display->lat() << ")" ;
 
-    Node& node = project.scene(m_currentScene).node(m_currentNode) ;
-    node.setLat(ui->display->lat()) ;
-    node.setLon(ui->display->lon()) ;
+    m_history.moveNode(project, m_currentScene, m_currentNode, ui->display->lat(), ui->display->lon()) ;
     refreshNodes(m_currentNode) ;
 
     qDebug() << "on_nodeSet_pushButton_clicked complete" ;
@@ -829,10 +735,11 @@ void MainWindow::on_nodetype_comboBox_currentIndexChanged(int index)
 {
     qDebug() << "on_nodetype_comboBox_currentIndexChanged( " << index << " )" ;
 
-    Node& node = project.scene(m_currentScene).node(m_currentNode) ;
+    Node node = project.scene(m_currentScene).constNode(m_currentNode) ;
     if (node.type() != index) {
         node.setType((Icon::IconType)index) ;
         if (node.title().isEmpty()) node.setTitle(ui->nodedestination_comboBox->currentText()) ;
+        m_history.setNodeDetails(project, m_currentScene, node) ;
         refreshNodes(m_currentNode) ;
     }
 
@@ -863,19 +770,25 @@ void MainWindow::on_action_Open_Project_triggered()
     on_action_New_Project_triggered();
 
     QString lastdir = settings->value("lastdir", "").toString() ;
-    QString fileName = QFileDialog::getOpenFileName(this, tr("Open Project"), lastdir, tr("Pano Manager Project Files (*pmp)"), Q_NULLPTR, m_fdOptions);
+    QString fileName = QFileDialog::getOpenFileName(this, tr("Open Project"), lastdir, tr("Pano Manager Project Files (*.pmb *.pmp)"), Q_NULLPTR, m_fdOptions);
     if (!fileName.isEmpty()) {
         QFileInfo path(fileName) ;
         project.clear() ;
         ui->display->clearScene() ;
         settings->setValue("lastdir", path.absoluteFilePath()) ;
         settings->setValue("lastfilename", fileName) ;
-        project.OpenProject(fileName) ;
+        if (!project.OpenProject(fileName)) {
+            // Nothing is kept, so a save can't overwrite the file with part of it
+            settings->setValue("lastfilename", "") ;
+            QMessageBox::critical(this, tr("Open Project"), tr("Unable to read the project file, it may be damaged or incomplete:\n") + fileName) ;
+        } else if (project.recoveredChanges()>0) {
+            QMessageBox::information(this, tr("Open Project"), tr("Unsaved changes to this project have been recovered.")) ;
+        }
         ui->scenes_groupBox->setEnabled(true) ;
         ui->display->setCamera(0, 0) ;
         ui->display->setNorthCompassLon(0);
-        refreshScenes("") ;
-        refreshNodes("") ;
+        refreshScenes(Id()) ;
+        refreshNodes(Id()) ;
     }
 
     qDebug() << "on_action_Open_Project_triggered complete" ;
@@ -896,7 +809,7 @@ void MainWindow::on_action_Save_Project_triggered()
         if (fileName.isEmpty()) {
             on_action_Save_Project_As_triggered();
         } else {
-            project.SaveProject(fileName) ;
+            saveProject(fileName) ;
         }
     }
 
@@ -904,6 +817,18 @@ void MainWindow::on_action_Save_Project_triggered()
 
 }
 
+bool MainWindow::saveProject(QString fileName)
+{
+    if (project.SaveProject(fileName)) return true ;
+
+    if (project.isDamaged()) {
+        QMessageBox::critical(this, tr("Save Project"), tr("Part of the project file could not be read, so the project has not been saved, as that would lose it.")) ;
+    } else {
+        QMessageBox::critical(this, tr("Save Project"), tr("Unable to save the project, the changes have not been saved:\n") + fileName) ;
+    }
+    return false ;
+}
+
 //----------------------------------------------------------------------------------------------------------------------
 //
 // on_action_Save_Project_As_triggered
@@ -913,15 +838,15 @@ void MainWindow::on_action_Save_Project_As_triggered()
 {
     qDebug() << "on_action_Save_Project_As_triggered()" ;
 
-    if (project.isDirty()) {
-        QString lastdir = settings->value("lastdir", "").toString() ;
-        QString fileName = QFileDialog::getSaveFileName(this, tr("Save Project"), lastdir, tr("Pano Manager Project Files (*pmp)"), Q_NULLPTR, m_fdOptions) ;
-        if (!fileName.isEmpty()) {
-            QFileInfo path(fileName) ;
-            settings->setValue("lastdir", path.absoluteFilePath()) ;
-            settings->setValue("lastfilename", fileName) ;
-            on_action_Save_Project_triggered();
-        }
+    // Written even when unchanged, so an INI project can be converted to the binary format
+    QString lastdir = settings->value("lastdir", "").toString() ;
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Save Project"), lastdir, tr("Pano Manager Project Files (*.pmb);;Pano Manager INI Project Files (*.pmp)"), Q_NULLPTR, m_fdOptions) ;
+    if (!fileName.isEmpty()) {
+        if (QFileInfo(fileName).suffix().isEmpty()) fileName = fileName + "." + PROJECT_BINARY_SUFFIX ;
+        QFileInfo path(fileName) ;
+        settings->setValue("lastdir", path.absoluteFilePath()) ;
+        settings->setValue("lastfilename", fileName) ;
+        saveProject(fileName) ;
     }
 
     qDebug() << "on_action_Save_Project_As_triggered complete" ;
@@ -943,14 +868,15 @@ void MainWindow::on_action_New_Project_triggered()
 
     ui->display->clearScene() ;
     project.clear() ;
+    m_history.clear() ;
 
     ui->addscene_pushButton->setFocus() ;
 
     settings->setValue("lastfilename", "") ;
     ui->display->setCamera(0, 0) ;
     ui->display->setNorthCompassLon(0);
-    refreshScenes("") ;
-    refreshNodes("") ;
+    refreshScenes(Id()) ;
+    refreshNodes(Id()) ;
 
     qDebug() << "on_action_New_Project_triggered complete" ;
 
@@ -968,40 +894,19 @@ void MainWindow::on_action_New_Project_triggered()
 // on_action_Build_Hi_Res_Scenes_triggered
 //
 
-void MainWindow::handleBuildHiresPercentUpdate(int percent)
-{
-    m_prog.setValue(m_buildHiresPos+percent) ;
-}
-
 void MainWindow::on_action_Build_Hi_Res_Scenes_triggered()
 {
     qDebug() << "on_action_Build_Hi_Res_Scenes_triggered()" ;
 
-    QList<int> scenesList ;
-
-    int numscenes = project.scenes().count() ;
-    for (int i=0; i<numscenes; i++) {
-        scenesList.append(i) ;
-    }
-
-    SceneImage img ;
-    int n = scenesList.size() ;
     m_prog.setTitle("Batch Scene Build") ;
-    m_prog.setMaximum(n*100);
+    m_prog.setMaximum(100);
     m_prog.show() ;
 
-    PM::Err err = PM::Ok ;
+    TourExporter exporter(&project) ;
+    connectExporter(&exporter) ;
+    PM::Err err = exporter.buildScenes(false) ;
+    disconnectExporter(&exporter) ;
 
-    m_buildHiresPos=0 ;
-    for (int i=0; err==PM::Ok && i<n; i++) {
-        int idx = scenesList.at(i) ;
-        Scene& thisScene = project.sceneAt(idx) ;
-        m_prog.setText1("Building Scene: " + thisScene.title()) ;
-        connect(&img, SIGNAL(percentUpdate(int)), this, SLOT(handleBuildHiresPercentUpdate(int))) ;
-        err=DoBuild(thisScene.filename(), &img, i, n, false, false, true, true) ;
-        disconnect(&img, SIGNAL(percentUpdate(int)), this, SLOT(handleBuildHiresPercentUpdate(int))) ;
-        m_buildHiresPos+=100 ;
-    }
     m_prog.hide() ;
     if (err!=PM::Ok) {
         QMessageBox::critical(NULL, "Build Hi-res Error", PM::errString(err)) ;
@@ -1092,6 +997,54 @@ void MainWindow::on_action_Delete_Node_triggered()
     on_nodeDelete_pushButton_clicked();
 }
 
+//======================================================================================================================
+//
+// Menu: Edit
+//
+//  on_action_Undo_triggered    -   Undo the last scene or node edit
+//  on_action_Redo_triggered    -   Redo the last edit undone
+//  showEditedScene             -   Show the scene an undo or redo changed
+//
+
+void MainWindow::on_action_Undo_triggered()
+{
+    qDebug() << "on_action_Undo_triggered()" ;
+    showEditedScene(m_history.undo(project)) ;
+    qDebug() << "on_action_Undo_triggered complete" ;
+}
+
+void MainWindow::on_action_Redo_triggered()
+{
+    qDebug() << "on_action_Redo_triggered()" ;
+    showEditedScene(m_history.redo(project)) ;
+    qDebug() << "on_action_Redo_triggered complete" ;
+}
+
+void MainWindow::showEditedScene(Id sceneId)
+{
+    if (sceneId!=m_currentScene && project.scene(sceneId).isValid()) {
+
+        // Changed (or restored) a different scene, so show it
+        changeScene(sceneId) ;
+        ui->display->setCamera(0, project.scene(m_currentScene).northOffset()) ;
+
+    } else if (!project.scene(m_currentScene).isValid()) {
+
+        // Current scene was removed
+        ui->display->clearScene() ;
+        refreshScenes(Id()) ;
+        ui->display->setNorthCompassLon(0) ;
+        refreshNodes(Id()) ;
+
+    } else {
+
+        refreshScenes(m_currentScene) ;
+        ui->display->setNorthCompassLon(project.scene(m_currentScene).northOffset()) ;
+        refreshNodes(m_currentNode) ;
+
+    }
+}
+
 //======================================================================================================================
 //======================================================================================================================
 //======================================================================================================================
@@ -23,13 +23,19 @@
 
 #include <QMainWindow>
 #include <QSettings>
-#include <QListWidgetItem>
+#include <QModelIndex>
+#include <QSortFilterProxyModel>
 #include <QFileDialog>
+#include <QTimer>
 
 #include "project/project.h"
+#include "project/projecthistory.h"
+#include "widgets/listmodels/scenelistmodel.h"
+#include "widgets/listmodels/nodelistmodel.h"
 #include "sceneimage/sceneimage.h"
 #include "dialogs/progress/progressdialog.h"
 #include "dialogs/webserver/webserver.h"
+#include "export/tourexporter.h"
 
 namespace Ui {
 class MainWindow;
@@ -44,9 +50,6 @@ public:
     ~MainWindow();
     void setOptions(bool useNativeFileDialog) ;
 
-private:
-    QListWidgetItem* findListWidgetItemById(QListWidget *widget, QString id) ;
-
 public slots:
     void on_realBearingChanged(int lat, int lon) ;
 
@@ -61,20 +64,22 @@ private slots:
     void on_nodeAdd_pushButton_clicked();
     void on_setNorth_pushButton_clicked();
     void on_nodetype_comboBox_currentIndexChanged(int index);
-    void on_nodedestination_comboBox_currentIndexChanged(int index);
+    void on_nodedestination_comboBox_activated(int index);
     void on_nodedescription_plainTextEdit_textChanged();
     void on_nodetitle_lineEdit_editingFinished();
     void on_turnAround_pushButton_clicked();
     void on_nodeDelete_pushButton_clicked();
     void on_deletescene_pushButton_clicked();
-    void on_node_listWidget_itemClicked(QListWidgetItem *item);
-    void on_scenes_listWidget_itemClicked(QListWidgetItem *item);
+    void on_node_listView_clicked(const QModelIndex &index);
+    void on_scenes_listView_clicked(const QModelIndex &index);
     void on_nodeGo_pushButton_clicked();    
     void on_node_arrivalLat_lineEdit_editingFinished();
     void on_node_arrivalLon_lineEdit_editingFinished();
     void on_sceneTitle_lineEdit_editingFinished();
     void on_action_ExportPanellum_triggered();
     void on_action_ExportMarzipano_triggered();
+    void on_action_ExportPlan_triggered();
+    void on_action_Import_Tour_triggered();
     void on_action_Properties_triggered();
     void on_nodeUrl_lineEdit_editingFinished();
     void on_action_Web_Server_triggered();
@@ -84,6 +89,8 @@ private slots:
     void on_action_Delete_Scene_triggered();
     void on_action_Add_Node_triggered();
     void on_action_Delete_Node_triggered();
+    void on_action_Undo_triggered();
+    void on_action_Redo_triggered();
 
 
 private:
@@ -93,29 +100,36 @@ private:
     WebServer webserver ;
     SceneImage sceneimage ;
     Project project ;
+    ProjectHistory m_history ;
+    SceneListModel m_sceneModel ;
+    NodeListModel m_nodeModel ;
+    QSortFilterProxyModel m_sceneSort ;     // Lists are shown sorted by title
+    QSortFilterProxyModel m_nodeSort ;
     QSettings *settings;
     Ui::MainWindow *ui;
-    QString m_currentScene ;
-    QString m_currentNode ;
-    int m_buildHiresPos ;
-
-    void changeScene(QString id) ;
-    void refreshScenes(QString selectedScene) ;
-    void refreshNodes(QString selectedNode) ;
+    Id m_currentScene ;
+    Id m_currentNode ;
+    QTimer m_journalTimer ;
+
+    void changeScene(Id id) ;
+    void refreshScenes(Id selectedScene) ;
+    void refreshNodes(Id selectedNode) ;
+    void showEditedScene(Id sceneId) ;
     void buildExportTiles(QString outputFolder, QString mask) ;
     bool checkProject(QString dir) ;
-    PM::Err exportFaces(Scene scene, int tilesize, const char *masks[], QString folder, int *levels, int *cuberesolution, int previewwidth, int *previewsequence) ;
+    bool saveProject(QString fileName) ;
+    void connectExporter(TourExporter *exporter) ;
+    void disconnectExporter(TourExporter *exporter) ;
     PM::Err DoBuild(QString file, SceneImage *scene, int seq, int of, bool loadpreview, bool buildpreview, bool scaleforpreview, bool buildonly) ;
     void exportPanellumFiles(QString folder, QString title);
     void exportMarzipanoFiles(QString folder, QString title);
-    bool copyResourceFolder(QString source, QString dest, bool forceOverwrite) ;
-    bool copyResourceIcons(QString destfolder, int size, bool ignorerotated) ;
-    bool copyFile(QString source, QString dest, bool forceOverwrite) ;
 
 public slots:
     void handleProgressUpdate(QString message) ;
     void handleChangeScenePercentUpdate(int percent) ;
-    void handleBuildHiresPercentUpdate(int percent) ;
+    void handleStageUpdate(QString message) ;
+    void handleExportPercentUpdate(int percent) ;
+    void handleJournalTimer() ;
 
 };
 
@@ -0,0 +1,52 @@
+//    PanoManager - Interactive panorama tour manager program
+//    Copyright (C) 2018  Steve M Clarke
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+//
+// Generation
+//
+// Counts the edits made to a project or scene.  Something is clean when its
+// generation matches the one recorded when it was saved (or journaled), so
+// checking it takes constant time however large the project is.
+//
+// A scene's generation has the project's as its parent, and a node bumps the
+// generation of the scene it was reached through, so an edit to a node is
+// seen by its scene and by the project.
+//
+
+#ifndef GENERATION_H
+#define GENERATION_H
+
+#include <QtGlobal>
+
+class Generation
+{
+private:
+    quint64 m_value ;
+    Generation *m_parent ;
+
+public:
+    Generation() : m_value(0), m_parent(NULL) {}
+
+    // A copy takes the value, but not the parent, which belongs to the original's owner
+    Generation(const Generation& rhs) : m_value(rhs.m_value), m_parent(NULL) {}
+    Generation& operator=(const Generation& rhs) { m_value = rhs.m_value ; return *this ; }
+
+    void setParent(Generation *parent) { m_parent = parent ; }
+    void bump() { m_value++ ; if (m_parent) m_parent->bump() ; }
+    quint64 value() const { return m_value ; }
+};
+
+#endif // GENERATION_H
@@ -0,0 +1,92 @@
+//    PanoManager - Interactive panorama tour manager program
+//    Copyright (C) 2018  Steve M Clarke
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+//
+// Id
+//
+
+#include "id.h"
+#include <QUuid>
+
+Id::Id()
+{
+    m_hi = 0 ;
+    m_lo = 0 ;
+}
+
+Id Id::create()
+{
+    return fromBytes(QUuid::createUuid().toRfc4122()) ;
+}
+
+Id Id::fromString(QString str)
+{
+    Id id ;
+    int digits = 0 ;
+    for (int i=0; i<str.length(); i++) {
+        ushort c = str.at(i).unicode() ;
+        int v ;
+        if (c>='0' && c<='9') v = c - '0' ;
+        else if (c>='a' && c<='f') v = c - 'a' + 10 ;
+        else if (c>='A' && c<='F') v = c - 'A' + 10 ;
+        else if (c=='{' || c=='}' || c=='-') continue ;
+        else return Id() ;
+        if (digits<16) id.m_hi = (id.m_hi << 4) | v ;
+        else if (digits<32) id.m_lo = (id.m_lo << 4) | v ;
+        digits++ ;
+    }
+    if (digits!=32) return Id() ;
+    return id ;
+}
+
+Id Id::fromBytes(const QByteArray& bytes)
+{
+    Id id ;
+    if (bytes.size()!=16) return id ;
+    for (int i=0; i<8; i++) id.m_hi = (id.m_hi << 8) | (uchar)bytes.at(i) ;
+    for (int i=8; i<16; i++) id.m_lo = (id.m_lo << 8) | (uchar)bytes.at(i) ;
+    return id ;
+}
+
+void Id::registerMetaType()
+{
+    qRegisterMetaType<Id>("Id") ;
+    QMetaType::registerComparators<Id>() ;
+}
+
+QString Id::toString() const
+{
+    if (isNull()) return QString() ;
+
+    static const char hex[] = "0123456789abcdef" ;
+    char text[32] ;
+    for (int i=0; i<16; i++) text[i] = hex[(m_hi >> (60-i*4)) & 0xf] ;
+    for (int i=0; i<16; i++) text[16+i] = hex[(m_lo >> (60-i*4)) & 0xf] ;
+    return QString::fromLatin1(text, 32) ;
+}
+
+QByteArray Id::toBytes() const
+{
+    QByteArray bytes(16, 0) ;
+    for (int i=0; i<8; i++) bytes[i] = (char)(m_hi >> (56-i*8)) ;
+    for (int i=0; i<8; i++) bytes[8+i] = (char)(m_lo >> (56-i*8)) ;
+    return bytes ;
+}
+
+bool Id::isNull() const
+{
+    return m_hi==0 && m_lo==0 ;
+}
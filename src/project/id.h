@@ -0,0 +1,63 @@
+//    PanoManager - Interactive panorama tour manager program
+//    Copyright (C) 2018  Steve M Clarke
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+//
+// Id
+//
+// Identifies a scene or node.  The 128 bit UUID is held as two integers, so
+// ids are cheap to copy, compare and hash.  They are only converted to text
+// (32 lower case hex digits, the UUID without braces or dashes) when they are
+// saved, or written into an export.
+//
+
+#ifndef ID_H
+#define ID_H
+
+#include <QString>
+#include <QByteArray>
+#include <QMetaType>
+#include <QtGlobal>
+
+class Id
+{
+private:
+    quint64 m_hi, m_lo ;
+
+public:
+    Id() ;                                  // The null id
+
+    static Id create() ;                    // A new, random, id
+    static Id fromString(QString str) ;     // Braces and dashes are ignored.  Null if not a UUID
+    static Id fromBytes(const QByteArray& bytes) ;
+    static void registerMetaType() ;        // Allows ids to be compared as QVariants (e.g. Qt::UserRole data)
+
+    QString toString() const ;              // Empty for the null id
+    QByteArray toBytes() const ;            // 16 bytes, big endian
+    bool isNull() const ;
+
+    // UUIDs are random, so folding the bits together is enough
+    uint hash() const { quint64 x = m_hi ^ m_lo ; return (uint)(x ^ (x >> 32)) ; }
+
+    bool operator==(const Id& rhs) const { return m_hi==rhs.m_hi && m_lo==rhs.m_lo ; }
+    bool operator!=(const Id& rhs) const { return m_hi!=rhs.m_hi || m_lo!=rhs.m_lo ; }
+    bool operator<(const Id& rhs) const { return m_hi<rhs.m_hi || (m_hi==rhs.m_hi && m_lo<rhs.m_lo) ; }
+};
+
+inline uint qHash(const Id& id, uint seed=0) { return id.hash() ^ seed ; }
+
+Q_DECLARE_METATYPE(Id)
+
+#endif // ID_H
@@ -19,12 +19,29 @@
 //
 
 #include "node.h"
-#include <QUuid>
 #include "../icons/icons.h"
 
-Node::Node(bool isinvalid)
+#include <QSharedData>
+
+class NodeData : public QSharedData
+{
+public:
+    bool invalid, dirty, empty ;
+    bool journalPending ;               // Changed since last written to the project journal
+    Id id ;
+    Icon::IconType type ;
+    int lat, lon ;          // in millidegrees
+    QString title ;
+    QString description ;
+    Id destId ;
+    QString url ;
+    int arrivalLat, arrivalLon ;            // in millidegrees
+};
+
+Node::Node(bool isinvalid) : d(new NodeData)
 {
-    m_invalid = isinvalid ;
+    d->invalid = isinvalid ;
+    m_owner = NULL ;
     clear() ;
 }
 
@@ -32,219 +49,240 @@ Node::~Node()
 {
 }
 
-Node::Node(const Node& rhs)
+// Copies are not owned by a scene until they are added to one
+Node::Node(const Node& rhs) : d(rhs.d)
 {
-    *this = rhs ;
+    m_owner = NULL ;
 }
 
 Node& Node::operator=(const Node& rhs)
 {
-    m_invalid = rhs.m_invalid ;
-    m_dirty = rhs.m_dirty ;
-    m_empty = rhs.m_empty ;
-    m_id = rhs.m_id ;
-    m_type = rhs.m_type ;
-    m_lat = rhs.m_lat ;
-    m_lon = rhs.m_lon ;
-    m_title = rhs.m_title ;
-    m_description = rhs.m_description ;
-    m_destId = rhs.m_destId ;
-    m_url = rhs.m_url ;
-    m_arrivalLat = rhs.m_arrivalLat ;
-    m_arrivalLon = rhs.m_arrivalLon ;
+    d = rhs.d ;
     return *this ;
 }
 
-Icon::IconType Node::type()
+Icon::IconType Node::type() const
 {
-    return m_type ;
+    return d->type ;
 }
 
-int Node::lat()
+int Node::lat() const
 {
-    return m_lat ;
+    return d->lat ;
 }
 
-int Node::lon()
+int Node::lon() const
 {
-    return m_lon ;
+    return d->lon ;
 }
 
-int Node::arrivalLat()
+int Node::arrivalLat() const
 {
-    return m_arrivalLat ;
+    return d->arrivalLat ;
 }
 
-int Node::arrivalLon()
+int Node::arrivalLon() const
 {
-    return m_arrivalLon ;
+    return d->arrivalLon ;
 }
 
-QString Node::title()
+QString Node::title() const
 {
-    return m_title ;
+    return d->title ;
 }
 
-QString Node::description()
+QString Node::description() const
 {
-    return m_description ;
+    return d->description ;
 }
 
-QString Node::url()
+QString Node::url() const
 {
-    return m_url ;
+    return d->url ;
 }
 
-QString Node::destId()
+Id Node::destId() const
 {
-    return m_destId ;
+    return d->destId ;
 }
 
-QString Node::id()
+Id Node::id() const
 {
-    return m_id ;
+    return d->id ;
 }
 
-bool Node::isEmpty()
+bool Node::isEmpty() const
 {
-    return m_empty ;
+    return d->empty ;
 }
 
-bool Node::isValid()
+bool Node::isValid() const
 {
-    return !m_invalid ;
+    return !d->invalid ;
 }
 
-bool Node::isDirty()
+bool Node::isDirty() const
 {
-    return m_dirty ;
+    return d->dirty ;
+}
+
+bool Node::journalPending() const
+{
+    return d->journalPending ;
 }
 
 void Node::setType(Icon::IconType type)
 {
-    if (m_invalid) return ;
-    m_type = type ;
-    m_empty=false ;
-    m_dirty=true ;
+    if (!isValid()) return ;
+    d->type = type ;
+    d->empty=false ;
+    changed() ;
 }
 
-bool Node::isLink()
+bool Node::isLink() const
 {
-    Icon::Group g = Icon::textureGroup(m_type) ;
+    Icon::Group g = Icon::textureGroup(d->type) ;
     return (g == Icon::GLink || g == Icon::GExit) ;
 }
 
-bool Node::isInfo()
+bool Node::isInfo() const
 {
-    Icon::Group g = Icon::textureGroup(m_type) ;
+    Icon::Group g = Icon::textureGroup(d->type) ;
     return (g == Icon::GInfo) ;
 }
 
-bool Node::isMedia()
+bool Node::isMedia() const
 {
-    Icon::Group g = Icon::textureGroup(m_type) ;
+    Icon::Group g = Icon::textureGroup(d->type) ;
     return (g == Icon::GMedia) ;
 }
 
-bool Node::isMusic()
+bool Node::isMusic() const
 {
-    Icon::Group g = Icon::textureGroup(m_type) ;
+    Icon::Group g = Icon::textureGroup(d->type) ;
     return (g == Icon::GMusic) ;
 }
 
 void Node::setLat(int lat)
 {
-    if (m_invalid) return ;
-    m_lat = lat ;
-    m_empty=false ;
-    m_dirty=true ;
+    if (!isValid()) return ;
+    d->lat = lat ;
+    d->empty=false ;
+    changed() ;
 }
 
 void Node::setLon(int lon)
 {
-    if (m_invalid) return ;
-    m_lon = lon ;
-    m_empty=false ;
-    m_dirty=true ;
+    if (!isValid()) return ;
+    d->lon = lon ;
+    d->empty=false ;
+    changed() ;
 }
 
 void Node::setArrivalLat(int lat)
 {
-    if (m_invalid) return ;
-    m_arrivalLat = lat ;
-    m_empty=false ;
-    m_dirty=true ;
+    if (!isValid()) return ;
+    d->arrivalLat = lat ;
+    d->empty=false ;
+    changed() ;
 }
 
 void Node::setArrivalLon(int lon)
 {
-    if (m_invalid) return ;
-    m_arrivalLon = lon ;
-    m_empty=false ;
-    m_dirty=true ;
+    if (!isValid()) return ;
+    d->arrivalLon = lon ;
+    d->empty=false ;
+    changed() ;
 }
 
-void Node:: setDestId(QString id)
+void Node::setDestId(Id id)
 {
-    if (m_invalid || id.isEmpty() || id.length()<10) return ;
-    m_destId = id.replace("{","").replace("}","").replace("-","") ;
-    m_empty=false ;
-    m_dirty=true ;
+    if (!isValid() || id.isNull()) return ;
+    d->destId = id ;
+    d->empty=false ;
+    changed() ;
 }
 
 void Node::setUrl(QString url)
 {
-    if (m_invalid) return ;
-    m_url = url ;
-    m_empty=false ;
-    m_dirty=true ;
+    if (!isValid()) return ;
+    d->url = url ;
+    d->empty=false ;
+    changed() ;
 }
 
 void Node::setDescription(QString desc)
 {
-    if (m_invalid) return ;
-    m_description = desc ;
-    m_empty=false ;
-    m_dirty=true ;
+    if (!isValid()) return ;
+    d->description = desc ;
+    d->empty=false ;
+    changed() ;
 }
 
 void Node::setTitle(QString title)
 {
-    if (m_invalid) return ;
-    m_title = title ;
-    m_empty=false ;
-    m_dirty=true ;
+    if (!isValid()) return ;
+    d->title = title ;
+    d->empty=false ;
+    changed() ;
 }
 
-void Node::setId(QString id)
+void Node::setId(Id id)
 {
-    if (m_invalid || id.isEmpty() || id.length()<10) return ;
-    m_id = id.replace("{","").replace("}","").replace("-","") ;
+    if (!isValid() || id.isNull()) return ;
+    d->id = id ;
 }
 
+// Checked first, so that marking a shared node clean doesn't copy it
 void Node::markClean()
 {
-    m_dirty = false ;
+    if (!isDirty() && !journalPending()) return ;
+    d->dirty = false ;
+    d->journalPending = false ;
+}
+
+void Node::markJournaled()
+{
+    if (!journalPending()) return ;
+    d->journalPending = false ;
+}
+
+// An edit, as far as the scene and project are concerned
+void Node::markUnjournaled()
+{
+    changed() ;
+}
+
+void Node::setOwner(Generation *owner)
+{
+    m_owner = owner ;
+}
+
+void Node::changed()
+{
+    d->dirty = true ;
+    d->journalPending = true ;
+    if (m_owner) m_owner->bump() ;
 }
 
 void Node::clear()
 {
-    QUuid uuid ;
-    if (m_invalid)
-        setId(uuid.toString()) ;
+    if (d->invalid)
+        d->id = Id() ;
     else
-        setId(uuid.createUuid().toString()) ;
-
-    m_empty = true ;
-    m_dirty = true ;
-
-    m_type = Icon::WInfo ;
-    m_lat = 0 ;
-    m_lon = 0 ;
-    m_description.clear() ;
-    m_destId.clear() ;
-    m_arrivalLat = 0 ;
-    m_arrivalLon = 0 ;
-    m_url = "" ;
+        d->id = Id::create() ;
+
+    d->empty = true ;
+    d->dirty = true ;
+    d->journalPending = true ;
+
+    d->type = Icon::WInfo ;
+    d->lat = 0 ;
+    d->lon = 0 ;
+    d->description.clear() ;
+    d->destId = Id() ;
+    d->arrivalLat = 0 ;
+    d->arrivalLon = 0 ;
+    d->url = "" ;
 
 }
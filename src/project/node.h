@@ -23,20 +23,22 @@
 
 #include <QString>
 #include <QList>
+#include <QSharedDataPointer>
 #include "../icons/icons.h"
+#include "id.h"
+#include "generation.h"
 
+class NodeData ;
+
+// Nodes are implicitly shared, so copying one only copies a pointer.  The data
+// is copied when a shared node is first changed.
 class Node
 {
 private:
-    bool m_invalid, m_dirty, m_empty ;
-    QString m_id ;
-    Icon::IconType m_type ;
-    int m_lat, m_lon ;      // in millidegrees
-    QString m_title ;
-    QString m_description ;
-    QString m_destId ;
-    QString m_url ;
-    int m_arrivalLat, m_arrivalLon ;        // in millidegrees
+    QSharedDataPointer<NodeData> d ;
+    Generation *m_owner ;               // Generation of the scene the node was last reached through
+
+    void changed() ;
 
 public:
     Node(bool isinvalid=false);
@@ -45,38 +47,42 @@ public:
     Node& operator=(const Node& rhs) ;
 
 public:
-    Icon::IconType type() ;
-    int lat() ;
-    int lon() ;
-    QString description() ;
-    QString title() ;
-    int arrivalLat() ;
-    int arrivalLon() ;
-    QString destId() ;
-    QString url() ;
-    QString id() ;
+    Icon::IconType type() const ;
+    int lat() const ;
+    int lon() const ;
+    QString description() const ;
+    QString title() const ;
+    int arrivalLat() const ;
+    int arrivalLon() const ;
+    Id destId() const ;
+    QString url() const ;
+    Id id() const ;
 
-    bool isEmpty() ;
-    bool isValid() ;
-    bool isDirty() ;
+    bool isEmpty() const ;
+    bool isValid() const ;
+    bool isDirty() const ;
+    bool journalPending() const ;
 
     void setType(Icon::IconType type) ;
 
-    bool isLink() ;
-    bool isInfo() ;
-    bool isMedia() ;
-    bool isMusic() ;
+    bool isLink() const ;
+    bool isInfo() const ;
+    bool isMedia() const ;
+    bool isMusic() const ;
 
     void setLat(int lat) ;
     void setLon(int lon) ;
     void setArrivalLat(int lat) ;
     void setArrivalLon(int lon) ;
-    void setDestId(QString id) ;
+    void setDestId(Id id) ;
     void setUrl(QString url) ;
     void setTitle(QString title) ;
     void setDescription(QString desc) ;
-    void setId(QString id) ;
+    void setId(Id id) ;
     void markClean();
+    void markJournaled() ;
+    void markUnjournaled() ;            // Write the whole node to the journal again, e.g. when restored
+    void setOwner(Generation *owner) ;  // Called by Scene whenever it hands out the node
     void clear() ;
 
     //int operator==(const Node &rhs) const;
@@ -27,6 +27,8 @@
 
 Project::Project() : m_invalidScene(true)
 {
+    m_lazyLoad = false ;
+    m_observing = true ;
     clear() ;
 }
 
@@ -40,7 +42,7 @@ int Project::sceneCount()
     return m_scenes.count() ;
 }
 
-SceneList& Project::scenes()
+const SceneList& Project::scenes()
 {
     return m_scenes ;
 }
@@ -48,50 +50,242 @@ SceneList& Project::scenes()
 Scene& Project::sceneAt(int num)
 {
     if (num<0 || num>=m_scenes.count()) return m_invalidScene ;
-    else return m_scenes[num] ;
+    Scene& sc = m_scenes[num] ;
+    sc.setOwner(&m_generation, observers()) ;
+    return sc ;
 }
 
-Scene& Project::scene(QString id)
+Scene& Project::scene(Id id)
 {
-    for (int i=0; i<m_scenes.count(); i++) {
-        if (m_scenes[i].id().compare(id)==0) return m_scenes[i] ;
-    }
-    return m_invalidScene ;
+    return sceneAt(sceneIndex(id)) ;
+}
+
+int Project::sceneIndex(Id id)
+{
+    QHash<Id, int>::const_iterator it = m_sceneIndex.constFind(id) ;
+    if (it==m_sceneIndex.constEnd()) return -1 ;
+    return it.value() ;
+}
+
+Scene& Project::addScene(const Scene& scene)
+{
+    if (m_observing) foreach (ProjectObserver *o, m_observers) o->sceneInserting(m_scenes.count()) ;
+    m_scenes.append(scene) ;
+    Scene& added = m_scenes.last() ;
+    added.setOwner(&m_generation, observers()) ;
+    if (!m_sceneIndex.contains(added.id())) m_sceneIndex.insert(added.id(), m_scenes.count()-1) ;
+    m_empty=false ;
+    m_generation.bump() ;
+    if (m_observing) foreach (ProjectObserver *o, m_observers) o->sceneInserted() ;
+    return added ;
+}
+
+bool Project::removeScene(Id id)
+{
+    int num = sceneIndex(id) ;
+    if (num<0) return false ;
+    if (m_observing) foreach (ProjectObserver *o, m_observers) o->sceneRemoving(num) ;
+    m_scenes.removeAt(num) ;
+    reindexScenes() ;
+    m_removedScenes.append(id) ;
+    m_generation.bump() ;
+    if (m_observing) foreach (ProjectObserver *o, m_observers) o->sceneRemoved() ;
+    return true ;
 }
 
-bool Project::removeScene(QString id)
+bool Project::moveScene(int from, int to)
 {
+    if (from<0 || from>=m_scenes.count() || to<0 || to>=m_scenes.count()) return false ;
+    if (from==to) return true ;
+    if (m_observing) foreach (ProjectObserver *o, m_observers) o->sceneMoving(from, to) ;
+    m_scenes.move(from, to) ;
+    reindexScenes() ;
+    m_sceneOrderPending=true ;
+    m_generation.bump() ;
+    if (m_observing) foreach (ProjectObserver *o, m_observers) o->sceneMoved() ;
+    return true ;
+}
+
+void Project::addObserver(ProjectObserver *observer)
+{
+    if (observer && !m_observers.contains(observer)) m_observers.append(observer) ;
+}
+
+void Project::removeObserver(ProjectObserver *observer)
+{
+    m_observers.removeAll(observer) ;
+}
+
+// Handed to scenes, so they report node changes too
+const ProjectObserverList *Project::observers()
+{
+    if (!m_observing) return NULL ;
+    return &m_observers ;
+}
+
+// Rebuild the id index after scenes have moved, keeping the first of any duplicate ids
+void Project::reindexScenes()
+{
+    m_sceneIndex.clear() ;
+    m_sceneIndex.reserve(m_scenes.count()) ;
     for (int i=0; i<m_scenes.count(); i++) {
-        if (m_scenes[i].id().compare(id)==0) {
-            m_scenes.removeAt(i) ;
-            return true ;
-        }
+        Id id = m_scenes[i].id() ;
+        if (!m_sceneIndex.contains(id)) m_sceneIndex.insert(id, i) ;
     }
-    return false ;
 }
 
+//----------------------------------------------------------------------------------------------------------------------
+//
+// OpenProject / SaveProject - Load and save binary (.pmb) projects, or INI (.pmp) projects
+//
+
 bool Project::OpenProject(QString path)
 {
+    // Observers see opening as one reset, rather than every scene being added
+    foreach (ProjectObserver *o, m_observers) o->projectResetting() ;
+    m_observing = false ;
     clear() ;
     m_projectpath = path ;
 
+    bool ok ;
+    if (isBinaryProject(path)) ok = openBinary(path) ;
+    else ok = openIni(path) ;
+
+    if (ok) {
+        reindexScenes() ;
+
+        for (int i=0; i<m_scenes.count(); i++) m_scenes[i].markClean() ;
+        m_empty = false ;
+        m_cleanGeneration = m_generation.value() ;
+        m_journaledGeneration = m_generation.value() ;
+
+        // Recover any edits which were not saved
+        m_journaledSettings = settingsMap() ;
+        m_recovered = replayJournal() ;
+    } else {
+        // A partly read project is never left open, as saving it would lose the rest
+        clear() ;
+    }
+
+    m_observing = true ;
+    foreach (ProjectObserver *o, m_observers) o->projectReset() ;
+    return ok ;
+}
+
+bool Project::SaveProject(QString path)
+{
+    // A clean project is still written to a new path, e.g. to convert it to the binary format
+    if (path.isEmpty()) path = m_projectpath ;
+    if (!isDirty() && path==m_projectpath) return true ;
+
+    // Every scene's nodes are needed, and the file they would be read from may be replaced
+    for (int i=0; i<m_scenes.count(); i++) m_scenes[i].nodes() ;
+    if (isDamaged()) return false ;
+
+    QString oldpath = m_projectpath ;
+    m_projectpath = path ;
+
+    bool ok ;
+    if (QFileInfo(path).suffix().compare(PROJECT_BINARY_SUFFIX, Qt::CaseInsensitive)==0) ok = saveBinary(path) ;
+    else ok = saveIni(path) ;
+    if (!ok) {
+        // Still dirty, and still belonging to the file it was opened from
+        m_projectpath = oldpath ;
+        return false ;
+    }
+
+    // Every edit is now in the project file
+    if (!oldpath.isEmpty() && oldpath!=path) m_journal.remove(oldpath) ;
+    m_journal.remove(path) ;
+    m_journaledSettings = settingsMap() ;
+    m_removedScenes.clear() ;
+    m_sceneOrderPending=false ;
+
+    for (int i=0; i<m_scenes.count(); i++) m_scenes[i].markClean();
+    m_cleanGeneration = m_generation.value() ;
+    m_journaledGeneration = m_generation.value() ;
+    return true ;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// settingsMap / applySettings - Tour settings, by their file key
+//
+
+QVariantMap Project::settingsMap()
+{
+    QVariantMap settings ;
+    settings.insert("title", m_title) ;
+    settings.insert("author", m_author) ;
+    settings.insert("startingScene", m_startingSceneId.toString()) ;
+    settings.insert("startingSceneLat", m_startingSceneLat) ;
+    settings.insert("startingSceneLon", m_startingSceneLon) ;
+    settings.insert("autoRotate", m_autoRotate) ;
+    settings.insert("sceneFade", m_sceneFade) ;
+    settings.insert("compass", m_compass) ;
+    settings.insert("autoLoad", m_autoLoad) ;
+    settings.insert("debug", m_debug) ;
+    settings.insert("packTiles", m_packTiles) ;
+    settings.insert("tileFormat", m_tileFormat) ;
+    settings.insert("jpegQuality", m_jpegQuality) ;
+    settings.insert("jpeg444", m_jpeg444) ;
+    settings.insert("jpegOptimize", m_jpegOptimize) ;
+    settings.insert("jpegProgressive", m_jpegProgressive) ;
+    settings.insert("compressAssets", m_compressAssets) ;
+    settings.insert("sceneFiles", m_sceneFiles) ;
+    settings.insert("offlineCache", m_offlineCache) ;
+    settings.insert("faceSizing", m_faceSizing) ;
+    settings.insert("maxFaceSize", m_maxFaceSize) ;
+    return settings ;
+}
+
+// Missing keys keep their clear() defaults
+void Project::applySettings(const QVariantMap& settings)
+{
+    m_title = settings.value("title", m_title).toString() ;
+    m_author = settings.value("author", m_author).toString() ;
+    m_startingSceneId = Id::fromString(settings.value("startingScene", m_startingSceneId.toString()).toString()) ;
+    m_startingSceneLat = settings.value("startingSceneLat", m_startingSceneLat).toInt() ;
+    m_startingSceneLon = settings.value("startingSceneLon", m_startingSceneLon).toInt() ;
+    m_autoRotate = settings.value("autoRotate", m_autoRotate).toInt() ;
+    m_sceneFade = settings.value("sceneFade", m_sceneFade).toInt() ;
+    m_compass = settings.value("compass", m_compass).toBool() ;
+    m_autoLoad = settings.value("autoLoad", m_autoLoad).toBool() ;
+    m_debug = settings.value("debug", m_debug).toBool() ;
+    m_packTiles = settings.value("packTiles", m_packTiles).toBool() ;
+    m_tileFormat = settings.value("tileFormat", m_tileFormat).toString() ;
+    m_jpegQuality = settings.value("jpegQuality", m_jpegQuality).toInt() ;
+    m_jpeg444 = settings.value("jpeg444", m_jpeg444).toBool() ;
+    m_jpegOptimize = settings.value("jpegOptimize", m_jpegOptimize).toBool() ;
+    m_jpegProgressive = settings.value("jpegProgressive", m_jpegProgressive).toBool() ;
+    m_compressAssets = settings.value("compressAssets", m_compressAssets).toBool() ;
+    m_sceneFiles = settings.value("sceneFiles", m_sceneFiles).toBool() ;
+    m_offlineCache = settings.value("offlineCache", m_offlineCache).toBool() ;
+    m_faceSizing = settings.value("faceSizing", m_faceSizing).toString() ;
+    m_maxFaceSize = settings.value("maxFaceSize", m_maxFaceSize).toInt() ;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// openIni / saveIni - INI (.pmp) projects, one QSettings key per value
+//
+
+bool Project::openIni(QString path)
+{
     // Get the project folder
     QFileInfo projFileInfo(path) ;
     QDir projDir(projFileInfo.absoluteDir()) ;
+    if (!projFileInfo.exists()) return false ;
 
     QSettings project(path, QSettings::IniFormat) ;
     int numScenes = project.value("numScenes", (int)0).toInt() ;
 
-    m_title = project.value("title", QString("")).toString() ;
-    m_author = project.value("author", QString("")).toString() ;
-    m_startingSceneId = project.value("startingScene", QString("")).toString() ;
-    m_startingSceneLat = project.value("startingSceneLat", (int)0).toInt() ;
-    m_startingSceneLon = project.value("startingSceneLon", (int)0).toInt() ;
-    m_autoRotate = project.value("autoRotate", (int)5000).toInt() ;
-    m_sceneFade = project.value("sceneFade", (int)2000).toInt() ;
-    m_compass = project.value("compass", false).toBool() ;
-    m_autoLoad = project.value("autoLoad", true).toBool() ;
-    m_debug = project.value("debug", false).toBool() ;
+    QVariantMap settings ;
+    QVariantMap defaults = settingsMap() ;
+    for (QVariantMap::const_iterator it = defaults.constBegin(); it!=defaults.constEnd(); ++it) {
+        if (project.contains(it.key())) settings.insert(it.key(), project.value(it.key())) ;
+    }
+    applySettings(settings) ;
 
     for (int s=0; s<numScenes; s++) {
 
@@ -104,7 +298,7 @@ bool Project::OpenProject(QString path)
             Node newNode ;
             QString nodePrefix = scenePrefix + QString("node_") + QString::number(n) + QString("_") ;
 
-            newNode.setId(project.value(nodePrefix + "id", 0).toString()) ;
+            newNode.setId(Id::fromString(project.value(nodePrefix + "id", 0).toString())) ;
             int type = project.value(nodePrefix + "type", 0).toInt() ;
             if (type<0 || type>=Icon::numTextures) type=0 ;
             newNode.setType((Icon::IconType)type);
@@ -114,9 +308,9 @@ bool Project::OpenProject(QString path)
             newNode.setArrivalLon(project.value(nodePrefix + "arrivalLon", 0).toInt()) ;
             newNode.setTitle(project.value(nodePrefix + "title", "").toString()) ;
             newNode.setDescription(project.value(nodePrefix + "description", "").toString()) ;
-            newNode.setDestId(project.value(nodePrefix + "destId", 0).toString()) ;
+            newNode.setDestId(Id::fromString(project.value(nodePrefix + "destId", 0).toString())) ;
             newNode.setUrl(project.value(nodePrefix + "url", "").toString()) ;
-            newScene.nodes().append(newNode) ;
+            newScene.addNode(newNode) ;
         }
 
         // Load relative filename and convert to absolute path
@@ -126,20 +320,20 @@ bool Project::OpenProject(QString path)
 
         newScene.setTitle(project.value(scenePrefix + QString("sceneName")).toString()) ;
         newScene.setNorthOffset(project.value(scenePrefix + QString("northOffsetLon")).toInt()) ;
-        newScene.setId(project.value(scenePrefix + QString("id")).toString()) ;
+        newScene.setId(Id::fromString(project.value(scenePrefix + QString("id")).toString())) ;
         m_scenes.append(newScene) ;
 
     }
-    m_empty = false ;
-    m_dirty = false ;
-    return true ;
+    return project.status()==QSettings::NoError ;
 }
 
 void Project::clear()
 {
+    if (m_observing) foreach (ProjectObserver *o, m_observers) o->projectResetting() ;
+
     m_title.clear() ;
     m_author.clear() ;
-    m_startingSceneId.clear() ;
+    m_startingSceneId = Id() ;
     m_startingSceneLat=0 ;
     m_startingSceneLon=0 ;
     m_autoRotate=5000 ;
@@ -147,19 +341,36 @@ void Project::clear()
     m_compass=false ;
     m_autoLoad=true ;
     m_debug=false ;
+    m_packTiles=false ;
+    m_tileFormat=QString("jpg") ;
+    m_jpegQuality=75 ;
+    m_jpeg444=false ;
+    m_jpegOptimize=true ;
+    m_jpegProgressive=false ;
+    m_compressAssets=false ;
+    m_sceneFiles=false ;
+    m_offlineCache=false ;
+    m_faceSizing=QString("height") ;
+    m_maxFaceSize=0 ;
     m_overwriteLibrary=false ;
 
     m_scenes.clear() ;
-    m_dirty=false ;
+    m_sceneIndex.clear() ;
+    m_journal.close() ;
+    m_journaledSettings = settingsMap() ;
+    m_removedScenes.clear() ;
+    m_sceneOrderPending=false ;
+    m_recovered=0 ;
+    m_projectpath.clear() ;
+    m_cleanGeneration = m_generation.value() ;
+    m_journaledGeneration = m_generation.value() ;
     m_empty=true ;
+
+    if (m_observing) foreach (ProjectObserver *o, m_observers) o->projectReset() ;
 }
 
-bool Project::SaveProject(QString path)
+bool Project::saveIni(QString path)
 {
-    if (!isDirty() || isEmpty()) return true ;
-    if (path.isEmpty()) path = m_projectpath ;
-    m_projectpath = path ;
-
     // Get the project folder
     QFileInfo projFileInfo(path) ;
     QDir projDir(projFileInfo.absoluteDir()) ;
@@ -170,23 +381,17 @@ bool Project::SaveProject(QString path)
     int numScenes = m_scenes.count() ;
     project.setValue("numScenes", numScenes) ;
 
-    project.setValue("title", m_title) ;
-    project.setValue("author", m_author) ;
-    project.setValue("startingScene", m_startingSceneId) ;
-    project.setValue("startingSceneLat", m_startingSceneLat) ;
-    project.setValue("startingSceneLon", m_startingSceneLon) ;
-    project.setValue("autoRotate", m_autoRotate) ;
-    project.setValue("sceneFade", m_sceneFade) ;
-    project.setValue("compass", m_compass) ;
-    project.setValue("autoLoad", m_autoLoad) ;
-    project.setValue("debug", m_debug) ;
+    QVariantMap settings = settingsMap() ;
+    for (QVariantMap::const_iterator it = settings.constBegin(); it!=settings.constEnd(); ++it) {
+        project.setValue(it.key(), it.value()) ;
+    }
 
     for (int s=0; s<numScenes; s++) {
 
         QString scenePrefix = QString("scene_") + QString::number(s) + QString("_") ;
         Scene& sc = sceneAt(s) ;
 
-        project.setValue(scenePrefix + "id", sc.id()) ;
+        project.setValue(scenePrefix + "id", sc.id().toString()) ;
 
         // Save relative image filename
         QString imageFileName = QDir::cleanPath(sc.filename()) ;
@@ -201,10 +406,10 @@ bool Project::SaveProject(QString path)
 
         for (int n=0; n<numNodes; n++) {
 
-            Node& nd = sc.nodeAt(n) ;
+            const Node& nd = sc.constNodeAt(n) ;
             QString nodePrefix = scenePrefix + QString("node_") + QString::number(n) + QString("_") ;
 
-            project.setValue(nodePrefix + "id", nd.id()) ;
+            project.setValue(nodePrefix + "id", nd.id().toString()) ;
             project.setValue(nodePrefix + "type", (int)nd.type()) ;
             project.setValue(nodePrefix + "lat", nd.lat()) ;
             project.setValue(nodePrefix + "lon", nd.lon()) ;
@@ -212,20 +417,19 @@ bool Project::SaveProject(QString path)
             project.setValue(nodePrefix + "arrivalLon", nd.arrivalLon()) ;
             project.setValue(nodePrefix + "title", nd.title()) ;
             project.setValue(nodePrefix + "description", nd.description()) ;
-            project.setValue(nodePrefix + "destId", nd.destId()) ;
+            project.setValue(nodePrefix + "destId", nd.destId().toString()) ;
             project.setValue(nodePrefix + "url", nd.url()) ;
 
         }
     }
-    m_dirty=false ;
-    for (int i=0; i<m_scenes.count(); i++) m_scenes[i].markClean();
-    return true ;
+    project.sync() ;
+    return project.status()==QSettings::NoError ;
 }
 
 
 QString Project::title() { return m_title ; }
 QString Project::author() { return m_author ; }
-QString Project::startingSceneId() { return m_startingSceneId ; }
+Id Project::startingSceneId() { return m_startingSceneId ; }
 int Project::startingSceneLat() { return m_startingSceneLat ; }
 int Project::startingSceneLon() { return m_startingSceneLon ; }
 int Project::autoRotate() { return m_autoRotate ; }
@@ -233,12 +437,29 @@ int Project::sceneFade() { return m_sceneFade ; }
 bool Project::compass() { return m_compass ; }
 bool Project::autoLoad() { return m_autoLoad ; }
 bool Project::debug() { return m_debug ; }
+bool Project::packTiles() { return m_packTiles ; }
+QString Project::tileFormat() { return m_tileFormat ; }
+int Project::jpegQuality() { return m_jpegQuality ; }
+bool Project::jpeg444() { return m_jpeg444 ; }
+bool Project::jpegOptimize() { return m_jpegOptimize ; }
+bool Project::jpegProgressive() { return m_jpegProgressive ; }
+bool Project::compressAssets() { return m_compressAssets ; }
+bool Project::sceneFiles() { return m_sceneFiles ; }
+bool Project::offlineCache() { return m_offlineCache ; }
+QString Project::faceSizing() { return m_faceSizing ; }
+int Project::maxFaceSize() { return m_maxFaceSize ; }
 bool Project::overwriteLibrary() { return m_overwriteLibrary ; }
+
+void Project::setLazyLoad(bool yes)
+{
+    m_lazyLoad = yes ;
+}
+
 void Project::setTitle(QString title)
 {
     if (m_title.compare(title)!=0) {
         m_title = title ;
-        m_dirty=true ;
+        m_generation.bump() ;
         m_empty = false ;
     }
 }
@@ -247,18 +468,18 @@ void Project::setAuthor(QString author)
 {
     if (m_author.compare(author)!=0) {
         m_author = author ;
-        m_dirty=true ;
+        m_generation.bump() ;
         m_empty = false ;
     }
 }
 
-void Project::setStartingScene(QString id, int lat, int lon)
+void Project::setStartingScene(Id id, int lat, int lon)
 {
-    if (m_startingSceneId.compare(id)!=0 || m_startingSceneLat!=lat || m_startingSceneLon!=lon) {
+    if (m_startingSceneId!=id || m_startingSceneLat!=lat || m_startingSceneLon!=lon) {
         m_startingSceneId = id ;
         m_startingSceneLat = lat ;
         m_startingSceneLon = lon ;
-        m_dirty=true ;
+        m_generation.bump() ;
         m_empty = false ;
     }
 }
@@ -267,7 +488,7 @@ void Project::setAutoRotate(int ms)
 {
     if (m_autoRotate!=ms) {
         m_autoRotate = ms ;
-        m_dirty=true ;
+        m_generation.bump() ;
         m_empty = false ;
     }
 }
@@ -276,7 +497,7 @@ void Project::setSceneFade(int ms)
 {
     if (m_autoLoad!=ms) {
         m_autoLoad = ms ;
-        m_dirty=true ;
+        m_generation.bump() ;
         m_empty = false ;
     }
 }
@@ -285,7 +506,7 @@ void Project::setCompass(bool yes)
 {
     if (m_compass!=yes) {
         m_compass = yes ;
-        m_dirty=true ;
+        m_generation.bump() ;
         m_empty = false ;
     }
 }
@@ -294,7 +515,7 @@ void Project::setAutoLoad(bool yes)
 {
     if (m_autoLoad!=yes) {
         m_autoLoad = yes ;
-        m_dirty=true ;
+        m_generation.bump() ;
         m_empty = false ;
     }
 }
@@ -303,7 +524,106 @@ void Project::setDebug(bool yes)
 {
     if (m_debug!=yes) {
         m_debug = yes ;
-        m_dirty=true ;
+        m_generation.bump() ;
+        m_empty = false ;
+    }
+}
+
+void Project::setPackTiles(bool yes)
+{
+    if (m_packTiles!=yes) {
+        m_packTiles = yes ;
+        m_generation.bump() ;
+        m_empty = false ;
+    }
+}
+
+void Project::setTileFormat(QString format)
+{
+    if (m_tileFormat.compare(format)!=0) {
+        m_tileFormat = format ;
+        m_generation.bump() ;
+        m_empty = false ;
+    }
+}
+
+void Project::setJpegQuality(int quality)
+{
+    if (m_jpegQuality!=quality) {
+        m_jpegQuality = quality ;
+        m_generation.bump() ;
+        m_empty = false ;
+    }
+}
+
+void Project::setJpeg444(bool yes)
+{
+    if (m_jpeg444!=yes) {
+        m_jpeg444 = yes ;
+        m_generation.bump() ;
+        m_empty = false ;
+    }
+}
+
+void Project::setJpegOptimize(bool yes)
+{
+    if (m_jpegOptimize!=yes) {
+        m_jpegOptimize = yes ;
+        m_generation.bump() ;
+        m_empty = false ;
+    }
+}
+
+void Project::setJpegProgressive(bool yes)
+{
+    if (m_jpegProgressive!=yes) {
+        m_jpegProgressive = yes ;
+        m_generation.bump() ;
+        m_empty = false ;
+    }
+}
+
+void Project::setCompressAssets(bool yes)
+{
+    if (m_compressAssets!=yes) {
+        m_compressAssets = yes ;
+        m_generation.bump() ;
+        m_empty = false ;
+    }
+}
+
+void Project::setSceneFiles(bool yes)
+{
+    if (m_sceneFiles!=yes) {
+        m_sceneFiles = yes ;
+        m_generation.bump() ;
+        m_empty = false ;
+    }
+}
+
+void Project::setOfflineCache(bool yes)
+{
+    if (m_offlineCache!=yes) {
+        m_offlineCache = yes ;
+        m_generation.bump() ;
+        m_empty = false ;
+    }
+}
+
+void Project::setFaceSizing(QString policy)
+{
+    if (m_faceSizing.compare(policy)!=0) {
+        m_faceSizing = policy ;
+        m_generation.bump() ;
+        m_empty = false ;
+    }
+}
+
+void Project::setMaxFaceSize(int size)
+{
+    if (m_maxFaceSize!=size) {
+        m_maxFaceSize = size ;
+        m_generation.bump() ;
         m_empty = false ;
     }
 }
@@ -314,11 +634,14 @@ void Project::setOverwriteLibrary(bool yes)
 }
 
 bool Project::isDirty() {
-    bool dirty = m_dirty ;
+    return m_generation.value()!=m_cleanGeneration ;
+}
+
+bool Project::isDamaged() {
     for (int i=0; i<m_scenes.count(); i++) {
-        dirty |= m_scenes[i].isDirty() ;
+        if (m_scenes.at(i).nodesDamaged()) return true ;
     }
-    return dirty ;
+    return false ;
 }
 
 bool Project::isEmpty() {
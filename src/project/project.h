@@ -23,23 +23,85 @@
 
 #include <QString>
 #include <QList>
+#include <QVariantMap>
+#include <QHash>
 #include "scene.h"
+#include "projectjournal.h"
+#include "projectobserver.h"
+
+// Projects saved with this suffix use the binary format (see project_binary.cpp),
+// anything else is saved as an INI file
+#define PROJECT_BINARY_SUFFIX "pmb"
+
+// Version of the binary project and journal records
+#define PROJECT_BINARY_VERSION 3
+
+class QDataStream ;
+class QDir ;
 
 
 class Project
 {
 private:
-    QString m_title, m_author, m_startingSceneId ;
+    QString m_title, m_author ;
+    Id m_startingSceneId ;
     int m_startingSceneLat, m_startingSceneLon ;
     int m_autoRotate, m_sceneFade ;
     bool m_compass, m_autoLoad, m_debug ;
+    bool m_packTiles ;
+    QString m_tileFormat ;
+    int m_jpegQuality ;
+    bool m_jpeg444, m_jpegOptimize, m_jpegProgressive ;
+    bool m_compressAssets ;
+    bool m_sceneFiles ;
+    bool m_offlineCache ;
+    QString m_faceSizing ;
+    int m_maxFaceSize ;
 
     QString m_projectpath ;
     Scene m_invalidScene ;
     SceneList m_scenes ;
-    bool m_dirty ;
+    QHash<Id, int> m_sceneIndex ;      // id => position in m_scenes
+    Generation m_generation ;           // Bumped by every edit to the project, its scenes or nodes
+    quint64 m_cleanGeneration ;         // Generation when last saved or opened
+    quint64 m_journaledGeneration ;     // Generation when last journaled
     bool m_empty ;
     bool m_overwriteLibrary ;
+    bool m_lazyLoad ;
+
+    ProjectJournal m_journal ;
+    QVariantMap m_journaledSettings ;
+    QList<Id> m_removedScenes ;         // Removed since last journaled
+    bool m_sceneOrderPending ;          // Scenes reordered since last journaled
+    int m_recovered ;
+
+    ProjectObserverList m_observers ;
+    bool m_observing ;                  // False while opening, when changes aren't reported
+
+    int replayJournal() ;
+    const ProjectObserverList *observers() ;
+
+    void reindexScenes() ;
+    QVariantMap settingsMap() ;
+    void applySettings(const QVariantMap& settings) ;
+    bool openIni(QString path) ;
+    bool saveIni(QString path) ;
+    bool openBinary(QString path) ;
+    bool openBinaryTable(QString path, int version) ;
+    bool saveBinary(QString path) ;
+
+    static void writeString(QDataStream& out, const QString& str) ;
+    static QString readString(QDataStream& in) ;
+    static void writeId(QDataStream& out, const Id& id) ;
+    static Id readId(QDataStream& in, int version) ;
+    static QList<Id> readIds(QDataStream& in, int version) ;
+    static void writeScene(QDataStream& out, Scene& sc, const QDir& projDir) ;
+    static void readScene(QDataStream& in, Scene& sc, const QDir& projDir) ;
+    static void writeNode(QDataStream& out, const Node& nd) ;
+
+public:
+    // Also used by Scene, to read nodes which were left in the project file
+    static void readNode(QDataStream& in, Node& nd, int version) ;
 
 public:
 
@@ -53,21 +115,53 @@ private:
 public:
     void clear() ;
 
+    // OpenProject returns false, leaving the project empty, if the file can't be read in
+    // full.  SaveProject returns false, leaving the project dirty, if it can't be written.
+    // It only skips writing a clean project to the file it came from.
     bool OpenProject(QString path) ;
     bool SaveProject(QString path = QString("")) ;
+    static bool isBinaryProject(QString path) ;
 
+    // When set, OpenProject only reads the scene headers of a binary project,
+    // and each scene's nodes are read from the file when they are first used.
+    // INI projects, and binary projects before version 3, are always read in full.
+    void setLazyLoad(bool yes) ;
+
+    // Append the edits made since the last call to the project's journal.  Only
+    // the changed settings, scenes and nodes are written, so this is cheap enough
+    // to call after every edit.  Does nothing until the project has a filename.
+    bool journalChanges() ;
+
+    // Number of journal batches replayed when the project was opened (i.e. edits
+    // recovered after a crash)
+    int recoveredChanges() ;
+
+    // Scenes are added and removed through the project, so that lookups by id stay
+    // constant time.  A scene's id must not change once it has been added.
     int sceneCount() ;
-    SceneList& scenes() ;
+    const SceneList& scenes() ;
     Scene& sceneAt(int num) ;
-    Scene& scene(QString id) ;
-    bool removeScene(QString id) ;
+    Scene& scene(Id id) ;
+    int sceneIndex(Id id) ;
+    Scene& addScene(const Scene& scene) ;
+    bool removeScene(Id id) ;
+    bool moveScene(int from, int to) ;
+
+    // Observers are told of scenes and nodes being added, removed and moved (see
+    // ProjectObserver).  They are not owned, and must be removed before deletion.
+    void addObserver(ProjectObserver *observer) ;
+    void removeObserver(ProjectObserver *observer) ;
 
     bool isDirty() ;
     bool isEmpty() ;
 
+    // True if a scene's nodes couldn't all be read when they were loaded from the project
+    // file.  A damaged project is never saved, as the nodes which weren't read would be lost.
+    bool isDamaged() ;
+
     QString title() ;
     QString author() ;
-    QString startingSceneId() ;
+    Id startingSceneId() ;
     int startingSceneLat() ;
     int startingSceneLon() ;
     int autoRotate() ;
@@ -75,16 +169,38 @@ public:
     bool compass() ;
     bool autoLoad() ;
     bool debug() ;
+    bool packTiles() ;
+    QString tileFormat() ;          // Tile file extension, "jpg" or "webp"
+    int jpegQuality() ;
+    bool jpeg444() ;
+    bool jpegOptimize() ;
+    bool jpegProgressive() ;
+    bool compressAssets() ;         // Compact configuration, with .gz / .br copies of text files
+    bool sceneFiles() ;             // Configuration split into an index and a file per scene
+    bool offlineCache() ;           // Service worker which caches the tour
+    QString faceSizing() ;          // Hi-res face size policy, "height" or "matched" (see FaceSizing)
+    int maxFaceSize() ;             // Largest hi-res face size, 0 if unlimited
     bool overwriteLibrary() ;
 
     void setTitle(QString title) ;
     void setAuthor(QString author) ;
-    void setStartingScene(QString id, int lat, int lon) ;
+    void setStartingScene(Id id, int lat, int lon) ;
     void setAutoRotate(int ms) ;
     void setSceneFade(int ms) ;
     void setCompass(bool yes) ;
     void setAutoLoad(bool yes) ;
     void setDebug(bool yes) ;
+    void setPackTiles(bool yes) ;
+    void setTileFormat(QString format) ;
+    void setJpegQuality(int quality) ;
+    void setJpeg444(bool yes) ;
+    void setJpegOptimize(bool yes) ;
+    void setJpegProgressive(bool yes) ;
+    void setCompressAssets(bool yes) ;
+    void setSceneFiles(bool yes) ;
+    void setOfflineCache(bool yes) ;
+    void setFaceSizing(QString policy) ;
+    void setMaxFaceSize(int size) ;
     void setOverwriteLibrary(bool yes) ; // Note: Intentionally not saved
 
 };
@@ -0,0 +1,312 @@
+//    PanoManager - Interactive panorama tour manager program
+//    Copyright (C) 2018  Steve M Clarke
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+//
+// Project - Binary File Format
+//
+// A binary project is written in a single pass with QDataStream.  All integers
+// are big endian, strings are UTF-8 byte arrays, and ids are 16 raw bytes
+// (version 1 stored ids as strings).
+//
+//   quint32 magic "PMPB", quint16 version
+//   QVariantMap settings             (same keys as the INI format)
+//   per scene, its nodes:
+//     id, qint32 type, lat, lon, arrivalLat, arrivalLon
+//     title, description, destId, url
+//   scene table, quint32 numScenes, then per scene:
+//     id, imageFile (relative to the project), title, qint32 northOffset
+//     quint32 numNodes, qint64 offset of its first node
+//   qint64 offset of the scene table
+//
+// The scene table is read first, from the end of the file, and the nodes of
+// each scene are only read when they are first used (see setLazyLoad).
+//
+// Versions 1 and 2 have no table, and hold each scene's header immediately
+// followed by its nodes.  They are read in a single pass.
+//
+// Unknown settings are ignored, so settings can be added without changing the
+// version.  Any change to the scene or node records needs a new version.
+//
+
+#include "project.h"
+#include "../icons/icons.h"
+
+#include <QFile>
+#include <QSaveFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDataStream>
+#include <QVector>
+#include <QtGlobal>
+
+#define PROJECT_BINARY_MAGIC 0x504D5042      // "PMPB"
+
+// Counts are only trusted this far when reserving space, in case the file is damaged
+#define PROJECT_BINARY_RESERVE 65536
+
+// Smallest node record (ids, numbers and empty strings), so a node count can be checked
+// against the size of its block
+#define PROJECT_BINARY_MIN_NODE 64
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// Record readers and writers, shared with the project journal
+//
+
+void Project::writeString(QDataStream& out, const QString& str)
+{
+    out << str.toUtf8() ;
+}
+
+QString Project::readString(QDataStream& in)
+{
+    QByteArray utf8 ;
+    in >> utf8 ;
+    return QString::fromUtf8(utf8) ;
+}
+
+void Project::writeId(QDataStream& out, const Id& id)
+{
+    out.writeRawData(id.toBytes().constData(), 16) ;
+}
+
+Id Project::readId(QDataStream& in, int version)
+{
+    if (version<2) return Id::fromString(readString(in)) ;
+    char bytes[16] ;
+    if (in.readRawData(bytes, 16)!=16) {
+        in.setStatus(QDataStream::ReadPastEnd) ;
+        return Id() ;
+    }
+    return Id::fromBytes(QByteArray(bytes, 16)) ;
+}
+
+// Scene header, without the id
+void Project::writeScene(QDataStream& out, Scene& sc, const QDir& projDir)
+{
+    writeString(out, projDir.relativeFilePath(QDir::cleanPath(sc.filename()))) ;
+    writeString(out, sc.title()) ;
+    out << (qint32)sc.northOffset() ;
+}
+
+void Project::readScene(QDataStream& in, Scene& sc, const QDir& projDir)
+{
+    sc.setFilename(QDir::cleanPath(projDir.absoluteFilePath(readString(in)))) ;
+    sc.setTitle(readString(in)) ;
+    qint32 north ;
+    in >> north ;
+    sc.setNorthOffset(north) ;
+}
+
+void Project::writeNode(QDataStream& out, const Node& nd)
+{
+    writeId(out, nd.id()) ;
+    out << (qint32)nd.type() << (qint32)nd.lat() << (qint32)nd.lon() ;
+    out << (qint32)nd.arrivalLat() << (qint32)nd.arrivalLon() ;
+    writeString(out, nd.title()) ;
+    writeString(out, nd.description()) ;
+    writeId(out, nd.destId()) ;
+    writeString(out, nd.url()) ;
+}
+
+void Project::readNode(QDataStream& in, Node& nd, int version)
+{
+    qint32 type, lat, lon, arrivalLat, arrivalLon ;
+    nd.setId(readId(in, version)) ;
+    in >> type >> lat >> lon >> arrivalLat >> arrivalLon ;
+    if (type<0 || type>=Icon::numTextures) type=0 ;
+    nd.setType((Icon::IconType)type) ;
+    nd.setLat(lat) ;
+    nd.setLon(lon) ;
+    nd.setArrivalLat(arrivalLat) ;
+    nd.setArrivalLon(arrivalLon) ;
+    nd.setTitle(readString(in)) ;
+    nd.setDescription(readString(in)) ;
+    nd.setDestId(readId(in, version)) ;
+    nd.setUrl(readString(in)) ;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// isBinaryProject - Check the file's magic number, whatever its suffix
+//
+
+bool Project::isBinaryProject(QString path)
+{
+    QFile file(path) ;
+    if (!file.open(QIODevice::ReadOnly)) return false ;
+    QDataStream in(&file) ;
+    quint32 magic = 0 ;
+    in >> magic ;
+    return in.status()==QDataStream::Ok && magic==PROJECT_BINARY_MAGIC ;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// openBinary
+//
+
+bool Project::openBinary(QString path)
+{
+    QFile file(path) ;
+    if (!file.open(QIODevice::ReadOnly)) return false ;
+    QDir projDir(QFileInfo(path).absoluteDir()) ;
+
+    QDataStream in(&file) ;
+    in.setVersion(QDataStream::Qt_5_9) ;
+
+    quint32 magic ;
+    quint16 version ;
+    in >> magic >> version ;
+    if (magic!=PROJECT_BINARY_MAGIC || version<1 || version>PROJECT_BINARY_VERSION) return false ;
+
+    QVariantMap settings ;
+    in >> settings ;
+    applySettings(settings) ;
+    if (in.status()!=QDataStream::Ok) return false ;
+
+    if (version>=3) return openBinaryTable(path, version) ;
+
+    quint32 numScenes ;
+    in >> numScenes ;
+    if (in.status()!=QDataStream::Ok) return false ;
+
+    m_scenes.reserve((int)qMin(numScenes, (quint32)PROJECT_BINARY_RESERVE)) ;
+    for (quint32 s=0; s<numScenes && in.status()==QDataStream::Ok; s++) {
+
+        Scene newScene ;
+        newScene.setId(readId(in, version)) ;
+        readScene(in, newScene, projDir) ;
+
+        quint32 numNodes ;
+        in >> numNodes ;
+
+        for (quint32 n=0; n<numNodes && in.status()==QDataStream::Ok; n++) {
+            Node newNode ;
+            readNode(in, newNode, version) ;
+            newScene.addNode(newNode) ;
+        }
+
+        m_scenes.append(newScene) ;
+    }
+
+    return in.status()==QDataStream::Ok ;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// openBinaryTable - Read the scene table, leaving the nodes in the file
+//
+
+bool Project::openBinaryTable(QString path, int version)
+{
+    NodeSource source ;
+    source.file = QSharedPointer<QFile>(new QFile(path)) ;
+    source.version = version ;
+
+    QFile& file = *source.file ;
+    if (!file.open(QIODevice::ReadOnly)) return false ;
+    QDir projDir(QFileInfo(path).absoluteDir()) ;
+
+    QDataStream in(&file) ;
+    in.setVersion(QDataStream::Qt_5_9) ;
+
+    qint64 tableOffset ;
+    if (file.size()<(qint64)sizeof(qint64) || !file.seek(file.size()-sizeof(qint64))) return false ;
+    in >> tableOffset ;
+    if (in.status()!=QDataStream::Ok || tableOffset<0 || !file.seek(tableOffset)) return false ;
+
+    quint32 numScenes ;
+    in >> numScenes ;
+    if (in.status()!=QDataStream::Ok) return false ;
+
+    m_scenes.reserve((int)qMin(numScenes, (quint32)PROJECT_BINARY_RESERVE)) ;
+    for (quint32 s=0; s<numScenes && in.status()==QDataStream::Ok; s++) {
+
+        Scene newScene ;
+        newScene.setId(readId(in, version)) ;
+        readScene(in, newScene, projDir) ;
+
+        quint32 numNodes ;
+        qint64 offset ;
+        in >> numNodes >> offset ;
+        if (offset<0 || offset>tableOffset || (qint64)numNodes*PROJECT_BINARY_MIN_NODE>tableOffset-offset) {
+            in.setStatus(QDataStream::ReadCorruptData) ;
+            numNodes = 0 ;
+        }
+
+        source.count = (int)numNodes ;
+        source.offset = offset ;
+        newScene.setNodeSource(source) ;
+
+        m_scenes.append(newScene) ;
+    }
+    if (in.status()!=QDataStream::Ok) return false ;
+
+    // The scenes now hold the only references to the file, so it is closed once all have loaded
+    source.file.clear() ;
+    if (!m_lazyLoad) {
+        for (int s=0; s<m_scenes.count(); s++) {
+            m_scenes[s].nodes() ;
+            if (m_scenes[s].nodesDamaged()) return false ;
+        }
+    }
+    return true ;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// saveBinary - Written to a temporary file, and renamed into place
+//
+
+bool Project::saveBinary(QString path)
+{
+    QSaveFile file(path) ;
+    if (!file.open(QIODevice::WriteOnly)) return false ;
+    QDir projDir(QFileInfo(path).absoluteDir()) ;
+
+    QDataStream out(&file) ;
+    out.setVersion(QDataStream::Qt_5_9) ;
+
+    out << (quint32)PROJECT_BINARY_MAGIC << (quint16)PROJECT_BINARY_VERSION ;
+    out << settingsMap() ;
+
+    // Node blocks first, remembering where each starts for the scene table
+    QVector<qint64> offsets(m_scenes.count()) ;
+    for (int s=0; s<m_scenes.count(); s++) {
+        Scene& sc = m_scenes[s] ;
+        offsets[s] = file.pos() ;
+        for (int n=0; n<sc.nodeCount(); n++) {
+            writeNode(out, sc.constNodeAt(n)) ;
+        }
+    }
+
+    qint64 tableOffset = file.pos() ;
+    out << (quint32)m_scenes.count() ;
+    for (int s=0; s<m_scenes.count(); s++) {
+        Scene& sc = m_scenes[s] ;
+        writeId(out, sc.id()) ;
+        writeScene(out, sc, projDir) ;
+        out << (quint32)sc.nodeCount() << offsets[s] ;
+    }
+    out << tableOffset ;
+
+    if (out.status()!=QDataStream::Ok) {
+        file.cancelWriting() ;
+        return false ;
+    }
+    return file.commit() ;
+}
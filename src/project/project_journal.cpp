@@ -0,0 +1,245 @@
+//    PanoManager - Interactive panorama tour manager program
+//    Copyright (C) 2018  Steve M Clarke
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+//
+// Project - Journal Records
+//
+// Each call to journalChanges writes one batch of records (see ProjectJournal)
+// for the settings, scenes and nodes changed since the previous call.  Records
+// hold the new state rather than the change, so replaying a batch twice (e.g.
+// if the program stopped between saving the project and removing the journal)
+// does no harm.
+//
+
+#include "project.h"
+
+#include <QFileInfo>
+#include <QDir>
+#include <QDataStream>
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// journalChanges
+//
+
+bool Project::journalChanges()
+{
+    if (m_projectpath.isEmpty() || m_generation.value()==m_journaledGeneration) return true ;
+    QDir projDir(QFileInfo(m_projectpath).absoluteDir()) ;
+
+    QByteArray batch ;
+    QDataStream out(&batch, QIODevice::WriteOnly) ;
+    out.setVersion(QDataStream::Qt_5_9) ;
+    int records = 0 ;
+    QList<int> changed ;
+
+    QVariantMap settings = settingsMap() ;
+    if (settings!=m_journaledSettings) {
+        out << (quint8)ProjectJournal::Settings << settings ;
+        records++ ;
+    }
+
+    for (int i=0; i<m_removedScenes.count(); i++) {
+        out << (quint8)ProjectJournal::RemoveScene ;
+        writeId(out, m_removedScenes.at(i)) ;
+        records++ ;
+    }
+
+    for (int s=0; s<m_scenes.count(); s++) {
+
+        // Scenes whose generation hasn't moved are skipped without looking at their nodes
+        Scene& sc = m_scenes[s] ;
+        if (!sc.hasUnjournaledChanges()) continue ;
+        changed.append(s) ;
+
+        if (sc.journalPending()) {
+            out << (quint8)ProjectJournal::SceneHeader ;
+            writeId(out, sc.id()) ;
+            writeScene(out, sc, projDir) ;
+            records++ ;
+        }
+
+        const QList<Id>& removed = sc.removedNodes() ;
+        for (int i=0; i<removed.count(); i++) {
+            out << (quint8)ProjectJournal::RemoveNode ;
+            writeId(out, sc.id()) ;
+            writeId(out, removed.at(i)) ;
+            records++ ;
+        }
+
+        // Nodes still in the project file can't have been edited
+        for (int n=0; sc.nodesLoaded() && n<sc.nodeCount(); n++) {
+            const Node& nd = sc.constNodeAt(n) ;
+            if (nd.journalPending()) {
+                out << (quint8)ProjectJournal::NodeRecord ;
+                writeId(out, sc.id()) ;
+                writeNode(out, nd) ;
+                records++ ;
+            }
+        }
+
+        if (sc.nodeOrderPending()) {
+            out << (quint8)ProjectJournal::NodeOrder ;
+            writeId(out, sc.id()) ;
+            out << (quint32)sc.nodeCount() ;
+            for (int n=0; n<sc.nodeCount(); n++) writeId(out, sc.constNodeAt(n).id()) ;
+            records++ ;
+        }
+    }
+
+    if (m_sceneOrderPending) {
+        out << (quint8)ProjectJournal::SceneOrder ;
+        out << (quint32)m_scenes.count() ;
+        for (int s=0; s<m_scenes.count(); s++) writeId(out, m_scenes[s].id()) ;
+        records++ ;
+    }
+
+    if (out.status()!=QDataStream::Ok) return false ;
+    if (records>0 && !m_journal.append(m_projectpath, PROJECT_BINARY_VERSION, batch)) return false ;
+
+    m_journaledGeneration = m_generation.value() ;
+    m_journaledSettings = settings ;
+    m_removedScenes.clear() ;
+    m_sceneOrderPending=false ;
+    for (int i=0; i<changed.count(); i++) m_scenes[changed.at(i)].markJournaled() ;
+    return true ;
+}
+
+int Project::recoveredChanges()
+{
+    return m_recovered ;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// replayJournal - Apply the journal to the project which has just been opened
+//
+// The replayed edits are then written to a new journal, which drops any partly
+// written batch from the end of the old one.
+//
+
+QList<Id> Project::readIds(QDataStream& in, int version)
+{
+    QList<Id> ids ;
+    quint32 count ;
+    in >> count ;
+    for (quint32 i=0; i<count && in.status()==QDataStream::Ok; i++) ids.append(readId(in, version)) ;
+    return ids ;
+}
+
+int Project::replayJournal()
+{
+    int version = PROJECT_BINARY_VERSION ;
+    QList<QByteArray> batches = ProjectJournal::read(m_projectpath, version) ;
+    if (version<1 || version>PROJECT_BINARY_VERSION) return 0 ;
+    if (batches.isEmpty()) {
+        m_journal.remove(m_projectpath) ;
+        return 0 ;
+    }
+
+    QDir projDir(QFileInfo(m_projectpath).absoluteDir()) ;
+
+    for (int b=0; b<batches.count(); b++) {
+
+        QDataStream in(batches.at(b)) ;
+        in.setVersion(QDataStream::Qt_5_9) ;
+        bool known = true ;
+
+        while (known && !in.atEnd() && in.status()==QDataStream::Ok) {
+
+            quint8 type ;
+            in >> type ;
+
+            switch (type) {
+
+            case ProjectJournal::Settings: {
+                QVariantMap settings ;
+                in >> settings ;
+                applySettings(settings) ;
+                break ; }
+
+            case ProjectJournal::SceneHeader: {
+                Id id = readId(in, version) ;
+                Scene& sc = scene(id) ;
+                if (sc.isValid()) {
+                    readScene(in, sc, projDir) ;
+                } else {
+                    Scene newScene ;
+                    newScene.setId(id) ;
+                    readScene(in, newScene, projDir) ;
+                    addScene(newScene) ;
+                }
+                break ; }
+
+            case ProjectJournal::NodeRecord: {
+                Scene& sc = scene(readId(in, version)) ;
+                Node newNode ;
+                readNode(in, newNode, version) ;
+                Node& nd = sc.node(newNode.id()) ;
+                if (nd.isValid()) {
+                    // Replacing the data isn't an edit, so mark it as one, for the journal
+                    // rewritten below and so the scene is dirty
+                    nd = newNode ;
+                    nd.markUnjournaled() ;
+                } else {
+                    sc.addNode(newNode) ;
+                }
+                break ; }
+
+            case ProjectJournal::RemoveScene:
+                removeScene(readId(in, version)) ;
+                break ;
+
+            case ProjectJournal::RemoveNode: {
+                Scene& sc = scene(readId(in, version)) ;
+                sc.removeNode(readId(in, version)) ;
+                break ; }
+
+            case ProjectJournal::SceneOrder: {
+                QList<Id> order = readIds(in, version) ;
+                int pos = 0 ;
+                for (int i=0; i<order.count(); i++) {
+                    int from = sceneIndex(order.at(i)) ;
+                    if (from<0) continue ;
+                    moveScene(from, pos++) ;
+                }
+                break ; }
+
+            case ProjectJournal::NodeOrder: {
+                Scene& sc = scene(readId(in, version)) ;
+                QList<Id> order = readIds(in, version) ;
+                int pos = 0 ;
+                for (int i=0; i<order.count(); i++) {
+                    int from = sc.nodeIndex(order.at(i)) ;
+                    if (from<0) continue ;
+                    sc.moveNode(from, pos++) ;
+                }
+                break ; }
+
+            default:
+                // Written by a later version, so the rest of the batch can't be read
+                known = false ;
+                break ;
+            }
+        }
+    }
+
+    m_journal.remove(m_projectpath) ;
+    m_generation.bump() ;
+    m_empty = false ;
+    journalChanges() ;
+    return batches.count() ;
+}
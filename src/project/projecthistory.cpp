@@ -0,0 +1,258 @@
+//    PanoManager - Interactive panorama tour manager program
+//    Copyright (C) 2018  Steve M Clarke
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+//
+// Project History
+//
+
+#include "projecthistory.h"
+#include "project.h"
+
+#include <QtGlobal>
+
+ProjectHistory::ProjectHistory()
+{
+}
+
+ProjectHistory::~ProjectHistory()
+{
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// Edits - Each is made by applying it, and its inverse is held for undo
+//
+
+void ProjectHistory::addScene(Project& project, const Scene& scene)
+{
+    Edit edit = newEdit(InsertScene, scene.id()) ;
+    edit.scene = QSharedPointer<Scene>(new Scene(scene)) ;
+    edit.index = project.sceneCount() ;
+    perform(project, edit) ;
+}
+
+void ProjectHistory::removeScene(Project& project, Id sceneId)
+{
+    perform(project, newEdit(RemoveScene, sceneId)) ;
+}
+
+void ProjectHistory::setSceneTitle(Project& project, Id sceneId, QString title)
+{
+    Edit edit = newEdit(SceneTitle, sceneId) ;
+    edit.title = title ;
+    perform(project, edit) ;
+}
+
+void ProjectHistory::setNorthOffset(Project& project, Id sceneId, int north)
+{
+    Edit edit = newEdit(NorthOffset, sceneId) ;
+    edit.lon = north ;
+    perform(project, edit) ;
+}
+
+void ProjectHistory::addNode(Project& project, Id sceneId, const Node& node)
+{
+    Edit edit = newEdit(InsertNode, sceneId, node.id()) ;
+    edit.node = QSharedPointer<Node>(new Node(node)) ;
+    edit.index = project.scene(sceneId).nodeCount() ;
+    perform(project, edit) ;
+}
+
+void ProjectHistory::removeNode(Project& project, Id sceneId, Id nodeId)
+{
+    perform(project, newEdit(RemoveNode, sceneId, nodeId)) ;
+}
+
+void ProjectHistory::moveNode(Project& project, Id sceneId, Id nodeId, int lat, int lon)
+{
+    Edit edit = newEdit(MoveNode, sceneId, nodeId) ;
+    edit.lat = lat ;
+    edit.lon = lon ;
+    perform(project, edit) ;
+}
+
+void ProjectHistory::setNodeDetails(Project& project, Id sceneId, const Node& node, bool typing)
+{
+    Edit edit = newEdit(NodeDetails, sceneId, node.id()) ;
+    edit.node = QSharedPointer<Node>(new Node(node)) ;
+
+    // The inverse of the first edit already restores the node as it was before typing
+    if (typing && m_typingNode==node.id() && !m_undo.isEmpty() && m_undo.last().nodeId==node.id()) {
+        apply(project, edit) ;
+        return ;
+    }
+
+    perform(project, edit) ;
+    if (typing) m_typingNode = node.id() ;
+}
+
+// A new edit makes anything which was undone unreachable
+void ProjectHistory::perform(Project& project, const Edit& edit)
+{
+    m_typingNode = Id() ;
+    Edit inverse = apply(project, edit) ;
+    if (inverse.type==NoEdit) return ;
+    m_redo.clear() ;
+    m_undo.append(inverse) ;
+    if (m_undo.count()>PROJECT_HISTORY_LIMIT) m_undo.removeFirst() ;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// undo / redo
+//
+
+bool ProjectHistory::canUndo() const
+{
+    return !m_undo.isEmpty() ;
+}
+
+bool ProjectHistory::canRedo() const
+{
+    return !m_redo.isEmpty() ;
+}
+
+Id ProjectHistory::undo(Project& project)
+{
+    if (m_undo.isEmpty()) return Id() ;
+    m_typingNode = Id() ;
+    Edit edit = m_undo.takeLast() ;
+    Edit inverse = apply(project, edit) ;
+    if (inverse.type!=NoEdit) m_redo.append(inverse) ;
+    return edit.sceneId ;
+}
+
+Id ProjectHistory::redo(Project& project)
+{
+    if (m_redo.isEmpty()) return Id() ;
+    m_typingNode = Id() ;
+    Edit edit = m_redo.takeLast() ;
+    Edit inverse = apply(project, edit) ;
+    if (inverse.type!=NoEdit) m_undo.append(inverse) ;
+    return edit.sceneId ;
+}
+
+void ProjectHistory::clear()
+{
+    m_undo.clear() ;
+    m_redo.clear() ;
+    m_typingNode = Id() ;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// apply - Make an edit, and return its inverse (NoEdit if the scene or node no longer exists)
+//
+
+ProjectHistory::Edit ProjectHistory::newEdit(EditType type, Id sceneId, Id nodeId)
+{
+    Edit edit ;
+    edit.type = type ;
+    edit.sceneId = sceneId ;
+    edit.nodeId = nodeId ;
+    edit.index = 0 ;
+    edit.lat = 0 ;
+    edit.lon = 0 ;
+    return edit ;
+}
+
+ProjectHistory::Edit ProjectHistory::apply(Project& project, const Edit& edit)
+{
+    Edit inverse = newEdit(NoEdit, edit.sceneId, edit.nodeId) ;
+
+    switch (edit.type) {
+
+        case InsertScene: {
+            if (project.sceneIndex(edit.sceneId)>=0) break ;
+            Scene& added = project.addScene(*edit.scene) ;
+            added.markUnjournaled() ;
+            project.moveScene(project.sceneCount()-1, qBound(0, edit.index, project.sceneCount()-1)) ;
+            inverse.type = RemoveScene ;
+            break ; }
+
+        case RemoveScene: {
+            int num = project.sceneIndex(edit.sceneId) ;
+            if (num<0) break ;
+            // Nodes still in the project file are read now, as the file may be replaced before the undo
+            Scene& sc = project.sceneAt(num) ;
+            sc.nodes() ;
+            inverse.scene = QSharedPointer<Scene>(new Scene(sc)) ;
+            inverse.index = num ;
+            project.removeScene(edit.sceneId) ;
+            inverse.type = InsertScene ;
+            break ; }
+
+        case SceneTitle: {
+            Scene& sc = project.scene(edit.sceneId) ;
+            if (!sc.isValid()) break ;
+            inverse.title = sc.title() ;
+            sc.setTitle(edit.title) ;
+            inverse.type = SceneTitle ;
+            break ; }
+
+        case NorthOffset: {
+            Scene& sc = project.scene(edit.sceneId) ;
+            if (!sc.isValid()) break ;
+            inverse.lon = sc.northOffset() ;
+            sc.setNorthOffset(edit.lon) ;
+            inverse.type = NorthOffset ;
+            break ; }
+
+        case InsertNode: {
+            Scene& sc = project.scene(edit.sceneId) ;
+            if (!sc.isValid() || sc.nodeIndex(edit.nodeId)>=0) break ;
+            Node& added = sc.addNode(*edit.node) ;
+            added.markUnjournaled() ;
+            sc.moveNode(sc.nodeCount()-1, qBound(0, edit.index, sc.nodeCount()-1)) ;
+            inverse.type = RemoveNode ;
+            break ; }
+
+        case RemoveNode: {
+            Scene& sc = project.scene(edit.sceneId) ;
+            int num = sc.nodeIndex(edit.nodeId) ;
+            if (num<0) break ;
+            inverse.node = QSharedPointer<Node>(new Node(sc.constNodeAt(num))) ;
+            inverse.index = num ;
+            sc.removeNode(edit.nodeId) ;
+            inverse.type = InsertNode ;
+            break ; }
+
+        case MoveNode: {
+            Node& nd = project.scene(edit.sceneId).node(edit.nodeId) ;
+            if (!nd.isValid()) break ;
+            inverse.lat = nd.lat() ;
+            inverse.lon = nd.lon() ;
+            nd.setLat(edit.lat) ;
+            nd.setLon(edit.lon) ;
+            inverse.type = MoveNode ;
+            break ; }
+
+        case NodeDetails: {
+            Node& nd = project.scene(edit.sceneId).node(edit.nodeId) ;
+            if (!nd.isValid()) break ;
+            // The copies share their data, and replacing it isn't an edit, so it's marked as one
+            inverse.node = QSharedPointer<Node>(new Node(nd)) ;
+            nd = *edit.node ;
+            nd.markUnjournaled() ;
+            inverse.type = NodeDetails ;
+            break ; }
+
+        case NoEdit:
+            break ;
+    }
+
+    return inverse ;
+}
@@ -0,0 +1,116 @@
+//    PanoManager - Interactive panorama tour manager program
+//    Copyright (C) 2018  Steve M Clarke
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+//
+// Project History
+//
+// Undo and redo of the edits made in the main window.  Each edit is held as
+// its inverse (the edit which would undo it), so memory grows with the number
+// and size of the edits rather than with the project, and undoing or redoing
+// an edit costs no more than making it.
+//
+// Undoing an edit applies its inverse, and holds the inverse of that for redo.
+// A removed scene or node is held as a copy, which shares its data with the
+// original, so removing a large scene doesn't copy its nodes.
+//
+// Edits made directly to the project (e.g. journal replay) aren't recorded,
+// so the history must be cleared whenever the project is replaced.
+//
+
+#ifndef PROJECTHISTORY_H
+#define PROJECTHISTORY_H
+
+#include <QString>
+#include <QList>
+#include <QSharedPointer>
+#include "scene.h"
+#include "node.h"
+#include "id.h"
+
+// Oldest edits are dropped beyond this
+#define PROJECT_HISTORY_LIMIT 500
+
+class Project ;
+
+class ProjectHistory
+{
+private:
+    typedef enum {
+        NoEdit = 0,
+        InsertScene,            // scene, index
+        RemoveScene,            // sceneId
+        SceneTitle,             // sceneId, title
+        NorthOffset,            // sceneId, lon
+        InsertNode,             // sceneId, node, index
+        RemoveNode,             // sceneId, nodeId
+        MoveNode,               // sceneId, nodeId, lat, lon
+        NodeDetails             // sceneId, nodeId, node
+    } EditType ;
+
+    typedef struct {
+        EditType type ;
+        Id sceneId ;
+        Id nodeId ;
+        int index ;
+        int lat, lon ;
+        QString title ;
+        QSharedPointer<Scene> scene ;
+        QSharedPointer<Node> node ;
+    } Edit ;
+
+    QList<Edit> m_undo ;
+    QList<Edit> m_redo ;
+    Id m_typingNode ;                   // Node whose details the latest edit was typed into
+
+    static Edit newEdit(EditType type, Id sceneId, Id nodeId=Id()) ;
+    static Edit apply(Project& project, const Edit& edit) ;
+    void perform(Project& project, const Edit& edit) ;
+
+public:
+    ProjectHistory() ;
+    ~ProjectHistory() ;
+
+private:
+    ProjectHistory(const ProjectHistory& other) ;
+    ProjectHistory& operator=(const ProjectHistory& rhs) ;
+
+public:
+    // Make an edit to the project, so that it can be undone
+    void addScene(Project& project, const Scene& scene) ;
+    void removeScene(Project& project, Id sceneId) ;
+    void setSceneTitle(Project& project, Id sceneId, QString title) ;
+    void setNorthOffset(Project& project, Id sceneId, int north) ;
+    void addNode(Project& project, Id sceneId, const Node& node) ;
+    void removeNode(Project& project, Id sceneId, Id nodeId) ;
+    void moveNode(Project& project, Id sceneId, Id nodeId, int lat, int lon) ;
+
+    // Replace a node's details (type, title, description, destination, arrival and url)
+    // with those of a changed copy of it.  When typing, edits to the same node which
+    // follow each other are undone together, rather than a character at a time.
+    void setNodeDetails(Project& project, Id sceneId, const Node& node, bool typing=false) ;
+
+    bool canUndo() const ;
+    bool canRedo() const ;
+
+    // Undo or redo the latest edit.  Returns the id of the scene it changed, or
+    // a null id if there was nothing to do.
+    Id undo(Project& project) ;
+    Id redo(Project& project) ;
+
+    void clear() ;
+};
+
+#endif // PROJECTHISTORY_H
@@ -0,0 +1,98 @@
+//    PanoManager - Interactive panorama tour manager program
+//    Copyright (C) 2018  Steve M Clarke
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+//
+// Project Journal
+//
+
+#include "projectjournal.h"
+
+#include <QDataStream>
+
+#define PROJECT_JOURNAL_MAGIC 0x504D504A        // "PMPJ"
+
+ProjectJournal::ProjectJournal()
+{
+}
+
+ProjectJournal::~ProjectJournal()
+{
+    close() ;
+}
+
+QString ProjectJournal::journalFile(QString projectFile)
+{
+    return projectFile + ".journal" ;
+}
+
+bool ProjectJournal::append(QString projectFile, int version, const QByteArray& batch)
+{
+    QString filename = journalFile(projectFile) ;
+
+    if (m_file.isOpen() && m_file.fileName()!=filename) close() ;
+    if (!m_file.isOpen()) {
+        m_file.setFileName(filename) ;
+        if (!m_file.open(QIODevice::ReadWrite)) return false ;
+        if (m_file.size()==0) {
+            QDataStream out(&m_file) ;
+            out << (quint32)PROJECT_JOURNAL_MAGIC << (quint16)version ;
+        }
+        m_file.seek(m_file.size()) ;
+    }
+
+    QDataStream out(&m_file) ;
+    out << (quint32)batch.size() << (quint16)qChecksum(batch.constData(), batch.size()) ;
+    out.writeRawData(batch.constData(), batch.size()) ;
+    return out.status()==QDataStream::Ok && m_file.flush() ;
+}
+
+void ProjectJournal::remove(QString projectFile)
+{
+    close() ;
+    QFile::remove(journalFile(projectFile)) ;
+}
+
+void ProjectJournal::close()
+{
+    if (m_file.isOpen()) m_file.close() ;
+}
+
+QList<QByteArray> ProjectJournal::read(QString projectFile, int& version)
+{
+    QList<QByteArray> batches ;
+    QFile file(journalFile(projectFile)) ;
+    if (!file.open(QIODevice::ReadOnly)) return batches ;
+
+    QDataStream in(&file) ;
+    quint32 magic ;
+    quint16 fileversion ;
+    in >> magic >> fileversion ;
+    if (in.status()!=QDataStream::Ok || magic!=PROJECT_JOURNAL_MAGIC) return batches ;
+    version = fileversion ;
+
+    while (!in.atEnd()) {
+        quint32 length ;
+        quint16 checksum ;
+        in >> length >> checksum ;
+        if (in.status()!=QDataStream::Ok || length>file.size()) break ;
+        QByteArray batch(length, 0) ;
+        if (in.readRawData(batch.data(), length)!=(int)length) break ;
+        if (qChecksum(batch.constData(), batch.size())!=checksum) break ;
+        batches.append(batch) ;
+    }
+
+    return batches ;
+}
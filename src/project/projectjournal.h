@@ -0,0 +1,81 @@
+//    PanoManager - Interactive panorama tour manager program
+//    Copyright (C) 2018  Steve M Clarke
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+//
+// Project Journal
+//
+// An append-only file next to the project (<project>.journal), holding the
+// edits made since the project was last saved.  Project::journalChanges
+// appends each set of edits as one batch, and a project which is opened with
+// a journal (i.e. after a crash) replays it.  Saving the project writes every
+// edit into the project file, and removes the journal.
+//
+//   quint32 magic "PMPJ", quint16 record version
+//   per batch: quint32 length, quint16 checksum, data
+//
+// A batch which is incomplete or fails its checksum (the program stopped
+// while it was being written) ends the journal.  The records within a batch
+// are written and replayed by Project.
+//
+
+#ifndef PROJECTJOURNAL_H
+#define PROJECTJOURNAL_H
+
+#include <QString>
+#include <QFile>
+#include <QByteArray>
+#include <QList>
+
+class ProjectJournal
+{
+public:
+    typedef enum {
+        Settings = 1,           // QVariantMap
+        SceneHeader = 2,        // id, scene (see Project::writeScene)
+        NodeRecord = 3,         // scene id, node (see Project::writeNode)
+        RemoveScene = 4,        // id
+        RemoveNode = 5,         // scene id, node id
+        SceneOrder = 6,         // quint32 count, ids
+        NodeOrder = 7           // scene id, quint32 count, ids
+    } RecordType ;
+
+private:
+    QFile m_file ;
+
+public:
+    ProjectJournal() ;
+    ~ProjectJournal() ;
+
+private:
+    ProjectJournal(const ProjectJournal& other) ;
+    ProjectJournal& operator=(const ProjectJournal& rhs) ;
+
+public:
+    static QString journalFile(QString projectFile) ;
+
+    // Append a batch to the journal of projectFile, creating it if necessary,
+    // and flush it to disk
+    bool append(QString projectFile, int version, const QByteArray& batch) ;
+
+    // Close, and delete, the journal
+    void remove(QString projectFile) ;
+    void close() ;
+
+    // Read the complete batches from the journal of projectFile
+    static QList<QByteArray> read(QString projectFile, int& version) ;
+};
+
+#endif // PROJECTJOURNAL_H
@@ -0,0 +1,62 @@
+//    PanoManager - Interactive panorama tour manager program
+//    Copyright (C) 2018  Steve M Clarke
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+//
+// Project Observer
+//
+// Told when scenes, or a scene's nodes, are inserted, removed or moved, so a
+// view of them (see SceneListModel and NodeListModel) can update just the rows
+// which changed.  Each change is reported before it is made and again after,
+// as QAbstractItemModel requires.
+//
+// Opening or clearing a project is reported as a reset, and the changes made
+// while it is opened (e.g. journal replay) are not reported.  Changes to a
+// scene's or node's details are not reported, as they are made through the
+// scene or node itself, so the editor tells its views about those.
+//
+
+#ifndef PROJECTOBSERVER_H
+#define PROJECTOBSERVER_H
+
+#include <QList>
+#include "id.h"
+
+class ProjectObserver
+{
+public:
+    virtual ~ProjectObserver() {}
+
+    virtual void projectResetting() {}
+    virtual void projectReset() {}
+
+    virtual void sceneInserting(int /*row*/) {}
+    virtual void sceneInserted() {}
+    virtual void sceneRemoving(int /*row*/) {}
+    virtual void sceneRemoved() {}
+    virtual void sceneMoving(int /*from*/, int /*to*/) {}
+    virtual void sceneMoved() {}
+
+    virtual void nodeInserting(Id /*sceneId*/, int /*row*/) {}
+    virtual void nodeInserted(Id /*sceneId*/) {}
+    virtual void nodeRemoving(Id /*sceneId*/, int /*row*/) {}
+    virtual void nodeRemoved(Id /*sceneId*/) {}
+    virtual void nodeMoving(Id /*sceneId*/, int /*from*/, int /*to*/) {}
+    virtual void nodeMoved(Id /*sceneId*/) {}
+};
+
+typedef QList<ProjectObserver*> ProjectObserverList ;
+
+#endif // PROJECTOBSERVER_H
@@ -19,12 +19,30 @@
 //
 
 #include "scene.h"
-#include <QUuid>
+#include "project.h"
 #include <QFileInfo>
+#include <QDataStream>
+#include <QDebug>
+#include <QSharedData>
 
-Scene::Scene(bool isinvalid) : m_invalidnode(true)
+class SceneData : public QSharedData
 {
-    m_invalid = isinvalid ;
+public:
+    bool invalid, empty ;
+    int northOffset ;
+    QString filename ;
+    QString title ;
+    Id id ;
+
+    NodeList nodes ;
+    QHash<Id, int> nodeIndex ;          // id => position in nodes
+    NodeSource source ;                 // Nodes not yet loaded, if source.file is set
+    bool damaged ;                      // Nodes couldn't all be loaded from source
+};
+
+Scene::Scene(bool isinvalid) : d(new SceneData), m_invalidnode(true), m_observers(NULL)
+{
+    d->invalid = isinvalid ;
     clear() ;
 }
 
@@ -32,44 +50,45 @@ Scene::~Scene()
 {
 }
 
-Scene::Scene(const Scene& rhs)
+// Copies share the data, so this only bumps a reference count
+Scene::Scene(const Scene& rhs) : d(rhs.d), m_invalidnode(rhs.m_invalidnode), m_observers(NULL)
 {
     *this = rhs ;
 }
 
 Scene& Scene::operator=(const Scene& rhs)
 {
-    m_invalid = rhs.m_invalid ;
-    m_empty = rhs.m_empty ;
-    m_dirty = rhs.m_dirty ;
-    m_northOffset = rhs.m_northOffset ;
-    m_filename = rhs.m_filename ;
-    m_title = rhs.m_title ;
-    m_id = rhs.m_id ;
-    m_nodes = rhs.m_nodes ;
-    m_invalidnode = rhs.m_invalidnode ;
+    d = rhs.d ;
+    m_generation = rhs.m_generation ;
+    m_cleanGeneration = rhs.m_cleanGeneration ;
+    m_journaledGeneration = rhs.m_journaledGeneration ;
+    m_journalPending = rhs.m_journalPending ;
+    m_nodeOrderPending = rhs.m_nodeOrderPending ;
+    m_removedNodes = rhs.m_removedNodes ;
     return *this ;
 }
 
 
-int Scene::northOffset()
+int Scene::northOffset() const
 {
-    return m_northOffset ;
+    return d->northOffset ;
 }
 
 
-QString Scene::filename()
+QString Scene::filename() const
 {
-    return m_filename ;
+    return d->filename ;
 }
 
-QString Scene::folder()
+QString Scene::folder() const
 {
-    QFileInfo filename(m_filename) ;
-    return filename.canonicalPath() + "/" + filename.baseName() ;
+    // As SceneImage, the image may be missing (e.g. a scene imported from a tour)
+    QFileInfo filename(d->filename) ;
+    QString path = filename.exists() ? filename.canonicalPath() : filename.absolutePath() ;
+    return path + "/" + filename.baseName() ;
 }
 
-QString Scene::faceFilename(int face, bool highQuality)
+QString Scene::faceFilename(int face, bool highQuality) const
 {
     QString name ;
     name = folder() + "/" + "face00" + QString::number(face) ;
@@ -78,7 +97,7 @@ QString Scene::faceFilename(int face, bool highQuality)
     return name ;
 }
 
-bool Scene::imageFilesExist(bool highQuality)
+bool Scene::imageFilesExist(bool highQuality) const
 {
     int exists = true ;
     for (int i=0; i<6; i++) {
@@ -89,129 +108,309 @@ bool Scene::imageFilesExist(bool highQuality)
     return exists ;
 }
 
-QString Scene::title()
+QString Scene::title() const
 {
-    return m_title ;
+    return d->title ;
 }
 
-QString Scene::id()
+Id Scene::id() const
 {
-    return m_id ;
+    return d->id ;
 }
 
-QString Scene::titleId()
+QString Scene::titleId() const
 {
     // TODO: use regexp to replace all non a-z characters with ""
-    return m_title.replace(" ","").replace("\t", "").replace("\\","").replace("/","").replace(":","") ;
+    QString title = d->title ;
+    return title.replace(" ","").replace("\t", "").replace("\\","").replace("/","").replace(":","") ;
 }
 
-bool Scene::isEmpty()
+bool Scene::isEmpty() const
 {
-    return m_empty ;
+    return d->empty ;
 }
 
-bool Scene::isValid()
+bool Scene::isValid() const
 {
-    return !m_invalid ;
+    return !d->invalid ;
 }
 
-bool Scene::isDirty()
+bool Scene::isDirty() const
 {
-    bool dirty = false ;
-    for (int i=0; i<m_nodes.count(); i++) {
-        Node *node = (Node *)&m_nodes.at(i) ;
-        dirty |= node->isDirty() ;
-    }
-    return m_dirty || dirty ;
+    return m_generation.value()!=m_cleanGeneration ;
 }
 
-NodeList& Scene::nodes()
+const NodeList& Scene::nodes()
 {
-    return m_nodes ;
+    if (!nodesLoaded()) loadNodes() ;
+    return d.constData()->nodes ;
 }
 
-int Scene::nodeCount()
+// Known without loading the nodes
+int Scene::nodeCount() const
 {
-    return m_nodes.count() ;
+    if (!nodesLoaded()) return d->source.count ;
+    return d->nodes.count() ;
 }
 
 Node& Scene::nodeAt(int num)
 {
-    if (num<0 || num>=m_nodes.count()) return m_invalidnode ;
-    return (Node&)m_nodes.at(num) ;
+    if (!nodesLoaded()) loadNodes() ;
+    if (num<0 || num>=nodeCount()) return m_invalidnode ;
+    Node& node = d->nodes[num] ;
+    node.setOwner(&m_generation) ;
+    return node ;
+}
+
+Node& Scene::node(Id id)
+{
+    return nodeAt(nodeIndex(id)) ;
+}
+
+const Node& Scene::constNodeAt(int num)
+{
+    if (!nodesLoaded()) loadNodes() ;
+    if (num<0 || num>=nodeCount()) return m_invalidnode ;
+    return d.constData()->nodes.at(num) ;
+}
+
+const Node& Scene::constNode(Id id)
+{
+    return constNodeAt(nodeIndex(id)) ;
+}
+
+int Scene::nodeIndex(Id id)
+{
+    if (!nodesLoaded()) loadNodes() ;
+    const QHash<Id, int>& index = d.constData()->nodeIndex ;
+    QHash<Id, int>::const_iterator it = index.constFind(id) ;
+    if (it==index.constEnd()) return -1 ;
+    return it.value() ;
+}
+
+Node& Scene::addNode(const Node& node)
+{
+    if (!isValid()) return m_invalidnode ;
+    if (!nodesLoaded()) loadNodes() ;
+    Id sceneId = d.constData()->id ;
+    if (m_observers) foreach (ProjectObserver *o, *m_observers) o->nodeInserting(sceneId, nodeCount()) ;
+    d->nodes.append(node) ;
+    Node& added = d->nodes.last() ;
+    added.setOwner(&m_generation) ;
+    if (!d->nodeIndex.contains(added.id())) d->nodeIndex.insert(added.id(), d->nodes.count()-1) ;
+    d->empty=false ;
+    m_generation.bump() ;
+    if (m_observers) foreach (ProjectObserver *o, *m_observers) o->nodeInserted(sceneId) ;
+    return added ;
+}
+
+bool Scene::removeNode(Id id)
+{
+    int num = nodeIndex(id) ;
+    if (num<0) return false ;
+    Id sceneId = d.constData()->id ;
+    if (m_observers) foreach (ProjectObserver *o, *m_observers) o->nodeRemoving(sceneId, num) ;
+    d->nodes.removeAt(num) ;
+    reindexNodes() ;
+    m_removedNodes.append(id) ;
+    m_generation.bump() ;
+    if (m_observers) foreach (ProjectObserver *o, *m_observers) o->nodeRemoved(sceneId) ;
+    return true ;
+}
+
+bool Scene::moveNode(int from, int to)
+{
+    if (!nodesLoaded()) loadNodes() ;
+    if (from<0 || from>=nodeCount() || to<0 || to>=nodeCount()) return false ;
+    if (from==to) return true ;
+    Id sceneId = d.constData()->id ;
+    if (m_observers) foreach (ProjectObserver *o, *m_observers) o->nodeMoving(sceneId, from, to) ;
+    d->nodes.move(from, to) ;
+    reindexNodes() ;
+    m_nodeOrderPending=true ;
+    m_generation.bump() ;
+    if (m_observers) foreach (ProjectObserver *o, *m_observers) o->nodeMoved(sceneId) ;
+    return true ;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// setNodeSource / loadNodes - Nodes left in the project file until they are used
+//
+
+void Scene::setNodeSource(const NodeSource& source)
+{
+    d->nodes.clear() ;
+    d->nodeIndex.clear() ;
+    d->source = source ;
+    d->damaged = false ;
+}
+
+bool Scene::nodesLoaded() const
+{
+    return !d->source.file ;
 }
 
-Node& Scene::node(QString id)
+bool Scene::nodesDamaged() const
 {
-    for (int i=0; i<m_nodes.count(); i++) {
-        if (m_nodes[i].id().compare(id)==0) return m_nodes[i] ;
+    return d->damaged ;
+}
+
+// Loading is not an edit, so the nodes are clean and the generation is unchanged
+void Scene::loadNodes()
+{
+    NodeSource source = d->source ;
+    QSharedPointer<QFile> file = source.file ;
+    d->source.file.clear() ;
+
+    if (!file->seek(source.offset)) {
+        qDebug() << "Scene::loadNodes: unable to seek in " << file->fileName() ;
+        d->damaged = true ;
+        return ;
+    }
+
+    QDataStream in(file.data()) ;
+    in.setVersion(QDataStream::Qt_5_9) ;
+    NodeList& nodes = d->nodes ;
+    nodes.reserve(source.count) ;
+    for (int n=0; n<source.count; n++) {
+        Node newNode ;
+        Project::readNode(in, newNode, source.version) ;
+        if (in.status()!=QDataStream::Ok) break ;
+        newNode.markClean() ;
+        nodes.append(newNode) ;
+    }
+    if (in.status()!=QDataStream::Ok) {
+        qDebug() << "Scene::loadNodes: unable to read nodes from " << file->fileName() ;
+        d->damaged = true ;
     }
-    return m_invalidnode ;
+    reindexNodes() ;
 }
 
-bool Scene::removeNode(QString id)
+// Rebuild the id index after nodes have moved, keeping the first of any duplicate ids
+void Scene::reindexNodes()
 {
-    for (int i=0; i<m_nodes.count(); i++) {
-        if (m_nodes[i].id().compare(id)==0) {
-            m_nodes.removeAt(i) ;
-            return true ;
-        }
+    SceneData *data = d.data() ;
+    data->nodeIndex.clear() ;
+    data->nodeIndex.reserve(data->nodes.count()) ;
+    for (int i=0; i<data->nodes.count(); i++) {
+        Id id = data->nodes.at(i).id() ;
+        if (!data->nodeIndex.contains(id)) data->nodeIndex.insert(id, i) ;
     }
-    return false ;
 }
 
 void Scene::setNorthOffset(int offset)
 {
-    if (m_invalid) return ;
-    m_northOffset = offset ;
-    m_empty=false ;
-    m_dirty=true ;
+    if (!isValid()) return ;
+    d->northOffset = offset ;
+    d->empty=false ;
+    m_journalPending=true ;
+    m_generation.bump() ;
 }
 
 void Scene::setFilename(QString sourceFilename)
 {
-    if (m_invalid) return ;
-    m_filename = sourceFilename ;
-    m_empty=false ;
-    m_dirty=true ;
+    if (!isValid()) return ;
+    d->filename = sourceFilename ;
+    d->empty=false ;
+    m_journalPending=true ;
+    m_generation.bump() ;
 }
 
 void Scene::setTitle(QString title)
 {
-    if (m_invalid) return ;
-    m_title = title ;
-    m_empty=false ;
-    m_dirty=true ;
+    if (!isValid()) return ;
+    d->title = title ;
+    d->empty=false ;
+    m_journalPending=true ;
+    m_generation.bump() ;
 }
 
-void Scene::setId(QString id)
+void Scene::setId(Id id)
 {
-    if (m_invalid || id.isEmpty() || id.length()<10) return ;
-    m_id = id.replace("{","").replace("}","").replace("-","") ;
+    if (!isValid() || id.isNull()) return ;
+    d->id = id ;
 }
 
 void Scene::markClean()
 {
-    m_dirty = false ;
-    for (int i=0; i<m_nodes.count(); i++) {
-        m_nodes[i].markClean();
+    m_cleanGeneration = m_generation.value() ;
+    for (int i=0; i<d.constData()->nodes.count(); i++) {
+        if (d.constData()->nodes.at(i).journalPending() || d.constData()->nodes.at(i).isDirty()) d->nodes[i].markClean() ;
     }
+    markJournaled() ;
 }
 
-void Scene::clear()
+bool Scene::hasUnjournaledChanges() const
 {
-    QUuid uuid ;
-    if (m_invalid)
-        setId(uuid.toString()) ;
-    else
-        setId(uuid.createUuid().toString()) ;
+    return m_generation.value()!=m_journaledGeneration ;
+}
+
+bool Scene::journalPending() const
+{
+    return m_journalPending ;
+}
 
-    m_northOffset = 0 ;
-    m_filename.clear() ;
-    m_title.clear() ;
-    m_nodes.clear() ;
+bool Scene::nodeOrderPending() const
+{
+    return m_nodeOrderPending ;
+}
 
-    m_empty = true ;
-    m_dirty = false ;
+const QList<Id>& Scene::removedNodes() const
+{
+    return m_removedNodes ;
+}
+
+void Scene::setOwner(Generation *owner, const ProjectObserverList *observers)
+{
+    m_generation.setParent(owner) ;
+    m_observers = observers ;
+}
+
+void Scene::markJournaled()
+{
+    m_journaledGeneration = m_generation.value() ;
+    m_journalPending = false ;
+    m_nodeOrderPending = false ;
+    m_removedNodes.clear() ;
+    for (int i=0; i<d.constData()->nodes.count(); i++) {
+        if (d.constData()->nodes.at(i).journalPending()) d->nodes[i].markJournaled() ;
+    }
+}
+
+void Scene::markUnjournaled()
+{
+    if (!nodesLoaded()) loadNodes() ;
+    m_journalPending = true ;
+    for (int i=0; i<d->nodes.count(); i++) {
+        d->nodes[i].setOwner(&m_generation) ;
+        d->nodes[i].markUnjournaled() ;
+    }
+    m_generation.bump() ;
+}
+
+void Scene::clear()
+{
+    if (d->invalid)
+        d->id = Id() ;
+    else
+        d->id = Id::create() ;
+
+    d->northOffset = 0 ;
+    d->filename.clear() ;
+    d->title.clear() ;
+    d->nodes.clear() ;
+    d->nodeIndex.clear() ;
+    d->source.file.clear() ;
+    d->damaged = false ;
+
+    // A new scene is clean, but has still to be journaled
+    d->empty = true ;
+    m_journaledGeneration = m_generation.value() ;
+    m_generation.bump() ;
+    m_cleanGeneration = m_generation.value() ;
+    m_journalPending = true ;
+    m_nodeOrderPending = false ;
+    m_removedNodes.clear() ;
 
 }
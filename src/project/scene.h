@@ -23,19 +23,44 @@
 
 #include <QList>
 #include <QString>
+#include <QHash>
+#include <QFile>
+#include <QSharedPointer>
+#include <QSharedDataPointer>
 #include "node.h"
+#include "id.h"
+#include "generation.h"
+#include "projectobserver.h"
 
+// Where the nodes of a lazily loaded scene are read from, when they are first used.
+// The file is shared by the scenes of a project, and closed once all have loaded.
+typedef struct {
+    QSharedPointer<QFile> file ;
+    int version ;
+    qint64 offset ;
+    int count ;
+} NodeSource ;
+
+class SceneData ;
+
+// Scenes are implicitly shared, so copying one only copies a pointer.  The
+// title, filename and nodes are copied when a shared scene is first changed.
+// The edit tracking belongs to each copy.
 class Scene
 {
   private:
-    bool m_invalid, m_empty, m_dirty ;
-    int m_northOffset ;
-    QString m_filename ;
-    QString m_title ;
-    QString m_id ;
-
-    NodeList m_nodes ;
+    QSharedDataPointer<SceneData> d ;
+    Generation m_generation ;           // Bumped by every edit to the scene or its nodes
+    quint64 m_cleanGeneration ;         // Generation when last saved
+    quint64 m_journaledGeneration ;     // Generation when last journaled
+    bool m_journalPending ;             // Title, filename or north changed since last journaled
+    bool m_nodeOrderPending ;           // Nodes reordered since last journaled
+    QList<Id> m_removedNodes ;          // Nodes removed since last journaled
     Node m_invalidnode ;
+    const ProjectObserverList *m_observers ; // Told of node changes, set by the owner (not copied)
+
+    void reindexNodes() ;
+    void loadNodes() ;
 
   public:
     Scene(bool isinvalid=false);
@@ -44,32 +69,58 @@ class Scene
     Scene& operator=(const Scene& rhs) ;
 
 public:
-    int northOffset() ;
-    QString title() ;
-    QString id() ;
-    QString titleId() ;
-    QString filename() ;
-    QString folder() ;
-    QString faceFilename(int face, bool highQuality=false) ;
-    bool imageFilesExist(bool highQuality=false) ;
-
-    bool isEmpty() ;
-    bool isValid() ;
-    bool isDirty() ;
-
-    int nodeCount() ;
-    NodeList& nodes() ;
+    int northOffset() const ;
+    QString title() const ;
+    Id id() const ;
+    QString titleId() const ;
+    QString filename() const ;
+    QString folder() const ;
+    QString faceFilename(int face, bool highQuality=false) const ;
+    bool imageFilesExist(bool highQuality=false) const ;
+
+    bool isEmpty() const ;
+    bool isValid() const ;
+    bool isDirty() const ;
+
+    // Changes not yet written to the project journal (see Project::journalChanges)
+    bool hasUnjournaledChanges() const ;
+    bool journalPending() const ;
+    bool nodeOrderPending() const ;
+    const QList<Id>& removedNodes() const ;
+
+    // Nodes are added and removed through the scene, so that lookups by id stay
+    // constant time.  A node's id must not change once it has been added.
+    int nodeCount() const ;
+    const NodeList& nodes() ;
     Node& nodeAt(int num) ;
-    Node& node(QString id) ;
-    bool removeNode(QString id) ;
+    Node& node(Id id) ;
+
+    // Read only access, which never copies nodes shared with another scene (nodeAt and
+    // node copy them, as the node returned may be changed)
+    const Node& constNodeAt(int num) ;
+    const Node& constNode(Id id) ;
+    int nodeIndex(Id id) ;
+    Node& addNode(const Node& node) ;
+    bool removeNode(Id id) ;
+    bool moveNode(int from, int to) ;
+
+    void setNodeSource(const NodeSource& source) ;
+    bool nodesLoaded() const ;
+
+    // True if the nodes couldn't all be read from the project file, in which case
+    // nodeCount() is the number which were read
+    bool nodesDamaged() const ;
 
 
     void setNorthOffset(int offset) ;
     void setFilename(QString sourceFilename) ;
     void setTitle(QString title) ;
     void markClean() ;
+    void markJournaled() ;
+    void markUnjournaled() ;            // Write the whole scene to the journal again, e.g. when restored
+    void setOwner(Generation *owner, const ProjectObserverList *observers=NULL) ; // Called by Project whenever it hands out the scene
     void clear() ;
-    void setId(QString id) ;
+    void setId(Id id) ;
 };
 
 typedef QList<Scene> SceneList;
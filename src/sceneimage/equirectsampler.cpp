@@ -0,0 +1,234 @@
+//    PanoManager - Interactive panorama tour manager program
+//    Copyright (C) 2018  Steve M Clarke
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+//
+// Equirectangular Sampler
+//
+
+#include "equirectsampler.h"
+
+#include <QVector>
+#include <QtCore/qmath.h>
+
+// Sources are halved while a pixel at the centre of a face still covers this many source pixels across
+#define EQUIRECTSAMPLER_OVERSAMPLE 2
+
+EquirectSampler::EquirectSampler()
+{
+}
+
+bool EquirectSampler::load(QString filename)
+{
+    QImage source ;
+    if (!source.load(filename)) {
+        clear() ;
+        return false ;
+    }
+    setSource(source) ;
+    return true ;
+}
+
+void EquirectSampler::setSource(const QImage& source)
+{
+    clear() ;
+    if (source.isNull()) return ;
+    if (source.format()==QImage::Format_RGB32 || source.format()==QImage::Format_ARGB32) m_levels.append(source) ;
+    else m_levels.append(source.convertToFormat(source.hasAlphaChannel() ? QImage::Format_ARGB32 : QImage::Format_RGB32)) ;
+}
+
+void EquirectSampler::clear()
+{
+    m_levels.clear() ;
+}
+
+bool EquirectSampler::isNull() const { return m_levels.isEmpty() ; }
+int EquirectSampler::width() const { return m_levels.isEmpty() ? 0 : m_levels.first().width() ; }
+int EquirectSampler::height() const { return m_levels.isEmpty() ? 0 : m_levels.first().height() ; }
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// sourceFor - The smallest halving of the source which is still oversampled for faces of size
+//
+
+const QImage& EquirectSampler::sourceFor(int size)
+{
+    // Each face covers a quarter of the source's width
+    int wanted = size * 4 * EQUIRECTSAMPLER_OVERSAMPLE ;
+    while (m_levels.last().width()/2 >= wanted && m_levels.last().height()>=2) {
+        m_levels.append(halve(m_levels.last())) ;
+    }
+    for (int i=m_levels.count()-1; i>0; i--) {
+        if (m_levels.at(i).width() >= wanted) return m_levels.at(i) ;
+    }
+    return m_levels.first() ;
+}
+
+QImage EquirectSampler::halve(const QImage& img)
+{
+    int w = img.width() / 2 ;
+    int h = img.height() / 2 ;
+    QImage half(w, h, img.format()) ;
+    if (half.isNull()) return img ;
+
+    for (int y=0; y<h; y++) {
+        const QRgb *row0 = (const QRgb *)img.constScanLine(y*2) ;
+        const QRgb *row1 = (const QRgb *)img.constScanLine(y*2+1) ;
+        QRgb *out = (QRgb *)half.scanLine(y) ;
+        for (int x=0; x<w; x++) {
+            QRgb p0 = row0[x*2], p1 = row0[x*2+1], p2 = row1[x*2], p3 = row1[x*2+1] ;
+            out[x] = qRgba((qRed(p0) + qRed(p1) + qRed(p2) + qRed(p3) + 2) / 4,
+                           (qGreen(p0) + qGreen(p1) + qGreen(p2) + qGreen(p3) + 2) / 4,
+                           (qBlue(p0) + qBlue(p1) + qBlue(p2) + qBlue(p3) + 2) / 4,
+                           (qAlpha(p0) + qAlpha(p1) + qAlpha(p2) + qAlpha(p3) + 2) / 4) ;
+        }
+    }
+    return half ;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// direction - Longitude (0 at the centre of the source, increasing to the right) and latitude
+//             (-pi/2 at the top) of the point (a, b) on a face, where a and b run from -1 to 1
+//             across and down the face.  This is the projection used by MapTranslation::build.
+//
+
+void EquirectSampler::direction(int face, double a, double b, double *lon, double *lat)
+{
+    if (face<4) {
+        // Front, right, back, left
+        *lon = qAtan(a) + face * M_PI_2 ;
+        *lat = qAtan(b / qSqrt(1 + a*a)) ;
+    } else if (face==4) {
+        // Up
+        *lon = qAtan2(-b, a) + M_PI_2 ;
+        *lat = qAtan(qSqrt(a*a + b*b)) - M_PI_2 ;
+    } else {
+        // Down
+        *lon = qAtan2(b, a) + M_PI_2 ;
+        *lat = M_PI_2 - qAtan(qSqrt(a*a + b*b)) ;
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// face - Average the source over each face pixel's footprint
+//
+
+QImage EquirectSampler::face(int face, int size)
+{
+    if (m_levels.isEmpty() || face<0 || face>5 || size<=0) return QImage() ;
+
+    const QImage& src = sourceFor(size) ;
+    int w = src.width() ;
+    int h = src.height() ;
+
+    QImage dest(size, size, src.format()) ;
+    if (dest.isNull()) return dest ;
+
+    // Source coordinates of the pixel corners, for the rows above and below the current row
+    QVector<double> sx[2], sy[2] ;
+    for (int r=0; r<2; r++) {
+        sx[r].resize(size+1) ;
+        sy[r].resize(size+1) ;
+    }
+
+    for (int y=0; y<=size; y++) {
+
+        int cur = y & 1 ;
+        double b = (2.0 * y) / size - 1 ;
+        for (int x=0; x<=size; x++) {
+            double lon, lat ;
+            direction(face, (2.0 * x) / size - 1, b, &lon, &lat) ;
+            sx[cur][x] = (lon / (2*M_PI) + 0.5) * w ;
+            sy[cur][x] = (lat / M_PI + 0.5) * h ;
+        }
+        if (y==0) continue ;
+
+        // Fill row y-1, whose top corners are in prev and bottom corners in cur
+        int prev = cur ^ 1 ;
+        double bc = (2.0 * (y-0.5)) / size - 1 ;
+        QRgb *out = (QRgb *)dest.scanLine(y-1) ;
+
+        for (int x=0; x<size; x++) {
+
+            double lon, lat ;
+            direction(face, (2.0 * (x+0.5)) / size - 1, bc, &lon, &lat) ;
+            double cx = (lon / (2*M_PI) + 0.5) * w ;
+            double cy = (lat / M_PI + 0.5) * h ;
+
+            double corners[4][2] = { { sx[prev][x], sy[prev][x] }, { sx[prev][x+1], sy[prev][x+1] },
+                                     { sx[cur][x], sy[cur][x] }, { sx[cur][x+1], sy[cur][x+1] } } ;
+
+            double x0 = cx, x1 = cx, y0 = cy, y1 = cy ;
+            for (int c=0; c<4; c++) {
+                y0 = qMin(y0, corners[c][1]) ;
+                y1 = qMax(y1, corners[c][1]) ;
+
+                // A corner on the pole has no longitude
+                int cornerx = x + (c & 1) ;
+                int cornery = y - 1 + (c >> 1) ;
+                if (face>=4 && 2*cornerx==size && 2*cornery==size) continue ;
+
+                // Longitudes are taken on the same side of the seam as the centre
+                double px = corners[c][0] ;
+                while (px < cx - w/2.0) px += w ;
+                while (px > cx + w/2.0) px -= w ;
+                x0 = qMin(x0, px) ;
+                x1 = qMax(x1, px) ;
+            }
+
+            // A pixel containing the pole (at the centre of the up / down face) covers every longitude
+            bool pole = (face>=4) && (2*x<size && 2*(x+1)>size) && (2*(y-1)<size && 2*y>size) ;
+            if (pole) {
+                x0 = 0 ;
+                x1 = w ;
+                if (face==4) y0 = 0 ;
+                else y1 = h ;
+            }
+
+            // Footprints smaller than a source pixel are widened to one pixel, around the centre
+            if (x1 - x0 < 1) { x0 = cx - 0.5 ; x1 = cx + 0.5 ; }
+            if (y1 - y0 < 1) { y0 = cy - 0.5 ; y1 = cy + 0.5 ; }
+            y0 = qMax(0.0, y0) ;
+            y1 = qMin((double)h, y1) ;
+
+            double sr=0, sg=0, sb=0, sa=0, sw=0 ;
+            for (int j=qFloor(y0); j<qCeil(y1); j++) {
+                double wy = qMin(j+1.0, y1) - qMax((double)j, y0) ;
+                if (wy<=0) continue ;
+                const QRgb *row = (const QRgb *)src.constScanLine(qBound(0, j, h-1)) ;
+                for (int i=qFloor(x0); i<qCeil(x1); i++) {
+                    double wt = (qMin(i+1.0, x1) - qMax((double)i, x0)) * wy ;
+                    if (wt<=0) continue ;
+                    QRgb p = row[((i % w) + w) % w] ;
+                    sr += qRed(p) * wt ;
+                    sg += qGreen(p) * wt ;
+                    sb += qBlue(p) * wt ;
+                    sa += qAlpha(p) * wt ;
+                    sw += wt ;
+                }
+            }
+
+            if (sw>0) {
+                out[x] = qRgba((int)(sr/sw + 0.5), (int)(sg/sw + 0.5), (int)(sb/sw + 0.5), (int)(sa/sw + 0.5)) ;
+            } else {
+                out[x] = qRgba(0, 0, 0, 255) ;
+            }
+        }
+    }
+
+    return dest ;
+}
@@ -0,0 +1,71 @@
+//    PanoManager - Interactive panorama tour manager program
+//    Copyright (C) 2018  Steve M Clarke
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+//
+// Equirectangular Sampler
+//
+// Generates cube faces of any size directly from an equirectangular image,
+// without building the hi-res faces or a translation map.  Each face pixel
+// is the area weighted average of the source pixels under its footprint (the
+// range of longitude and latitude its corners cover), so small faces don't
+// alias, and the result doesn't depend on a larger face having been built.
+//
+// Sources much larger than the requested face are first halved (2x2 box
+// averages) until the footprints are a few pixels across, so the cost of a
+// face depends on its size rather than on the source resolution.  The halved
+// images are kept, so sampling several small levels only reduces once.
+//
+// Faces match the orientation of those built by Face::build, in the order
+// front, right, back, left, up, down.
+//
+
+#ifndef EQUIRECTSAMPLER_H
+#define EQUIRECTSAMPLER_H
+
+#include <QString>
+#include <QImage>
+#include <QList>
+
+class EquirectSampler
+{
+private:
+    QList<QImage> m_levels ;   // Source, followed by successive halvings of it
+
+    const QImage& sourceFor(int size) ;
+    static QImage halve(const QImage& img) ;
+    static void direction(int face, double a, double b, double *lon, double *lat) ;
+
+public:
+    EquirectSampler() ;
+
+private:
+    EquirectSampler(const EquirectSampler& other) ;
+    EquirectSampler& operator=(const EquirectSampler& rhs) ;
+
+public:
+    bool load(QString filename) ;
+    void setSource(const QImage& source) ;
+    void clear() ;
+
+    bool isNull() const ;
+    int width() const ;
+    int height() const ;
+
+    // Returns face (0-5) at size x size, or a null image if there is no source
+    QImage face(int face, int size) ;
+};
+
+#endif // EQUIRECTSAMPLER_H
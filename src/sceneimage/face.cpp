@@ -27,6 +27,11 @@
 #include <QApplication>
 #include <QStandardPaths>
 #include <QDir>
+#include <QFileInfo>
+#include <QStringList>
+#include <QFile>
+#include <QBuffer>
+#include <QSaveFile>
 #include <QMessageBox>
 #include <QDebug>
 
@@ -134,75 +139,155 @@ PM::Err Face::build(MapTranslation &map, QImage source, int f, int size)
 /// \param tilesize
 /// \param outputFolder
 /// \param mask
+/// \param dedup
+/// \param pack
+/// \param encoder
+/// \param writer
 /// \return
 ///
 
 //!!TODO Percent Update
 
-PM::Err Face::exportTiles(int targetimagesize, int tilesize, QString outputFolder, QString mask)
+static bool saveTile(const QImage& tile, const QString& filename, const char *format, TileEncoder *encoder)
+{
+    if (encoder) return encoder->encode(tile, filename) ;
+
+    // Written to a temporary file, and renamed into place, so a tile is never left half written
+    QSaveFile file(filename) ;
+    if (!file.open(QIODevice::WriteOnly)) return false ;
+    if (!tile.save(&file, format)) {
+        file.cancelWriting() ;
+        return false ;
+    }
+    return file.commit() ;
+}
+
+static bool encodeTile(const QImage& tile, const QString& filename, const char *format, TileEncoder *encoder, QByteArray& data)
+{
+    if (encoder) return encoder->encode(tile, filename, data) ;
+    QBuffer buffer(&data) ;
+    buffer.open(QIODevice::WriteOnly) ;
+    return tile.save(&buffer, format) ;
+}
+
+PM::Err Face::exportTiles(int targetimagesize, int tilesize, QString outputFolder, QString mask,
+                          TileDeduplicator *dedup, TilePack *pack, TileEncoder *encoder, TileWriter *writer)
 {
     m_abort = false ;
     emit(QString("Exporting Tiles for image size: ") + QString::number(targetimagesize) +
             QString("x") + QString::number(targetimagesize)) ;
 
     if (outputFolder.isEmpty()) return PM::OutputNotDefined ;
-    if (targetimagesize<=0) return PM::InvalidTargetImageSize ;
+    if (targetimagesize<=0 || tilesize<=0) return PM::InvalidTargetImageSize ;
 
     int width = targetimagesize ;
     int height = targetimagesize ;
 
     QImage img = scaled(width, height, Qt::IgnoreAspectRatio, Qt::SmoothTransformation) ;
 
-    PM::Err err = PM::Ok ;
+    // Tiles are views into the level image, so use a format the encoder reads directly,
+    // rather than converting every tile
+    if (img.format()!=QImage::Format_RGB32 && img.format()!=QImage::Format_ARGB32) {
+        img = img.convertToFormat(img.hasAlphaChannel() ? QImage::Format_ARGB32 : QImage::Format_RGB32) ;
+    }
+    if (img.isNull()) return PM::OutOfMemory ;
+
+    const uchar *bits = img.constBits() ;
+    int bytesperline = img.bytesPerLine() ;
+    int bytesperpixel = img.depth() / 8 ;
+
+    int columns = (width + tilesize - 1) / tilesize ;
+    int rows = (height + tilesize - 1) / tilesize ;
+
+    // The format is the same for every tile, so is only looked up once
+    QString path = outputFolder + QString("/") + mask ;
+    QString suffix = QFileInfo(path).suffix() ;
+    QByteArray format = suffix.toLatin1() ;
+    TileEncoder *tileencoder = (encoder && TileEncoder::formatSupported(suffix)) ? encoder : NULL ;
+
+    // Path template, split around the column (e.g. ".../f/%y/" + x + ".jpg"), and the
+    // column numbers, so each tile's filename is built by appending to a reused string
+    int xpos = path.indexOf(QString("%x")) ;
+    QString head = (xpos<0) ? path : path.left(xpos) ;
+    QString tail = (xpos<0) ? QString() : path.mid(xpos+2) ;
+    QStringList columnNames ;
+    for (int x=0; x<columns; x++) columnNames.append((xpos<0) ? QString() : QString::number(x)) ;
+
+    // Create the output file hierarchy for the whole level up front.  Masks name the
+    // column in the filename, so each row is a single folder.
+    if (!pack) {
+        QDir dir ;
+        for (int y=0; y<rows; y++) {
+            QString folder = QFileInfo(QString(head + tail).replace(QString("%y"), QString::number(y))).absolutePath() ;
+            if (!dir.exists(folder) && !dir.mkpath(folder)) return PM::OutputWriteError ;
+        }
+    }
 
-    int y=0 ;
-    bool doney=false ;
+    // Scratch buffers, reused for every tile
+    QString outputfile ;
+    QByteArray data ;
 
-    do {
+    PM::Err err = PM::Ok ;
 
-        bool donex=false ;
-        int x=0 ;
+    for (int y=0; y<rows && err==PM::Ok; y++) {
 
         emit(percentUpdate((y*tilesize*100)/height)) ;
         QCoreApplication::processEvents();
-        if (m_abort) { err = PM::OperationCancelled ; }
-
-        do {
-            // Calculate the width and height of the tile
-            int sizex=tilesize ;
-            int sizey=tilesize ;
-            if (((x+1)*tilesize)>=width) {
-                sizex=width-(x*tilesize) ;
-                donex=true ;
-            }
-            if (((y+1)*tilesize)>=height) {
-                sizey=height-(y*tilesize) ;
-                doney=true ;
-            }
+        if (m_abort) { err = PM::OperationCancelled ; break ; }
+
+        QString rowhead = QString(head).replace(QString("%y"), QString::number(y)) ;
+        QString rowtail = QString(tail).replace(QString("%y"), QString::number(y)) ;
+        int sizey = qMin(tilesize, height-(y*tilesize)) ;
+
+        for (int x=0; x<columns && err==PM::Ok; x++) {
+
+            int sizex = qMin(tilesize, width-(x*tilesize)) ;
 
             // Calculate the filename for the destination image
-            QString outputfile = outputFolder + QString("/") + mask ;
-            outputfile.replace(QString("%x"), QString::number(x)).replace(QString("%y"), QString::number(y)) ;
+            outputfile.resize(0) ;
+            outputfile.append(rowhead).append(columnNames.at(x)).append(rowtail) ;
 
-            // Extract the image from the requested face
-            QImage dest(sizex, sizey, QImage::Format_ARGB32) ;
-            dest = img.copy(x*tilesize, y*tilesize, sizex, sizey) ;
+            // The tile is a view of the level image, sharing its scanlines rather than copying them
+            QImage dest(bits + ((qint64)y*tilesize*bytesperline) + (x*tilesize*bytesperpixel),
+                        sizex, sizey, bytesperline, img.format()) ;
 
-            // Create the output file hierarchy
-            QFileInfo fi(outputfile) ;
-            QDir dir ;
-            if (!dir.exists(fi.absolutePath()) && !dir.mkpath(fi.absolutePath())) return PM::OutputWriteError ;
+            if (pack) {
 
-            // And save it
-            if (!dest.save(outputfile)) err = PM::OutputWriteError ;
+                // Append the tile to the scene's pack, unless an identical tile is already in it
+                QByteArray hash = dedup ? dedup->hash(dest) : QByteArray() ;
+                if (!pack->link(hash, outputfile, dedup)) {
+                    if (!encodeTile(dest, outputfile, format.constData(), tileencoder, data) ||
+                            !pack->add(hash, outputfile, data, dedup)) err = PM::OutputWriteError ;
+                }
 
-            x++ ;
+            } else if (writer) {
 
-        } while (!donex && err==PM::Ok) ;
+                // Encode the tile here, and leave the writer's threads to write it, or to link
+                // it to an identical tile
+                QByteArray hash = dedup ? dedup->hash(dest) : QByteArray() ;
+                if (!dedup || !dedup->link(hash, outputfile, writer)) {
+                    if (!encodeTile(dest, outputfile, format.constData(), tileencoder, data) ||
+                            !writer->write(outputfile, data)) err = PM::OutputWriteError ;
+                    else if (dedup) dedup->add(hash, outputfile, data.size()) ;
+                }
 
-        y++ ;
+            } else if (dedup) {
 
-    } while (!doney && err==PM::Ok) ;
+                // Save it, unless an identical tile has already been written
+                QByteArray hash = dedup->hash(dest) ;
+                if (!dedup->link(hash, outputfile)) {
+                    // saveTile replaces the file, so never writes through a link left by a previous export
+                    if (!saveTile(dest, outputfile, format.constData(), tileencoder)) err = PM::OutputWriteError ;
+                    else dedup->add(hash, outputfile) ;
+                }
+
+            } else {
+
+                if (!saveTile(dest, outputfile, format.constData(), tileencoder)) err = PM::OutputWriteError ;
+
+            }
+        }
+    }
 
     if (err==PM::Ok) emit(percentUpdate(100)) ;
 
@@ -26,6 +26,10 @@
 #include <QObject>
 #include "../errors/pmerrors.h"
 #include "maptranslation.h"
+#include "tilededuplicator.h"
+#include "tilepack.h"
+#include "tileencoder.h"
+#include "tilewriter.h"
 
 class Face : public QObject, public QImage
 {
@@ -52,8 +56,16 @@ public:
     PM::Err build(MapTranslation& map, QImage source, int f, int size) ;
 
     // Export targetimageszie sized image made of tilessize sized tiles to outputFolder,
-    // using mask to create individual files.
-    PM::Err exportTiles(int targetimagesize, int tilesize, QString outputFolder, QString mask) ;
+    // using mask to create individual files.  If dedup is supplied, tiles identical to
+    // ones already written are hard linked rather than encoded again.  If pack is supplied,
+    // tiles are appended to it instead of being written as individual files.  JPEG and WebP
+    // tiles are compressed with encoder if supplied, otherwise with Qt's default settings.
+    // Tiles are encoded from views into the scaled image, without being copied.  If writer
+    // is supplied, individual tile files are written asynchronously, and are only complete
+    // once the writer has finished.
+    PM::Err exportTiles(int targetimagesize, int tilesize, QString outputFolder, QString mask,
+                        TileDeduplicator *dedup = NULL, TilePack *pack = NULL, TileEncoder *encoder = NULL,
+                        TileWriter *writer = NULL) ;
 
     // Copy Face to Face
     Face& operator=(const Face& d)
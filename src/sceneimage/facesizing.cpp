@@ -0,0 +1,101 @@
+//    PanoManager - Interactive panorama tour manager program
+//    Copyright (C) 2018  Steve M Clarke
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+//
+// Face Sizing
+//
+
+#include "facesizing.h"
+
+#include <QImageReader>
+#include <QtCore/qmath.h>
+
+FaceSizing::FaceSizing(Policy policy, int tileSize, int maxSize)
+{
+    m_policy = policy ;
+    m_tileSize = (tileSize>0) ? tileSize : 256 ;
+    m_maxSize = (maxSize>0) ? maxSize : 0 ;
+}
+
+FaceSizing::Policy FaceSizing::policy() const { return m_policy ; }
+int FaceSizing::tileSize() const { return m_tileSize ; }
+int FaceSizing::maxSize() const { return m_maxSize ; }
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// faceSize - Apply the policy, and the maximum size
+//
+
+int FaceSizing::faceSize(int sourcewidth, int sourceheight) const
+{
+    if (sourcewidth<=0 || sourceheight<=0) return 0 ;
+
+    int size ;
+    if (m_policy==MatchSource) {
+        size = qRound((sourcewidth / M_PI) / m_tileSize) * m_tileSize ;
+        if (size<m_tileSize) size = m_tileSize ;
+    } else {
+        size = sourceheight ;
+    }
+
+    // The limit is kept to a whole number of tiles where it can be
+    if (m_maxSize>0 && size>m_maxSize) {
+        size = (m_maxSize>=m_tileSize) ? (m_maxSize / m_tileSize) * m_tileSize : m_maxSize ;
+    }
+    return size ;
+}
+
+int FaceSizing::faceSize(QString sourcefile) const
+{
+    QSize size = QImageReader(sourcefile).size() ;
+    if (!size.isValid()) return 0 ;
+    return faceSize(size.width(), size.height()) ;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// levels / levelSize - The top level is the face size, and each level below is half the size
+//                      of the one above, until a level fits in a single tile
+//
+
+int FaceSizing::levels(int facesize) const
+{
+    if (facesize<=0) return 0 ;
+    int levels = 1 ;
+    while (facesize>m_tileSize) {
+        facesize = (facesize + 1) / 2 ;
+        levels++ ;
+    }
+    return levels ;
+}
+
+int FaceSizing::levelSize(int facesize, int level) const
+{
+    int n = levels(facesize) ;
+    if (level<1 || level>n) return 0 ;
+    for (int l=n; l>level; l--) facesize = (facesize + 1) / 2 ;
+    return facesize ;
+}
+
+FaceSizing::Policy FaceSizing::policyFromString(QString name)
+{
+    return (name.compare("matched")==0) ? MatchSource : SourceHeight ;
+}
+
+QString FaceSizing::policyString(Policy policy)
+{
+    return (policy==MatchSource) ? QString("matched") : QString("height") ;
+}
@@ -0,0 +1,76 @@
+//    PanoManager - Interactive panorama tour manager program
+//    Copyright (C) 2018  Steve M Clarke
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+//
+// Face Sizing
+//
+// Decides the size of the hi-res cube faces built from an equirectangular
+// image, and the sizes of the tile levels exported from them.
+//
+// A cube face covers 90 degrees, so matches the angular resolution of the
+// source at width / pi pixels (about 0.64 x the height).  The original
+// policy builds faces at the full height of the source, which is about 2.4x
+// the pixels the source contains, and the top level is then upsampled.
+//
+//   SourceHeight - face size = source height (the original behaviour)
+//   MatchSource  - face size = source width / pi, rounded to a multiple of the tile size
+//
+// Either is limited by an optional maximum size.  Levels halve from the face
+// size down to a single tile, which is how Pannellum derives them from its
+// cubeResolution, and the sizes Marzipano is given explicitly:
+//
+//   faceSize 2560, tileSize 256 => levels 160, 320, 640, 1280, 2560
+//
+
+#ifndef FACESIZING_H
+#define FACESIZING_H
+
+#include <QString>
+
+class FaceSizing
+{
+public:
+    typedef enum {
+        SourceHeight = 0,
+        MatchSource = 1
+    } Policy ;
+
+private:
+    Policy m_policy ;
+    int m_tileSize ;
+    int m_maxSize ;
+
+public:
+    FaceSizing(Policy policy=SourceHeight, int tileSize=256, int maxSize=0) ;
+
+    Policy policy() const ;
+    int tileSize() const ;
+    int maxSize() const ;                      // 0 if unlimited
+
+    // Size of the faces built from an equirectangular image
+    int faceSize(int sourcewidth, int sourceheight) const ;
+    int faceSize(QString sourcefile) const ;   // Reads the image's size, returns 0 if it can't be read
+
+    // Number of tile levels for a face, and the size of level 1..levels
+    int levels(int facesize) const ;
+    int levelSize(int facesize, int level) const ;
+
+    // Project settings names ("height", "matched")
+    static Policy policyFromString(QString name) ;
+    static QString policyString(Policy policy) ;
+};
+
+#endif // FACESIZING_H
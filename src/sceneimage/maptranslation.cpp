@@ -19,6 +19,7 @@
 //
 
 #include "maptranslation.h"
+#include "warmcache.h"
 #include <math.h>
 #include <QFile>
 #include <QDataStream>
@@ -233,6 +234,7 @@ MapCoordinate *MapTranslation::next()
 bool MapTranslation::end()
 {
     if (m_file.isOpen()) m_file.close() ;
+    if (m_buffer.isOpen()) m_buffer.close() ;
     m_x=0 ;
     m_y=0 ;
     m_dstxy=0 ;
@@ -249,12 +251,36 @@ PM::Err MapTranslation::openFile(int face, unsigned short srcx, unsigned short s
 
     PM::Err err = PM::Ok ;
 
-    m_file.setFileName(mapPath(face, srcx, srcy, dstxy));
-    if (!m_file.open(QIODevice::ReadOnly)) {
-        err = PM::InvalidMapTranslation ;
+    QString path = mapPath(face, srcx, srcy, dstxy) ;
+
+    if (WarmCache::isEnabled()) {
+
+        // Read the whole map into memory once, and keep it for later builds
+        QByteArray data ;
+        if (!WarmCache::findMap(path, data)) {
+            QFile file(path) ;
+            if (file.open(QIODevice::ReadOnly)) {
+                data = file.readAll() ;
+                file.close() ;
+                WarmCache::insertMap(path, data) ;
+            }
+        }
+        m_buffer.setData(data) ;
+        if (data.isEmpty() || !m_buffer.open(QIODevice::ReadOnly)) {
+            err = PM::InvalidMapTranslation ;
+        }
+        m_in.setDevice(&m_buffer) ;
+
+    } else {
+
+        m_file.setFileName(path);
+        if (!m_file.open(QIODevice::ReadOnly)) {
+            err = PM::InvalidMapTranslation ;
+        }
+        m_in.setDevice(&m_file) ;
+
     }
 
-    m_in.setDevice(&m_file) ;
     m_in >> filemagic ;
     m_in >> filesrcx ;
     m_in >> filesrcy ;
@@ -279,8 +305,10 @@ PM::Err MapTranslation::openFile(int face, unsigned short srcx, unsigned short s
     m_face = face ;
     m_fileface = fileface ;
 
-    if (err!=PM::Ok)
+    if (err!=PM::Ok) {
         if (m_file.isOpen()) m_file.close() ;
+        if (m_buffer.isOpen()) m_buffer.close() ;
+    }
 
     return err ;
 }
@@ -24,6 +24,7 @@
 #include <QObject>
 #include <QString>
 #include <QFile>
+#include <QBuffer>
 #include <QDataStream>
 #include "../errors/pmerrors.h"
 
@@ -44,8 +45,9 @@ class MapTranslation : public QObject
 private:
     bool m_abort ;
 
-    // Input files and data streams
+    // Input files and data streams (m_buffer is used when the map is held in the WarmCache)
     QFile m_file ;
+    QBuffer m_buffer ;
     QDataStream m_in ;
 
     // Characteristics of input and output images
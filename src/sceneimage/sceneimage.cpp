@@ -20,21 +20,55 @@
 
 #include "sceneimage.h"
 #include "maptranslation.h"
+#include "warmcache.h"
 #include <math.h>
 #include <QDir>
 #include <QRgb>
 #include <QFile>
+#include <QSaveFile>
 #include <QApplication>
 #include <QStandardPaths>
 #include <QPainter>
 #include <QImage>
+#include <QMutex>
+#include <QMutexLocker>
 #include "../errors/pmerrors.h"
+#include "equirectsampler.h"
+
+// Translation maps are shared cache files, so only one thread may build them at a time
+static QMutex mapBuildMutex ;
+
+// Faces are written to a temporary file and renamed into place, so another build (e.g. a
+// second build server job) never loads a half written face
+static bool saveFace(const QImage& face, QString filename)
+{
+    QSaveFile file(filename) ;
+    if (!file.open(QIODevice::WriteOnly)) return false ;
+    if (!face.save(&file, "PNG")) {
+        file.cancelWriting() ;
+        return false ;
+    }
+    return file.commit() ;
+}
+
+// Faces are cached in a folder named after the image, beside it.  The image may be
+// missing (e.g. a scene imported from a tour), in which case its path is not resolved.
+static QString faceFolder(QString imagefile)
+{
+    QFileInfo f(imagefile) ;
+    return (f.exists() ? f.canonicalPath() : f.absolutePath()) + "/" + f.baseName() ;
+}
 
 SceneImage::SceneImage() : QObject()
 {
     clear() ;
 }
 
+void SceneImage::setFaceSizing(const FaceSizing& sizing)
+{
+    m_sizing = sizing ;
+}
+
 void SceneImage::clear()
 {
     m_loadMax=0 ;
@@ -56,10 +90,9 @@ PM::Err SceneImage::loadImage(QString imagefile, bool loadpreview, bool buildpre
    emit(progressUpdate("Loading Faces ...")) ;
 
    PM::Err err = PM::Ok ;
-   QFileInfo finfo(imagefile) ;
    clear() ;
    m_filename = imagefile ;
-   m_facedir = finfo.canonicalPath() + "/" + finfo.baseName();
+   m_facedir = faceFolder(imagefile) ;
 
    bool dobuild = (!facesExist(m_filename) && !buildpreview)                        // Full Res
                 || (!previewExists(m_filename) && (loadpreview || buildpreview)) ;  // Preview
@@ -100,11 +133,10 @@ PM::Err SceneImage::loadImage(QString imagefile, bool loadpreview, bool buildpre
 
 bool SceneImage::previewExists(QString imagefile)
 {
-    QFileInfo f(imagefile) ;
     bool previewexists = true ;
 
     for (int i=0; i<6; i++) {
-        QString path = f.canonicalPath() + "/" + f.baseName() + "/face00" ;
+        QString path = faceFolder(imagefile) + "/face00" ;
         QFile f2(path + QString::number(i) + "_preview.png") ;
         if (!f2.exists() || f2.size()==0) previewexists=false ;
     }
@@ -114,12 +146,10 @@ bool SceneImage::previewExists(QString imagefile)
 
 bool SceneImage::facesExist(QString imagefile)
 {
-    QFileInfo f(imagefile) ;
-
     bool facesexist = true ;
 
     for (int i=0; i<6; i++) {
-        QString path = f.canonicalPath() + "/" + f.baseName() + "/face00" ;
+        QString path = faceFolder(imagefile) + "/face00" ;
         QFile f1(path + QString::number(i) + ".png") ;
         if (!f1.exists() || f1.size()==0) facesexist=false ;
     }
@@ -141,7 +171,17 @@ PM::Err SceneImage::loadFaces(bool loadpreview, bool scaleforpreview)
 
         emit(progressUpdate(QString("Loading Face: ") + QString::number(f))) ;
 
-        if (m_faces[f].load(path)) {
+        QImage cached ;
+        bool loaded = false ;
+        if (WarmCache::findFace(path, cached)) {
+            m_faces[f] = cached ;
+            loaded = true ;
+        } else if (m_faces[f].load(path)) {
+            WarmCache::insertFace(path, m_faces[f]) ;
+            loaded = true ;
+        }
+
+        if (loaded) {
             int p1 = (((f*2+1)*100)/12)  ;
             emit(percentUpdate(  (m_loadPos+p1)*100 /m_loadMax )) ;
             if (scaleforpreview) {
@@ -190,6 +230,9 @@ PM::Err SceneImage::exportVerticalPreview(int width, int * sequence, QString fil
 // buildFaces will move progress bar (prog) on by 1300.
 PM::Err SceneImage::buildFaces(bool buildpreview) {
 
+    // Previews are small enough to sample directly from the source
+    if (buildpreview) return buildPreviewFaces() ;
+
     QImage scaledsource ;
 
     // Actual equirectangular file width and height
@@ -231,18 +274,12 @@ PM::Err SceneImage::buildFaces(bool buildpreview) {
         }
     }
 
-    int workingsize ;   // Size the face is generated at (3 * equirectangular image height)
-    int outputsize ;    // Size the face is output at (i.e. equirectangular image height x height)
+    int workingsize ;   // Size the face is generated at (3 * output size)
+    int outputsize ;    // Size the face is output at (see FaceSizing)
 
-    if (buildpreview) {
-        // Previews can use smaller size, and the quality is less important - speed is of the essence
-        workingsize = 512 ;
-        outputsize = 512 ;
-    } else {
-        // Use prime number for working size multiplier as better smooting achieved
-        workingsize = fileheight * 3 ;
-        outputsize = fileheight ;
-    }
+    // Use prime number for working size multiplier as better smooting achieved
+    outputsize = m_sizing.faceSize((int)filewidth, (int)fileheight) ;
+    workingsize = outputsize * 3 ;
 
     QDir dir ;
 
@@ -251,6 +288,7 @@ PM::Err SceneImage::buildFaces(bool buildpreview) {
     }
 
     MapTranslation map ;
+    QMutexLocker maplock(&mapBuildMutex) ;
 
     m_buildLoadFace=0 ;
 
@@ -269,6 +307,7 @@ PM::Err SceneImage::buildFaces(bool buildpreview) {
         m_buildLoadFace++ ;
     }
 
+    maplock.unlock() ;
 
     for (int f=0; err==PM::Ok && f<6; f++) {
 
@@ -286,7 +325,7 @@ PM::Err SceneImage::buildFaces(bool buildpreview) {
         if (err==PM::Ok) {
             emit(progressUpdate(QString("Saving Face: ") + QString::number(f)));
             face = face.scaled(outputsize, outputsize) ;
-            face.save(m_facedir + "/face00" + QString::number(f) + QString(buildpreview?"_preview.png":".png")) ;
+            if (!saveFace(face, m_facedir + "/face00" + QString::number(f) + QString(".png"))) err = PM::OutputWriteError ;
         }
 
         m_buildLoadFace++ ;
@@ -295,6 +334,50 @@ PM::Err SceneImage::buildFaces(bool buildpreview) {
     return err ;
 }
 
+// Build the 512x512 preview faces by area averaging the equirectangular image
+PM::Err SceneImage::buildPreviewFaces()
+{
+    EquirectSampler sampler ;
+
+    emit(progressUpdate(QString("Loading Equirectangular Image")));
+    if (!sampler.load(m_filename)) return PM::EquirectReadError ;
+
+    QDir dir ;
+    if (!dir.exists(m_facedir) && !dir.mkdir(m_facedir)) return PM::OutputWriteError ;
+
+    m_buildLoadFace=0 ;
+    m_buildLoadSteps=6 ;
+
+    for (int f=0; f<6; f++) {
+        if (m_abort) return PM::OperationCancelled ;
+        emit(progressUpdate(QString("Building Face: ") + QString::number(f)));
+        QImage face = sampler.face(f, 512) ;
+        if (face.isNull()) return PM::OutOfMemory ;
+        if (!saveFace(face, m_facedir + "/face00" + QString::number(f) + QString("_preview.png"))) return PM::OutputWriteError ;
+        m_buildLoadFace++ ;
+        handlePercentUpdate(0) ;
+    }
+
+    return PM::Ok ;
+}
+
+// Replace the faces with ones sampled from the source at size x size, without building
+// or saving hi-res faces
+PM::Err SceneImage::sampleFaces(EquirectSampler& sampler, int size)
+{
+    if (sampler.isNull()) return PM::InputNotDefined ;
+
+    for (int f=0; f<6; f++) {
+        if (m_abort) return PM::OperationCancelled ;
+        emit(progressUpdate(QString("Sampling Face: ") + QString::number(f) + QString(" (") +
+                            QString::number(size) + QString("x") + QString::number(size) + QString(")"))) ;
+        m_faces[f] = sampler.face(f, size) ;
+        if (m_faces[f].isNull()) return PM::OutOfMemory ;
+    }
+    m_ispreview = false ;
+    return PM::Ok ;
+}
+
 void SceneImage::handleProgressUpdate(QString message)
 {
     emit( progressUpdate(message)) ;
@@ -26,6 +26,9 @@
 #include "../errors/pmerrors.h"
 #include "../sceneimage/face.h"
 #include "maptranslation.h"
+#include "facesizing.h"
+
+class EquirectSampler ;
 
 class SceneImage : public QObject
 {
@@ -37,6 +40,7 @@ private:
     QString m_facedir ;
     Face m_faces[6] ;
     bool m_ispreview ;
+    FaceSizing m_sizing ;
 
     // Counters used to report % progress
     int m_loadMax ;
@@ -45,6 +49,7 @@ private:
     int m_buildLoadSteps ;
 
     PM::Err buildFaces(bool buildpreview=false) ;
+    PM::Err buildPreviewFaces() ;
     PM::Err loadFaces(bool loadpreview, bool scaleforpreview = true) ;
 
 public:
@@ -56,12 +61,20 @@ private:
 
 public:
     void clear() ;
+
+    // Policy for the size of the hi-res faces built by loadImage (source height by default)
+    void setFaceSizing(const FaceSizing& sizing) ;
+
     bool facesExist(QString imagefile) ;
     bool previewExists(QString imagefile) ;
 
     PM::Err loadImage(QString imagefile, bool loadpreview, bool buildpreview, bool scaleforpreview, bool buildonly) ;
     Face& getFace(int n) ;
 
+    // Replace the faces with ones sampled directly from the equirectangular image at size x size,
+    // e.g. for the low levels of a preview export, without building the hi-res faces
+    PM::Err sampleFaces(EquirectSampler& sampler, int size) ;
+
     PM::Err exportVerticalPreview(int width, int *sequence, QString filename) ;
 
 signals:
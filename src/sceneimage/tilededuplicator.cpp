@@ -0,0 +1,125 @@
+//    PanoManager - Interactive panorama tour manager program
+//    Copyright (C) 2018  Steve M Clarke
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+//
+// Tile Deduplicator
+//
+
+#include "tilededuplicator.h"
+#include "tilewriter.h"
+
+#include <QCryptographicHash>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QtGlobal>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+TileDeduplicator::TileDeduplicator()
+{
+    clear() ;
+}
+
+void TileDeduplicator::clear()
+{
+    m_tiles.clear() ;
+    m_tilesWritten = 0 ;
+    m_tilesLinked = 0 ;
+    m_bytesWritten = 0 ;
+    m_bytesSaved = 0 ;
+}
+
+QByteArray TileDeduplicator::hash(const QImage& tile)
+{
+    QCryptographicHash h(QCryptographicHash::Sha1) ;
+
+    int header[3] = { tile.width(), tile.height(), (int)tile.format() } ;
+    h.addData((const char *)header, sizeof(header)) ;
+
+    // Hash each scanline separately, as lines may be padded
+    int linebytes = (tile.width() * tile.depth() + 7) / 8 ;
+    for (int y=0; y<tile.height(); y++) {
+        h.addData((const char *)tile.constScanLine(y), linebytes) ;
+    }
+
+    return h.result() ;
+}
+
+bool TileDeduplicator::link(QByteArray hash, QString outputfile, TileWriter *writer)
+{
+    if (!m_tiles.contains(hash)) return false ;
+
+    QString existing = m_tiles.value(hash).first ;
+    qint64 size = m_tiles.value(hash).second ;
+
+    if (writer) {
+        if (!writer->link(existing, outputfile)) return false ;
+        countLinked(size) ;
+        return true ;
+    }
+
+    // Never write through an old link, as that would change the tile it points to
+    QFile::remove(outputfile) ;
+
+    if (hardLink(existing, outputfile)) {
+        countLinked(size) ;
+    } else if (QFile::copy(existing, outputfile)) {
+        countLinked(0) ;
+    } else {
+        return false ;
+    }
+
+    return true ;
+}
+
+void TileDeduplicator::add(QByteArray hash, QString outputfile, qint64 bytes)
+{
+    if (bytes<0) bytes = QFileInfo(outputfile).size() ;
+    m_tiles.insert(hash, QPair<QString, qint64>(outputfile, bytes)) ;
+    countWritten(bytes) ;
+}
+
+void TileDeduplicator::countWritten(qint64 bytes)
+{
+    m_tilesWritten++ ;
+    m_bytesWritten += bytes ;
+}
+
+void TileDeduplicator::countLinked(qint64 bytes)
+{
+    m_tilesLinked++ ;
+    m_bytesSaved += bytes ;
+}
+
+bool TileDeduplicator::hardLink(QString existing, QString newfile)
+{
+#ifdef Q_OS_WIN
+    return CreateHardLinkW((LPCWSTR)QDir::toNativeSeparators(newfile).utf16(),
+                           (LPCWSTR)QDir::toNativeSeparators(existing).utf16(), NULL) != 0 ;
+#else
+    return ::link(QFile::encodeName(existing).constData(), QFile::encodeName(newfile).constData()) == 0 ;
+#endif
+}
+
+int TileDeduplicator::tilesWritten() const { return m_tilesWritten ; }
+int TileDeduplicator::tilesLinked() const { return m_tilesLinked ; }
+qint64 TileDeduplicator::bytesWritten() const { return m_bytesWritten ; }
+qint64 TileDeduplicator::bytesSaved() const { return m_bytesSaved ; }
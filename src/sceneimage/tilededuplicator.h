@@ -0,0 +1,74 @@
+//    PanoManager - Interactive panorama tour manager program
+//    Copyright (C) 2018  Steve M Clarke
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+//
+// Tile Deduplicator
+//
+// Records a hash of the pixels of each exported tile.  When a tile with
+// identical pixels has already been written (e.g. flat sky, or the up and
+// down faces), the new tile is created as a hard link to the first copy,
+// rather than being encoded and written again.
+//
+
+#ifndef TILEDEDUPLICATOR_H
+#define TILEDEDUPLICATOR_H
+
+#include <QString>
+#include <QByteArray>
+#include <QHash>
+#include <QImage>
+#include <QPair>
+
+class TileWriter ;
+
+class TileDeduplicator
+{
+private:
+    QHash<QByteArray, QPair<QString, qint64> > m_tiles ;    // Pixel hash => first file written, size
+
+    int m_tilesWritten ;
+    int m_tilesLinked ;
+    qint64 m_bytesWritten ;
+    qint64 m_bytesSaved ;
+
+public:
+    TileDeduplicator() ;
+    void clear() ;
+
+    // Hash of the tile's size, format and pixels
+    QByteArray hash(const QImage& tile) ;
+
+    // If a tile with this hash has been written, link outputfile to it and return true.
+    // If writer is supplied, the link is made by the writer once the tile is written.
+    bool link(QByteArray hash, QString outputfile, TileWriter *writer = NULL) ;
+
+    // Record a newly written tile, of bytes size (or -1 to read the size from the file)
+    void add(QByteArray hash, QString outputfile, qint64 bytes = -1) ;
+
+    // Create newfile as a hard link to existing
+    static bool hardLink(QString existing, QString newfile) ;
+
+    // Count tiles which are stored elsewhere (e.g. in a TilePack)
+    void countWritten(qint64 bytes) ;
+    void countLinked(qint64 bytes) ;
+
+    int tilesWritten() const ;      // Tiles encoded and written
+    int tilesLinked() const ;       // Tiles linked (i.e. encode calls saved)
+    qint64 bytesWritten() const ;   // Bytes of encoded tiles written
+    qint64 bytesSaved() const ;     // Bytes not written because of links
+};
+
+#endif // TILEDEDUPLICATOR_H
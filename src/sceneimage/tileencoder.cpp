@@ -0,0 +1,289 @@
+//    PanoManager - Interactive panorama tour manager program
+//    Copyright (C) 2018  Steve M Clarke
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+//
+// Tile Encoder
+//
+
+#include "tileencoder.h"
+
+#include <QFile>
+#include <QSaveFile>
+#include <QBuffer>
+#include <QImageWriter>
+#include <QElapsedTimer>
+#include <QtGlobal>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <setjmp.h>
+#include <jpeglib.h>
+
+// Initial size of the output buffer, which grows to fit the largest tile
+#define TILEENCODER_BUFFER_SIZE (256*1024)
+
+// One in this many WebP tiles is also compressed as JPEG, to measure the saving
+#define TILEENCODER_COMPARE_INTERVAL 8
+
+struct TileEncoderState
+{
+    struct jpeg_compress_struct cinfo ;
+    struct jpeg_error_mgr jerr ;
+    jmp_buf jmp ;
+    unsigned char *buffer ;
+    unsigned long bufferSize ;
+    QByteArray webp ;
+};
+
+// libjpeg's default error handler exits the program, so return to compress() instead
+static void tileEncoderErrorExit(j_common_ptr cinfo)
+{
+    TileEncoderState *state = (TileEncoderState *)cinfo->client_data ;
+    longjmp(state->jmp, 1) ;
+}
+
+static void tileEncoderOutputMessage(j_common_ptr cinfo)
+{
+    Q_UNUSED(cinfo) ;
+}
+
+TileEncoder::TileEncoder()
+{
+    m_quality = 75 ;
+    m_subsampling = Subsample420 ;
+    m_optimize = true ;
+    m_progressive = false ;
+    clearStats() ;
+
+    m_state = new TileEncoderState ;
+    m_state->cinfo.err = jpeg_std_error(&m_state->jerr) ;
+    m_state->jerr.error_exit = tileEncoderErrorExit ;
+    m_state->jerr.output_message = tileEncoderOutputMessage ;
+    jpeg_create_compress(&m_state->cinfo) ;
+    m_state->cinfo.client_data = m_state ;
+
+    m_state->buffer = (unsigned char *)malloc(TILEENCODER_BUFFER_SIZE) ;
+    m_state->bufferSize = m_state->buffer ? TILEENCODER_BUFFER_SIZE : 0 ;
+}
+
+TileEncoder::~TileEncoder()
+{
+    jpeg_destroy_compress(&m_state->cinfo) ;
+    free(m_state->buffer) ;
+    delete m_state ;
+}
+
+void TileEncoder::setQuality(int quality)
+{
+    m_quality = qBound(1, quality, 100) ;
+}
+
+void TileEncoder::setSubsampling(Subsampling subsampling) { m_subsampling = subsampling ; }
+void TileEncoder::setOptimize(bool yes) { m_optimize = yes ; }
+void TileEncoder::setProgressive(bool yes) { m_progressive = yes ; }
+
+void TileEncoder::clearStats()
+{
+    m_tilesEncoded = 0 ;
+    m_bytesEncoded = 0 ;
+    m_encodeNs = 0 ;
+    m_compareTiles = 0 ;
+    m_compareWebpBytes = 0 ;
+    m_compareJpegBytes = 0 ;
+}
+
+int TileEncoder::tilesEncoded() const { return m_tilesEncoded ; }
+qint64 TileEncoder::bytesEncoded() const { return m_bytesEncoded ; }
+qint64 TileEncoder::encodeMs() const { return m_encodeNs / 1000000 ; }
+int TileEncoder::compareTiles() const { return m_compareTiles ; }
+qint64 TileEncoder::compareWebpBytes() const { return m_compareWebpBytes ; }
+qint64 TileEncoder::compareJpegBytes() const { return m_compareJpegBytes ; }
+
+bool TileEncoder::isWebp(QString filename)
+{
+    return filename.endsWith(QString(".webp"), Qt::CaseInsensitive) ;
+}
+
+bool TileEncoder::formatSupported(QString extension)
+{
+    QString ext = extension.toLower() ;
+    if (ext.compare("jpg")==0 || ext.compare("jpeg")==0) return true ;
+    if (ext.compare("webp")==0) {
+        // The plugin list doesn't change, so is only checked once
+        static bool webp = QImageWriter::supportedImageFormats().contains("webp") ;
+        return webp ;
+    }
+    return false ;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// compress - Encode img into the reusable output buffer
+//
+
+bool TileEncoder::compress(const QImage& img, const unsigned char **data, unsigned long *size)
+{
+    if (img.isNull()) return false ;
+
+    QElapsedTimer timer ;
+    timer.start() ;
+
+    // 32 bit pixels are passed straight to libjpeg-turbo, other formats are converted
+    QImage src ;
+    J_COLOR_SPACE colorspace = JCS_RGB ;
+    int components = 3 ;
+#ifdef JCS_EXTENSIONS
+    if (img.format()==QImage::Format_RGB32 || img.format()==QImage::Format_ARGB32) {
+        src = img ;
+        colorspace = (Q_BYTE_ORDER==Q_LITTLE_ENDIAN) ? JCS_EXT_BGRX : JCS_EXT_XRGB ;
+        components = 4 ;
+    } else
+#endif
+    {
+        src = (img.format()==QImage::Format_RGB888) ? img : img.convertToFormat(QImage::Format_RGB888) ;
+    }
+
+    struct jpeg_compress_struct *cinfo = &m_state->cinfo ;
+    unsigned char *outbuffer = m_state->buffer ;
+    unsigned long outsize = m_state->bufferSize ;
+
+    if (setjmp(m_state->jmp)) {
+        jpeg_abort_compress(cinfo) ;
+        return false ;
+    }
+
+    jpeg_mem_dest(cinfo, &outbuffer, &outsize) ;
+
+    cinfo->image_width = src.width() ;
+    cinfo->image_height = src.height() ;
+    cinfo->input_components = components ;
+    cinfo->in_color_space = colorspace ;
+    jpeg_set_defaults(cinfo) ;
+    jpeg_set_quality(cinfo, m_quality, TRUE) ;
+    cinfo->optimize_coding = m_optimize ? TRUE : FALSE ;
+    cinfo->comp_info[0].h_samp_factor = (m_subsampling==Subsample444) ? 1 : 2 ;
+    cinfo->comp_info[0].v_samp_factor = (m_subsampling==Subsample444) ? 1 : 2 ;
+    if (m_progressive) jpeg_simple_progression(cinfo) ;
+
+    jpeg_start_compress(cinfo, TRUE) ;
+    while (cinfo->next_scanline < cinfo->image_height) {
+        JSAMPROW row = (JSAMPROW)src.constScanLine(cinfo->next_scanline) ;
+        jpeg_write_scanlines(cinfo, &row, 1) ;
+    }
+    jpeg_finish_compress(cinfo) ;
+
+    // If the tile didn't fit, libjpeg allocated a bigger buffer, which is kept for the next tile
+    if (outbuffer!=m_state->buffer) {
+        free(m_state->buffer) ;
+        m_state->buffer = outbuffer ;
+        m_state->bufferSize = outsize ;
+    }
+
+    *data = outbuffer ;
+    *size = outsize ;
+
+    m_tilesEncoded++ ;
+    m_bytesEncoded += outsize ;
+    m_encodeNs += timer.nsecsElapsed() ;
+    return true ;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// compressWebp - Encode img as WebP, sampling the equivalent JPEG size
+//
+
+bool TileEncoder::compressWebp(const QImage& img, QByteArray& data)
+{
+    QElapsedTimer timer ;
+    timer.start() ;
+
+    // Opening the buffer truncates data, but keeps its allocation for the next tile
+    QBuffer buffer(&data) ;
+    buffer.open(QIODevice::WriteOnly) ;
+    QImageWriter writer(&buffer, "webp") ;
+    writer.setQuality(m_quality) ;
+    if (!writer.write(img)) return false ;
+
+    m_tilesEncoded++ ;
+    m_bytesEncoded += data.size() ;
+    m_encodeNs += timer.nsecsElapsed() ;
+
+    if ((m_tilesEncoded % TILEENCODER_COMPARE_INTERVAL)==1) {
+        const unsigned char *jpeg ;
+        unsigned long jpegsize ;
+        int tiles = m_tilesEncoded ;
+        qint64 bytes = m_bytesEncoded ;
+        qint64 ns = m_encodeNs ;
+        if (compress(img, &jpeg, &jpegsize)) {
+            m_compareTiles++ ;
+            m_compareWebpBytes += data.size() ;
+            m_compareJpegBytes += jpegsize ;
+        }
+        // The comparison isn't part of the export, so isn't counted
+        m_tilesEncoded = tiles ;
+        m_bytesEncoded = bytes ;
+        m_encodeNs = ns ;
+    }
+
+    return true ;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// encode - Encode a tile to a file or a byte array
+//
+
+bool TileEncoder::encode(const QImage& img, QString filename)
+{
+    const char *data ;
+    qint64 size ;
+
+    if (isWebp(filename)) {
+        QByteArray& webp = m_state->webp ;
+        if (!compressWebp(img, webp)) return false ;
+        data = webp.constData() ;
+        size = webp.size() ;
+    } else {
+        const unsigned char *jpeg ;
+        unsigned long jpegsize ;
+        if (!compress(img, &jpeg, &jpegsize)) return false ;
+        data = (const char *)jpeg ;
+        size = jpegsize ;
+    }
+
+    // Written to a temporary file, and renamed into place, so a tile is never left half written
+    QSaveFile file(filename) ;
+    if (!file.open(QIODevice::WriteOnly)) return false ;
+    if (file.write(data, size)!=size) {
+        file.cancelWriting() ;
+        return false ;
+    }
+    return file.commit() ;
+}
+
+bool TileEncoder::encode(const QImage& img, QString filename, QByteArray& data)
+{
+    if (isWebp(filename)) return compressWebp(img, data) ;
+
+    const unsigned char *buffer ;
+    unsigned long size ;
+    if (!compress(img, &buffer, &size)) return false ;
+
+    // Refers to the encoder's buffer rather than copying it
+    data = QByteArray::fromRawData((const char *)buffer, (int)size) ;
+    return true ;
+}
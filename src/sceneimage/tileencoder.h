@@ -0,0 +1,102 @@
+//    PanoManager - Interactive panorama tour manager program
+//    Copyright (C) 2018  Steve M Clarke
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+//
+// Tile Encoder
+//
+// Encoder for exported tiles.  JPEG tiles use libjpeg(-turbo) directly rather than
+// QImage::save.  The compressor and its output buffer are created once, and
+// reused for every tile.  32 bit images are compressed straight from their
+// scanlines, without being converted first, so tiles can be views into a
+// larger image.  The encoder holds the scratch buffers, so each thread which
+// exports tiles uses its own encoder.
+//
+// WebP tiles are written with Qt's WebP image plugin, at the same quality.
+// To report the saving, a sample of the WebP tiles is also compressed (but
+// not written) as JPEG.
+//
+
+#ifndef TILEENCODER_H
+#define TILEENCODER_H
+
+#include <QString>
+#include <QByteArray>
+#include <QImage>
+
+struct TileEncoderState ;
+
+class TileEncoder
+{
+public:
+    enum Subsampling { Subsample420, Subsample444 } ;
+
+private:
+    TileEncoderState *m_state ;
+
+    int m_quality ;
+    Subsampling m_subsampling ;
+    bool m_optimize ;
+    bool m_progressive ;
+
+    int m_tilesEncoded ;
+    qint64 m_bytesEncoded ;
+    qint64 m_encodeNs ;
+
+    int m_compareTiles ;
+    qint64 m_compareWebpBytes ;
+    qint64 m_compareJpegBytes ;
+
+    // Compress img into the reusable buffer
+    bool compress(const QImage& img, const unsigned char **data, unsigned long *size) ;
+    bool compressWebp(const QImage& img, QByteArray& data) ;
+    static bool isWebp(QString filename) ;
+
+public:
+    TileEncoder() ;
+    ~TileEncoder() ;
+
+private:
+    TileEncoder(const TileEncoder& other) ;
+    TileEncoder& operator=(const TileEncoder& rhs) ;
+
+public:
+    void setQuality(int quality) ;              // 1-100
+    void setSubsampling(Subsampling subsampling) ;
+    void setOptimize(bool yes) ;                // Optimised Huffman tables
+    void setProgressive(bool yes) ;
+
+    // Returns true if tiles with the file extension (jpg, webp) can be encoded
+    static bool formatSupported(QString extension) ;
+
+    // Encode img in the format given by the filename's extension, and write it to
+    // filename or data.  JPEG data refers to the encoder's buffer, so is only valid
+    // until the next tile is encoded.  Returns false on failure.
+    bool encode(const QImage& img, QString filename) ;
+    bool encode(const QImage& img, QString filename, QByteArray& data) ;
+
+    // Encoding statistics
+    void clearStats() ;
+    int tilesEncoded() const ;
+    qint64 bytesEncoded() const ;
+    qint64 encodeMs() const ;
+
+    // WebP versus JPEG comparison over the sampled tiles
+    int compareTiles() const ;
+    qint64 compareWebpBytes() const ;
+    qint64 compareJpegBytes() const ;
+};
+
+#endif // TILEENCODER_H
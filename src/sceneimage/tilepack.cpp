@@ -0,0 +1,176 @@
+//    PanoManager - Interactive panorama tour manager program
+//    Copyright (C) 2018  Steve M Clarke
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+//
+// Tile Pack
+//
+
+#include "tilepack.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonArray>
+
+static const char *tilePackMagic = "PMTPACK1" ;
+static const int tilePackHeaderSize = 24 ;
+
+TilePack::TilePack()
+{
+    m_pos = 0 ;
+}
+
+TilePack::~TilePack()
+{
+    discard() ;
+}
+
+QByteArray TilePack::encode64(qint64 value)
+{
+    QByteArray data ;
+    for (int i=0; i<8; i++) data.append((char)((value >> (i*8)) & 0xff)) ;
+    return data ;
+}
+
+qint64 TilePack::decode64(const QByteArray& data, int pos)
+{
+    qint64 value = 0 ;
+    for (int i=7; i>=0; i--) value = (value << 8) | (unsigned char)data.at(pos+i) ;
+    return value ;
+}
+
+bool TilePack::open(QString filename, QString root)
+{
+    m_tiles.clear() ;
+    m_blobs.clear() ;
+    m_root = root ;
+
+    QDir dir ;
+    dir.mkpath(QFileInfo(filename).absolutePath()) ;
+
+    m_file.setFileName(filename) ;
+    if (!m_file.open(QIODevice::WriteOnly)) return false ;
+
+    // Header is completed when the pack is closed
+    QByteArray header(tilePackMagic) ;
+    header.append(encode64(0)) ;
+    header.append(encode64(0)) ;
+    if (m_file.write(header)!=tilePackHeaderSize) {
+        discard() ;
+        return false ;
+    }
+    m_pos = tilePackHeaderSize ;
+    return true ;
+}
+
+bool TilePack::close()
+{
+    if (!m_file.isOpen()) return false ;
+
+    QByteArray data = QJsonDocument(directory()).toJson(QJsonDocument::Compact) ;
+
+    bool success = (m_file.write(data)==data.size()) ;
+    success &= m_file.seek(8) ;
+    success &= (m_file.write(encode64(m_pos) + encode64(data.size()))==16) ;
+
+    if (!success) {
+        m_file.cancelWriting() ;
+        m_file.commit() ;
+        return false ;
+    }
+    return m_file.commit() ;
+}
+
+void TilePack::discard()
+{
+    // Cancelled writes leave any previous pack in place
+    if (!m_file.isOpen()) return ;
+    m_file.cancelWriting() ;
+    m_file.commit() ;
+}
+
+QString TilePack::key(QString tilefile)
+{
+    QString key = QDir(m_root).relativeFilePath(tilefile) ;
+    int dot = key.lastIndexOf('.') ;
+    if (dot>key.lastIndexOf('/')) key.truncate(dot) ;
+    return key ;
+}
+
+bool TilePack::link(QByteArray hash, QString tilefile, TileDeduplicator *stats)
+{
+    if (hash.isEmpty() || !m_blobs.contains(hash)) return false ;
+    Entry entry = m_blobs.value(hash) ;
+    m_tiles.insert(key(tilefile), entry) ;
+    if (stats) stats->countLinked(entry.second) ;
+    return true ;
+}
+
+bool TilePack::add(QByteArray hash, QString tilefile, const QByteArray& data, TileDeduplicator *stats)
+{
+    if (!m_file.isOpen()) return false ;
+    if (m_file.write(data)!=data.size()) return false ;
+
+    Entry entry(m_pos, data.size()) ;
+    m_pos += data.size() ;
+    m_tiles.insert(key(tilefile), entry) ;
+    if (!hash.isEmpty()) m_blobs.insert(hash, entry) ;
+    if (stats) stats->countWritten(data.size()) ;
+    return true ;
+}
+
+QJsonObject TilePack::directory()
+{
+    QJsonObject jo_tiles ;
+    QMap<QString, Entry>::const_iterator it ;
+    for (it = m_tiles.constBegin(); it != m_tiles.constEnd(); ++it) {
+        QJsonArray ja_entry ;
+        ja_entry.append((double)it.value().first) ;
+        ja_entry.append((double)it.value().second) ;
+        jo_tiles.insert(it.key(), ja_entry) ;
+    }
+    return jo_tiles ;
+}
+
+QJsonObject TilePack::index(QString file)
+{
+    QJsonObject jo_pack ;
+    jo_pack.insert("file", file) ;
+    jo_pack.insert("tiles", directory()) ;
+    return jo_pack ;
+}
+
+QJsonObject TilePack::readIndex(QString filename, QString file)
+{
+    QJsonObject jo_pack ;
+    QFile pack(filename) ;
+    if (!pack.open(QIODevice::ReadOnly)) return jo_pack ;
+
+    QByteArray header = pack.read(tilePackHeaderSize) ;
+    if (header.size()!=tilePackHeaderSize || !header.startsWith(tilePackMagic)) return jo_pack ;
+
+    qint64 offset = decode64(header, 8) ;
+    qint64 length = decode64(header, 16) ;
+    if (offset<tilePackHeaderSize || length<=0 || offset+length>pack.size() || !pack.seek(offset)) return jo_pack ;
+
+    QJsonDocument doc = QJsonDocument::fromJson(pack.read(length)) ;
+    if (!doc.isObject()) return jo_pack ;
+
+    jo_pack.insert("file", file) ;
+    jo_pack.insert("tiles", doc.object()) ;
+    return jo_pack ;
+}
@@ -0,0 +1,98 @@
+//    PanoManager - Interactive panorama tour manager program
+//    Copyright (C) 2018  Steve M Clarke
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+//
+// Tile Pack
+//
+// Single file archive holding all of the tiles for a scene, so an export
+// writes one file per scene rather than one file (and folder) per tile.
+//
+// File layout (all integers are 64 bit little endian):
+//
+//   0   "PMTPACK1"
+//   8   Directory offset
+//   16  Directory length
+//   24  Tile data, concatenated
+//   ..  Directory: compact JSON, {"1/f/0/0":[offset,length], ...}
+//
+// Tiles are keyed by their path relative to the scene folder, without the
+// extension, so tile "<scene>/2/f/1/0.jpg" is stored as "2/f/1/0".  Identical
+// tiles share the same data.  The directory is also written into the tour
+// configuration, so the viewer can fetch tiles with HTTP range requests.
+//
+
+#ifndef TILEPACK_H
+#define TILEPACK_H
+
+#include <QString>
+#include <QByteArray>
+#include <QSaveFile>
+#include <QHash>
+#include <QMap>
+#include <QPair>
+#include <QJsonObject>
+#include "tilededuplicator.h"
+
+class TilePack
+{
+private:
+    typedef QPair<qint64, qint64> Entry ;   // offset, length
+
+    QSaveFile m_file ;     // Only replaces any existing pack once complete
+    QString m_root ;
+    qint64 m_pos ;
+    QMap<QString, Entry> m_tiles ;          // Tile key => entry
+    QHash<QByteArray, Entry> m_blobs ;      // Pixel hash => entry
+
+    QJsonObject directory() ;
+    static QByteArray encode64(qint64 value) ;
+    static qint64 decode64(const QByteArray& data, int pos) ;
+
+public:
+    TilePack() ;
+    ~TilePack() ;
+
+private:
+    TilePack(const TilePack& other) ;
+    TilePack& operator=(const TilePack& rhs) ;
+
+public:
+    // Create filename, holding tiles from the root folder
+    bool open(QString filename, QString root) ;
+
+    // Write the directory and close the file.  Returns false if the pack could not be completed
+    bool close() ;
+
+    // Remove a partially written pack
+    void discard() ;
+
+    // Key for a tile filename
+    QString key(QString tilefile) ;
+
+    // If a tile with this hash is already in the pack, reference it from tilefile and return true
+    bool link(QByteArray hash, QString tilefile, TileDeduplicator *stats) ;
+
+    // Append an encoded tile
+    bool add(QByteArray hash, QString tilefile, const QByteArray& data, TileDeduplicator *stats) ;
+
+    // Tour configuration entry for the pack, {"file":file,"tiles":{...}}
+    QJsonObject index(QString file) ;
+
+    // Read the directory of an existing pack, in the same form as index()
+    static QJsonObject readIndex(QString filename, QString file) ;
+};
+
+#endif // TILEPACK_H
@@ -0,0 +1,212 @@
+//    PanoManager - Interactive panorama tour manager program
+//    Copyright (C) 2018  Steve M Clarke
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+//
+// Tile Writer
+//
+
+#include "tilewriter.h"
+#include "tilededuplicator.h"
+
+#include <QRunnable>
+#include <QThread>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QFile>
+#include <QtGlobal>
+
+// Maximum number of writer threads, beyond which a disk gains nothing
+#define TILEWRITER_MAX_THREADS 4
+
+class TileWriterTask : public QRunnable
+{
+private:
+    TileWriter *m_writer ;
+    QString m_filename ;
+    QString m_existing ;
+    QByteArray m_data ;
+
+public:
+    TileWriterTask(TileWriter *writer, QString filename, QString existing, QByteArray data) :
+        m_writer(writer), m_filename(filename), m_existing(existing), m_data(data) {}
+
+    void run()
+    {
+        m_writer->run(m_filename, m_existing, m_data) ;
+    }
+};
+
+TileWriter::TileWriter(int threads, int maxInFlight) : m_slots(qMax(1, maxInFlight))
+{
+    if (threads<=0) threads = qBound(1, QThread::idealThreadCount(), TILEWRITER_MAX_THREADS) ;
+    m_pool.setMaxThreadCount(threads) ;
+    m_maxInFlight = qMax(1, maxInFlight) ;
+    m_failed = false ;
+    clearStats() ;
+}
+
+TileWriter::~TileWriter()
+{
+    finish() ;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// write / link - Queue a tile, waiting for a free place if too many are in flight
+//
+
+bool TileWriter::write(QString filename, const QByteArray& data)
+{
+    // Take a deep copy, as the data may refer to the encoder's reusable buffer
+    QByteArray copy(data.constData(), data.size()) ;
+    queue(filename, QString(), copy) ;
+    QMutexLocker lock(&m_mutex) ;
+    return !m_failed ;
+}
+
+bool TileWriter::link(QString existing, QString filename)
+{
+    queue(filename, existing, QByteArray()) ;
+    QMutexLocker lock(&m_mutex) ;
+    return !m_failed ;
+}
+
+void TileWriter::queue(QString filename, QString existing, QByteArray data)
+{
+    if (!m_slots.tryAcquire()) {
+        QElapsedTimer stall ;
+        stall.start() ;
+        m_slots.acquire() ;
+        QMutexLocker lock(&m_mutex) ;
+        m_stallNs += stall.nsecsElapsed() ;
+    }
+
+    {
+        QMutexLocker lock(&m_mutex) ;
+        if (m_pending.isEmpty()) m_timer.start() ;
+        m_pending.insert(filename) ;
+    }
+
+    // Tasks start in the order they are queued, so a tile is always being written
+    // before any link to it starts waiting for it
+    m_pool.start(new TileWriterTask(this, filename, existing, data)) ;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// run - Write or link one tile, on a writer thread
+//
+
+void TileWriter::run(QString filename, QString existing, QByteArray data)
+{
+    bool ok ;
+
+    if (existing.isEmpty()) {
+
+        // Written to a temporary file, and renamed into place, so a tile is never left half written
+        QSaveFile file(filename) ;
+        ok = file.open(QIODevice::WriteOnly) ;
+        if (ok && file.write(data)!=data.size()) {
+            file.cancelWriting() ;
+            ok = false ;
+        }
+        if (ok) ok = file.commit() ;
+
+    } else {
+
+        {
+            QMutexLocker lock(&m_mutex) ;
+            while (m_pending.contains(existing)) m_written.wait(&m_mutex) ;
+        }
+
+        // Never write through an old link, as that would change the tile it points to
+        QFile::remove(filename) ;
+        ok = TileDeduplicator::hardLink(existing, filename) || QFile::copy(existing, filename) ;
+
+    }
+
+    {
+        QMutexLocker lock(&m_mutex) ;
+        m_pending.remove(filename) ;
+        if (ok) {
+            m_tilesWritten++ ;
+            m_bytesWritten += data.size() ;
+        } else {
+            m_failed = true ;
+        }
+        if (m_pending.isEmpty()) m_activeNs += m_timer.nsecsElapsed() ;
+        m_written.wakeAll() ;
+    }
+
+    m_slots.release() ;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// finish - Wait for every queued tile
+//
+
+bool TileWriter::finish()
+{
+    m_pool.waitForDone() ;
+    QMutexLocker lock(&m_mutex) ;
+    bool ok = !m_failed ;
+    m_failed = false ;
+    return ok ;
+}
+
+int TileWriter::threads() const { return m_pool.maxThreadCount() ; }
+int TileWriter::maxInFlight() const { return m_maxInFlight ; }
+
+void TileWriter::clearStats()
+{
+    QMutexLocker lock(&m_mutex) ;
+    m_tilesWritten = 0 ;
+    m_bytesWritten = 0 ;
+    m_activeNs = 0 ;
+    m_stallNs = 0 ;
+}
+
+int TileWriter::tilesWritten() const
+{
+    QMutexLocker lock(&m_mutex) ;
+    return m_tilesWritten ;
+}
+
+qint64 TileWriter::bytesWritten() const
+{
+    QMutexLocker lock(&m_mutex) ;
+    return m_bytesWritten ;
+}
+
+qint64 TileWriter::writeMs() const
+{
+    QMutexLocker lock(&m_mutex) ;
+    return m_activeNs / 1000000 ;
+}
+
+qint64 TileWriter::stallMs() const
+{
+    QMutexLocker lock(&m_mutex) ;
+    return m_stallNs / 1000000 ;
+}
+
+qint64 TileWriter::kbPerSecond() const
+{
+    QMutexLocker lock(&m_mutex) ;
+    if (m_activeNs<=0) return 0 ;
+    return (qint64)(((double)m_bytesWritten * 1000000000.0 / m_activeNs) / 1024.0) ;
+}
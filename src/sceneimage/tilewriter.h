@@ -0,0 +1,105 @@
+//    PanoManager - Interactive panorama tour manager program
+//    Copyright (C) 2018  Steve M Clarke
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+//
+// Tile Writer
+//
+// Asynchronous output stage for exported tiles.  Encoded tiles are handed to
+// a small pool of writer threads, so the encoder carries on with the next tile
+// rather than waiting for the filesystem (which matters most when exporting
+// to network shares or slow USB disks).
+//
+// The number of tiles waiting to be written is bounded, so a slow disk makes
+// the encoder wait instead of letting queued tiles fill memory.  Tiles are
+// still written via a temporary file which is renamed into place, and links
+// to a tile wait until that tile has been written.
+//
+// Errors are reported by the next write(), and by finish(), which waits for
+// all outstanding writes.
+//
+
+#ifndef TILEWRITER_H
+#define TILEWRITER_H
+
+#include <QString>
+#include <QByteArray>
+#include <QSet>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QSemaphore>
+#include <QThreadPool>
+#include <QElapsedTimer>
+
+class TileWriter
+{
+private:
+    QThreadPool m_pool ;
+    QSemaphore m_slots ;            // Free places for tiles in flight
+    int m_maxInFlight ;
+
+    mutable QMutex m_mutex ;        // Protects the members below
+    QWaitCondition m_written ;
+    QSet<QString> m_pending ;       // Files queued or being written
+    bool m_failed ;
+    int m_tilesWritten ;
+    qint64 m_bytesWritten ;
+
+    QElapsedTimer m_timer ;         // Running while tiles are in flight
+    qint64 m_activeNs ;
+    qint64 m_stallNs ;              // Time write() waited for a free place
+
+    void queue(QString filename, QString existing, QByteArray data) ;
+    void run(QString filename, QString existing, QByteArray data) ;
+
+    friend class TileWriterTask ;
+
+public:
+    // threads<=0 uses one thread per core, up to 4
+    explicit TileWriter(int threads=0, int maxInFlight=64) ;
+    ~TileWriter() ;
+
+private:
+    TileWriter(const TileWriter& other) ;
+    TileWriter& operator=(const TileWriter& rhs) ;
+
+public:
+    // Queue data to be written to filename.  The data is copied, so the caller may reuse
+    // its buffer.  Waits if too many tiles are in flight, and returns false if an
+    // earlier write has failed.
+    bool write(QString filename, const QByteArray& data) ;
+
+    // Queue filename to be created as a link to (or failing that a copy of) existing,
+    // once existing has been written
+    bool link(QString existing, QString filename) ;
+
+    // Wait for all queued tiles to be written.  Returns false if any failed, and
+    // clears the failure for the next export.
+    bool finish() ;
+
+    // Concurrency the writer was created with
+    int threads() const ;
+    int maxInFlight() const ;
+
+    // Write statistics
+    void clearStats() ;
+    int tilesWritten() const ;
+    qint64 bytesWritten() const ;
+    qint64 writeMs() const ;              // Time with tiles in flight
+    qint64 stallMs() const ;              // Time the encoder waited for the disk
+    qint64 kbPerSecond() const ;
+};
+
+#endif // TILEWRITER_H
@@ -0,0 +1,93 @@
+//    PanoManager - Interactive panorama tour manager program
+//    Copyright (C) 2018  Steve M Clarke
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+//
+// Warm Cache
+//
+
+#include "warmcache.h"
+
+#include <QCache>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QFileInfo>
+#include <QDateTime>
+
+// Costs are held in kilobytes
+static bool cacheEnabled = false ;
+static QMutex cacheMutex ;
+static QCache<QString, QByteArray> mapCache ;
+static QCache<QString, QImage> faceCache ;
+
+void WarmCache::enable(int mapMegabytes, int faceMegabytes)
+{
+    QMutexLocker lock(&cacheMutex) ;
+    mapCache.setMaxCost(mapMegabytes * 1024) ;
+    faceCache.setMaxCost(faceMegabytes * 1024) ;
+    cacheEnabled = (mapMegabytes>0 || faceMegabytes>0) ;
+}
+
+bool WarmCache::isEnabled()
+{
+    QMutexLocker lock(&cacheMutex) ;
+    return cacheEnabled ;
+}
+
+QString WarmCache::key(QString path)
+{
+    QFileInfo fi(path) ;
+    return fi.absoluteFilePath() + QString("|") +
+            QString::number(fi.size()) + QString("|") +
+            QString::number(fi.lastModified().toMSecsSinceEpoch()) ;
+}
+
+bool WarmCache::findMap(QString path, QByteArray& data)
+{
+    QString k = key(path) ;
+    QMutexLocker lock(&cacheMutex) ;
+    if (!cacheEnabled) return false ;
+    QByteArray *entry = mapCache.object(k) ;
+    if (!entry) return false ;
+    data = *entry ;
+    return true ;
+}
+
+void WarmCache::insertMap(QString path, QByteArray data)
+{
+    QString k = key(path) ;
+    QMutexLocker lock(&cacheMutex) ;
+    if (!cacheEnabled) return ;
+    mapCache.insert(k, new QByteArray(data), data.size()/1024 + 1) ;
+}
+
+bool WarmCache::findFace(QString path, QImage& image)
+{
+    QString k = key(path) ;
+    QMutexLocker lock(&cacheMutex) ;
+    if (!cacheEnabled) return false ;
+    QImage *entry = faceCache.object(k) ;
+    if (!entry) return false ;
+    image = *entry ;
+    return true ;
+}
+
+void WarmCache::insertFace(QString path, QImage image)
+{
+    QString k = key(path) ;
+    QMutexLocker lock(&cacheMutex) ;
+    if (!cacheEnabled) return ;
+    faceCache.insert(k, new QImage(image), (image.bytesPerLine() * image.height())/1024 + 1) ;
+}
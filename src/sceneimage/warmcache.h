@@ -0,0 +1,55 @@
+//    PanoManager - Interactive panorama tour manager program
+//    Copyright (C) 2018  Steve M Clarke
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+//
+// Warm Cache
+//
+// Process wide, thread safe in-memory cache of translation map files and
+// decoded face images.  The cache is disabled by default, and is enabled by
+// long running processes (e.g. the build server), so that repeated jobs do
+// not have to re-read maps or re-decode faces from disk.
+//
+// Entries are keyed on the file path, size and modification time, so a
+// rebuilt map or face is never served from a stale entry.
+//
+
+#ifndef WARMCACHE_H
+#define WARMCACHE_H
+
+#include <QString>
+#include <QByteArray>
+#include <QImage>
+
+class WarmCache
+{
+public:
+    // Enable the cache, with the maximum size of each cache in megabytes
+    static void enable(int mapMegabytes, int faceMegabytes) ;
+    static bool isEnabled() ;
+
+    // Returns true, and populates data if the map file is in the cache
+    static bool findMap(QString path, QByteArray& data) ;
+    static void insertMap(QString path, QByteArray data) ;
+
+    // Returns true, and populates image if the face file is in the cache
+    static bool findFace(QString path, QImage& image) ;
+    static void insertFace(QString path, QImage image) ;
+
+private:
+    static QString key(QString path) ;
+};
+
+#endif // WARMCACHE_H
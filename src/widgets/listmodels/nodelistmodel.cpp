@@ -0,0 +1,146 @@
+//    PanoManager - Interactive panorama tour manager program
+//    Copyright (C) 2018  Steve M Clarke
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+//
+// Node List Model
+//
+
+#include "nodelistmodel.h"
+#include "../../icons/icons.h"
+
+#include <QIcon>
+
+NodeListModel::NodeListModel(Project *project, QObject *parent) :
+    QAbstractListModel(parent), m_project(project)
+{
+    m_project->addObserver(this) ;
+}
+
+NodeListModel::~NodeListModel()
+{
+    m_project->removeObserver(this) ;
+}
+
+int NodeListModel::rowCount(const QModelIndex& parent) const
+{
+    if (parent.isValid()) return 0 ;
+    return m_project->scene(m_sceneId).nodeCount() ;
+}
+
+QVariant NodeListModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid()) return QVariant() ;
+    const Node& node = m_project->scene(m_sceneId).constNodeAt(index.row()) ;
+    if (!node.isValid()) return QVariant() ;
+
+    switch (role) {
+    case Qt::DisplayRole:
+    case Qt::EditRole:
+        return node.title() ;
+    case Qt::DecorationRole:
+        return QIcon(Icon::menuFile(node.type())) ;
+    case Qt::UserRole:
+        return QVariant::fromValue(node.id()) ;
+    default:
+        return QVariant() ;
+    }
+}
+
+void NodeListModel::setScene(Id sceneId)
+{
+    if (sceneId==m_sceneId) return ;
+    beginResetModel() ;
+    m_sceneId = sceneId ;
+
+    // Load the nodes now, as the count known before loading is wrong if they can't all be read
+    m_project->scene(m_sceneId).nodes() ;
+    endResetModel() ;
+}
+
+Id NodeListModel::sceneId() const
+{
+    return m_sceneId ;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// indexOf - Find a node's row, using the scene's index
+//
+
+QModelIndex NodeListModel::indexOf(Id nodeId) const
+{
+    int row = m_project->scene(m_sceneId).nodeIndex(nodeId) ;
+    if (row<0) return QModelIndex() ;
+    return index(row) ;
+}
+
+void NodeListModel::nodeChanged(Id nodeId)
+{
+    QModelIndex changed = indexOf(nodeId) ;
+    if (changed.isValid()) emit dataChanged(changed, changed) ;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// ProjectObserver - Rows follow the nodes of the scene being shown
+//
+
+void NodeListModel::projectResetting()
+{
+    beginResetModel() ;
+}
+
+void NodeListModel::projectReset()
+{
+    m_sceneId = Id() ;
+    endResetModel() ;
+}
+
+void NodeListModel::sceneRemoving(int row)
+{
+    if (row==m_project->sceneIndex(m_sceneId)) setScene(Id()) ;
+}
+
+void NodeListModel::nodeInserting(Id sceneId, int row)
+{
+    if (sceneId==m_sceneId) beginInsertRows(QModelIndex(), row, row) ;
+}
+
+void NodeListModel::nodeInserted(Id sceneId)
+{
+    if (sceneId==m_sceneId) endInsertRows() ;
+}
+
+void NodeListModel::nodeRemoving(Id sceneId, int row)
+{
+    if (sceneId==m_sceneId) beginRemoveRows(QModelIndex(), row, row) ;
+}
+
+void NodeListModel::nodeRemoved(Id sceneId)
+{
+    if (sceneId==m_sceneId) endRemoveRows() ;
+}
+
+// QList::move puts the row at 'to', whereas Qt wants the row it's placed before
+void NodeListModel::nodeMoving(Id sceneId, int from, int to)
+{
+    if (sceneId==m_sceneId) beginMoveRows(QModelIndex(), from, from, QModelIndex(), to>from ? to+1 : to) ;
+}
+
+void NodeListModel::nodeMoved(Id sceneId)
+{
+    if (sceneId==m_sceneId) endMoveRows() ;
+}
@@ -0,0 +1,78 @@
+//    PanoManager - Interactive panorama tour manager program
+//    Copyright (C) 2018  Steve M Clarke
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+//
+// Node List Model
+//
+// The nodes of one scene, for the node list.  Rows are read from the scene as
+// they are drawn, and the scene reports each node added, removed or moved, so
+// an edit only updates its own row.  Changes to other scenes' nodes are ignored,
+// and the list is emptied if its scene is removed.
+//
+// Each row shows the node's title and icon, and holds its id in Qt::UserRole.
+//
+
+#ifndef NODELISTMODEL_H
+#define NODELISTMODEL_H
+
+#include <QAbstractListModel>
+#include <QModelIndex>
+#include <QVariant>
+#include "../../project/project.h"
+#include "../../project/projectobserver.h"
+
+class NodeListModel : public QAbstractListModel, public ProjectObserver
+{
+    Q_OBJECT
+
+private:
+    Project *m_project ;
+    Id m_sceneId ;
+
+public:
+    explicit NodeListModel(Project *project, QObject *parent = 0) ;
+    ~NodeListModel() ;
+
+private:
+    NodeListModel(const NodeListModel& other) ;
+    NodeListModel& operator=(const NodeListModel& rhs) ;
+
+public:
+    int rowCount(const QModelIndex& parent = QModelIndex()) const ;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const ;
+
+    // Show the nodes of another scene (or none, if the id is null)
+    void setScene(Id sceneId) ;
+    Id sceneId() const ;
+
+    QModelIndex indexOf(Id nodeId) const ;
+
+    // Redraw a node's row, after its title or type has been changed
+    void nodeChanged(Id nodeId) ;
+
+    // ProjectObserver
+    void projectResetting() ;
+    void projectReset() ;
+    void sceneRemoving(int row) ;
+    void nodeInserting(Id sceneId, int row) ;
+    void nodeInserted(Id sceneId) ;
+    void nodeRemoving(Id sceneId, int row) ;
+    void nodeRemoved(Id sceneId) ;
+    void nodeMoving(Id sceneId, int from, int to) ;
+    void nodeMoved(Id sceneId) ;
+};
+
+#endif // NODELISTMODEL_H
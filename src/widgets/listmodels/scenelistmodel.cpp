@@ -0,0 +1,93 @@
+//    PanoManager - Interactive panorama tour manager program
+//    Copyright (C) 2018  Steve M Clarke
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+//
+// Scene List Model
+//
+
+#include "scenelistmodel.h"
+
+SceneListModel::SceneListModel(Project *project, QObject *parent) :
+    QAbstractListModel(parent), m_project(project)
+{
+    m_project->addObserver(this) ;
+}
+
+SceneListModel::~SceneListModel()
+{
+    m_project->removeObserver(this) ;
+}
+
+int SceneListModel::rowCount(const QModelIndex& parent) const
+{
+    if (parent.isValid()) return 0 ;
+    return m_project->sceneCount() ;
+}
+
+QVariant SceneListModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid()) return QVariant() ;
+    Scene& scene = m_project->sceneAt(index.row()) ;
+    if (!scene.isValid()) return QVariant() ;
+
+    switch (role) {
+    case Qt::DisplayRole:
+    case Qt::EditRole:
+        return scene.title() ;
+    case Qt::UserRole:
+        return QVariant::fromValue(scene.id()) ;
+    default:
+        return QVariant() ;
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// indexOf - Find a scene's row, using the project's index
+//
+
+QModelIndex SceneListModel::indexOf(Id sceneId) const
+{
+    int row = m_project->sceneIndex(sceneId) ;
+    if (row<0) return QModelIndex() ;
+    return index(row) ;
+}
+
+void SceneListModel::sceneChanged(Id sceneId)
+{
+    QModelIndex changed = indexOf(sceneId) ;
+    if (changed.isValid()) emit dataChanged(changed, changed) ;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//
+// ProjectObserver - Rows follow the project's scenes
+//
+
+void SceneListModel::projectResetting() { beginResetModel() ; }
+void SceneListModel::projectReset() { endResetModel() ; }
+void SceneListModel::sceneInserting(int row) { beginInsertRows(QModelIndex(), row, row) ; }
+void SceneListModel::sceneInserted() { endInsertRows() ; }
+void SceneListModel::sceneRemoving(int row) { beginRemoveRows(QModelIndex(), row, row) ; }
+void SceneListModel::sceneRemoved() { endRemoveRows() ; }
+
+// QList::move puts the row at 'to', whereas Qt wants the row it's placed before
+void SceneListModel::sceneMoving(int from, int to)
+{
+    beginMoveRows(QModelIndex(), from, from, QModelIndex(), to>from ? to+1 : to) ;
+}
+
+void SceneListModel::sceneMoved() { endMoveRows() ; }
@@ -0,0 +1,72 @@
+//    PanoManager - Interactive panorama tour manager program
+//    Copyright (C) 2018  Steve M Clarke
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+//
+// Scene List Model
+//
+// The project's scenes, in order, for the scenes list and the node destination
+// list.  Rows are read from the project as they are drawn, and the project
+// reports each scene added, removed or moved, so an edit only updates its own
+// row however many scenes there are.
+//
+// Each row shows the scene's title, and holds its id in Qt::UserRole.
+//
+
+#ifndef SCENELISTMODEL_H
+#define SCENELISTMODEL_H
+
+#include <QAbstractListModel>
+#include <QModelIndex>
+#include <QVariant>
+#include "../../project/project.h"
+#include "../../project/projectobserver.h"
+
+class SceneListModel : public QAbstractListModel, public ProjectObserver
+{
+    Q_OBJECT
+
+private:
+    Project *m_project ;
+
+public:
+    explicit SceneListModel(Project *project, QObject *parent = 0) ;
+    ~SceneListModel() ;
+
+private:
+    SceneListModel(const SceneListModel& other) ;
+    SceneListModel& operator=(const SceneListModel& rhs) ;
+
+public:
+    int rowCount(const QModelIndex& parent = QModelIndex()) const ;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const ;
+
+    QModelIndex indexOf(Id sceneId) const ;
+
+    // Redraw a scene's row, after its title has been changed
+    void sceneChanged(Id sceneId) ;
+
+    // ProjectObserver
+    void projectResetting() ;
+    void projectReset() ;
+    void sceneInserting(int row) ;
+    void sceneInserted() ;
+    void sceneRemoving(int row) ;
+    void sceneRemoved() ;
+    void sceneMoving(int from, int to) ;
+    void sceneMoved() ;
+};
+
+#endif // SCENELISTMODEL_H
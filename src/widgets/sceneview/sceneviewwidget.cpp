@@ -55,7 +55,7 @@ SceneViewWidget::SceneViewWidget(QWidget *parent) : QGLWidget(parent)
     m_left=NULL ; m_right=NULL ;
     m_top=NULL ; m_bottom=NULL ;
 
-    m_selection="" ;
+    m_selection = Id() ;
 
     m_nodes=NULL ;
 
@@ -95,7 +95,7 @@ bool SceneViewWidget::clearScene(bool initialisation)
     m_northOffsetLon=0 ;
     m_front=NULL ; m_right=NULL ; m_rear=NULL ;
     m_left=NULL ; m_top=NULL ; m_bottom=NULL ;
-    m_selection="" ;
+    m_selection = Id() ;
     return true ;
 }
 
@@ -104,13 +104,13 @@ bool SceneViewWidget::clearScene(bool initialisation)
 // Load the Skybox Faces
 //
 
-bool SceneViewWidget::loadScene(NodeList *nodes, Face &front, Face &right, Face &rear, Face &left, Face &top, Face &bottom, int arrivallon)
+bool SceneViewWidget::loadScene(const NodeList *nodes, Face &front, Face &right, Face &rear, Face &left, Face &top, Face &bottom, int arrivallon)
 {
     m_nodes = nodes ;
     m_lat=0.0f ;
     m_lon=0.0f ;
     m_northOffsetLon=0 ;
-    m_selection = "" ;
+    m_selection = Id() ;
 
     if (m_front) delete m_front ;
     m_front = new QOpenGLTexture(front.mirrored()) ;
@@ -232,7 +232,7 @@ void SceneViewWidget::paintGL()
             float lat = node->lat() / 1000.0f ;
             float lon = node->lon() / 1000.0f ;
             drawTexturedSquare(m_icon[icon], matrixFromLonLat(lon, lat, 19.0f, 3.0f, true)) ;
-            if (node->id().compare(m_selection)==0)
+            if (node->id()==m_selection)
                 drawTexturedSquare(m_selected, matrixFromLonLat(lon, lat , 18.99f, 3.0f, true)) ;
         }
     }
@@ -428,7 +428,7 @@ void SceneViewWidget::setNorthCompassLon(int lon)
     emit realBearingChanged(m_lat, realbearing) ;
 }
 
-void SceneViewWidget::setSelectedNode(QString selection)
+void SceneViewWidget::setSelectedNode(Id selection)
 {
     m_selection = selection ;
     updateGL() ;
@@ -61,9 +61,9 @@ public:
     ~SceneViewWidget() ;
 
     // Load nodes and skybox, select and refresh the nodes
-    bool loadScene(NodeList *nodes, Face& front, Face& right, Face& rear, Face& left, Face& top, Face& bottom, int arrivallon=0) ;
+    bool loadScene(const NodeList *nodes, Face& front, Face& right, Face& rear, Face& left, Face& top, Face& bottom, int arrivallon=0) ;
     bool clearScene(bool initialisation=false) ;
-    void setSelectedNode(QString selection) ;
+    void setSelectedNode(Id selection) ;
     void refresh() ;
 
     // lat/lon are the raw coordinates with respect to the scene skybox
@@ -124,9 +124,9 @@ private:
     QOpenGLTexture *m_selected ;
 
     // Current Scene Details & Selected Icon
-    NodeList *m_nodes ;
+    const NodeList *m_nodes ;
 
-    QString m_selection ;
+    Id m_selection ;
     int m_northOffsetLon ;
 
     // Mouse Position